@@ -58,6 +58,10 @@ public:
     virtual void streamLoop() {
         std::cout << "WARNING: using default streamLoop." << std::endl;
     }
+    virtual void stop() {
+        // Wakes readLoop() and streamLoop() and makes them return, so that their
+        // threads can be joined before the camera is deleted.
+    }
     virtual void setDir(const char *filename) {
         std::cout << "WARNING: using default setDir." << std::endl;
     }
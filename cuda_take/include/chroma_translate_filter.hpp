@@ -7,10 +7,11 @@
 
 #ifndef CHROMA_TRANSLATE_FILTER_H_
 #define CHROMA_TRANSLATE_FILTER_H_
-#include "edtinc.h"
+#include "pdv_device.h"
 #include "camera_types.h"
 #include "constants.h"
 #include <stdint.h>
+#include <cstddef>
 
 /*! \file
  * \brief A filter which converts parallel data from the camera link to a corrected image.
@@ -19,17 +20,32 @@
  * This function takes the pixel data from the chroma detector, which comes through as eight parallel pixels from each tap,
  * and distributes them evenly among the taps to re-create the actual image. Additionally, the pixels are inverted in magnitude
  * based on the raw image. 0xffff represents the maximum pixel value for the 16-bit data.
+ * \paragraph
+ *
+ * Each take_object has a filter of its own, sized for its own camera, so several pipelines may run in one process.
  */
 
-static uint16_t pic_buffer[MAX_SIZE];
-static int hardware;
-static unsigned int frHeight;
-static unsigned int frWidth;
-static unsigned int num_taps;
-static unsigned int MAX_VAL;
+class chroma_translate_filter
+{
+public:
+    chroma_translate_filter() {}
+    ~chroma_translate_filter();
+    chroma_translate_filter(const chroma_translate_filter &) = delete;
+    chroma_translate_filter &operator=(const chroma_translate_filter &) = delete;
+
+    void setup_filter(camera_t camera_type);
+    void setup_filter(unsigned int frHeight, unsigned int frWidth);
+    uint16_t * apply_chroma_translate_filter(uint16_t * picture);
 
-void setup_filter(camera_t camera_type);
-void setup_filter(unsigned int frHeight, unsigned int frWidth);
-uint16_t * apply_chroma_translate_filter(uint16_t * picture);
+private:
+    // The working buffer is sized by setup_filter from the frame geometry.
+    uint16_t *pic_buffer = NULL;
+    int hardware = 0;
+    unsigned int frHeight = 0;
+    unsigned int frWidth = 0;
+    unsigned int num_taps = 0;
+    unsigned int MAX_VAL = 0;
+    void resize_buffer(unsigned int h, unsigned int w);
+};
 
 #endif /* CHROMA_TRANSLATE_FILTER_H_ */
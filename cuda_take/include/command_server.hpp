@@ -0,0 +1,72 @@
+#ifndef COMMAND_SERVER_HPP
+#define COMMAND_SERVER_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+
+#include "take_object.hpp"
+#include "remote_commands.h"
+
+/*! \file
+ * \brief The remote command protocol of LiveView's saveServer, without Qt.
+ * \paragraph
+ *
+ * take_daemon answers the same commands on the same port as the saveServer in LiveView, so the clients which
+ * start and stop recordings and poll the status work with either. Each message is a big endian quint16 with the
+ * number of bytes that follow, then the quint16 command and its arguments, in the encoding of QDataStream version
+ * Qt_4_0: integers are big endian, and a QString is a quint32 byte count (0xffffffff for a null string) followed
+ * by that many bytes of UTF-16. The replies are those of saveServer, field for field, and the command codes are
+ * shared with it in remote_commands.h.
+ * \paragraph
+ *
+ * One client is served at a time; a new connection replaces the current one, as it does in saveServer. The server
+ * runs on its own thread, which waits in poll() and so costs nothing between commands.
+ */
+
+class command_server
+{
+public:
+    explicit command_server(take_object *to);
+    ~command_server();
+    command_server(const command_server &) = delete;
+    command_server &operator=(const command_server &) = delete;
+
+    bool start(const char *address, uint16_t port);
+    void stop();
+
+    // Where START_FLIGHT_SAVING records, as <dataLocation>/<namePrefix>YYYYMMDDtHHMMSS_raw (UTC):
+    void setFlightNaming(const std::string &dataLocation, const std::string &namePrefix);
+    std::string flightFilename();
+
+private:
+    take_object *to;
+    int listenFd = -1;
+    int clientFd = -1;
+    int wakeFd = -1; // eventfd, written by stop()
+    std::thread serverThread;
+    std::vector<uint8_t> received;
+
+    std::mutex namingLock;
+    std::string dataLocation;
+    std::string namePrefix;
+
+    std::string fname; // the last file recorded to, for CMD_STATUS_EXTENDED
+    uint16_t navgs = 1;
+
+    void serverLoop();
+    void acceptClient();
+    void readClient();
+    void closeClient();
+    bool handleCommand(const uint8_t *message, size_t length);
+    void reply(const std::vector<uint8_t> &block);
+    bool checkValues(uint16_t framesToSaveCount, size_t filenameLength, uint16_t naverages);
+    uint16_t framesPerSecond();
+
+    void statusMessage(const std::string &message);
+    void errorMessage(const std::string &message);
+};
+
+#endif // COMMAND_SERVER_HPP
@@ -4,20 +4,39 @@
 /*! \file
  * \brief Specifies the constants for hardware and memory allocation.
  *
- * These settings are tuned for the hardware used by the AVIRIS lab. New frame geometry must be specified here. Additionally,
- * depending on system requirements, the memory allocation sizes may need to be adjusted.
+ * These settings are tuned for the hardware used by the AVIRIS lab. Frame geometry is not set here, every frame-sized
+ * buffer is allocated from the geometry found by take_object::start(). Depending on system requirements, the memory
+ * allocation sizes may need to be adjusted.
  */
 
-const static unsigned int MAX_WIDTH = 1280;
-const static unsigned int MAX_HEIGHT = 481;
 const static unsigned int TAP_WIDTH = 160;
-const static unsigned int MAX_SIZE = MAX_WIDTH*MAX_HEIGHT;
-const static unsigned int FFT_MEAN_BUFFER_LENGTH = 500;
-const static unsigned int FFT_INPUT_LENGTH = 256; // Must be 256, will fail silently otherwise
-static const unsigned int MAX_FFT_SIZE = 4096;
+const static unsigned int FFT_MEAN_BUFFER_LENGTH = 500; // default frame means kept for the PLANE_MEAN spectra, see --mean-history
+const static unsigned int FFT_INPUT_LENGTH = 256; // points in the spectrum of each frame, any even length; frame_c and fft_widget size to it
+static const unsigned int MEAN_SPECTRUM_MAX_SEGMENT = 16384; // Longest segment the MEAN_SPECTRUM command transforms, its magnitudes fill half a reply block
 static const unsigned int MAX_N = 500;
-static const unsigned int CPU_FRAME_BUFFER_SIZE = 1500; // The frame ring buffer size in number of frame_c structs
+static const unsigned int CPU_FRAME_BUFFER_SIZE = 1500; // Default frame ring depth in frame_c structs, can be changed with --ring-depth
+static const unsigned int MIN_FRAME_RING_DEPTH = 16;
+static const unsigned int RING_EAGER_FRAMES = 128; // Ring frames populated by start(), the rest are populated in the background
+static const unsigned int RING_FILL_CHUNK_FRAMES = 64; // Frames the background fill adds to the ring at a time
+static const unsigned int FRAME_MEMORY_TOUCH_THREADS = 8; // Threads faulting in each large frame region
+static const unsigned int PRODUCT_POOL_DEPTH_DEFAULT = 64; // Slots for each derived product, can be changed with --product-pool
+static const unsigned int STD_DEV_RESULT_SLOTS = 8; // Pinned std. dev. results: up to three held by LiveView's leases, one being written, the rest for other readers
+static const unsigned int PDV_MULTIBUF_DEFAULT = 64; // Number of camera link DMA buffers, can be changed with --multibufs
+static const unsigned int MAX_PDV_MULTIBUFS = 1024;
+static const unsigned int SAVE_QUEUE_DEPTH = 600; // Number of frames which may be waiting to be written to disk
+static const unsigned int FRAME_GRAPH_MAX_JOBS = 64; // Frames which may be in the frame graph at once
+static const unsigned int FRAME_GRAPH_MAX_PRODUCTS = 16; // Of those, frames still computing their derived products
+static const unsigned int FRAME_GRAPH_AUTO_THREADS = 4; // Most frame graph workers picked without --graph-threads
+static const unsigned int PRODUCT_DISPLAY_PERIOD_MS = 30; // Derived products at display rate are computed at most this often, as LiveView redraws
+static const unsigned int FRAME_GAP_HISTORY = 64; // Most recent frame counter gaps kept with their time
+static const unsigned int FRAME_CONTINUITY_RESYNC = 4; // Frames in a row behind the counter before following the new sequence
+static const unsigned int RECONFIGURE_TARGET_MS = 1000; // take_object::reconfigure() warns if switching sources takes longer
+static const unsigned int RECONFIGURE_READER_TIMEOUT_MS = 500; // Wait for readers to hand back their frames before giving up a switch
+static const unsigned int LATENCY_SHM_UPDATE_FRAMES = 100; // Frames between copies of the stage latency summary into shared memory
+static const unsigned int SYNTHETIC_RING_FRAMES = 16; // Frames between SyntheticCamera and the consumer loop
+static const unsigned int SYNTHETIC_SPIN_US = 50; // SyntheticCamera spins instead of sleeping this close to a frame's deadline
 static const unsigned int GPU_FRAME_BUFFER_SIZE = MAX_N*3/2; //1500
+static const unsigned int STD_DEV_RESYNC_FRAMES = 9000; // The CPU std. dev. window is summed afresh at least this often, see std_dev_filter_cpu.cpp
 static const unsigned int BLOCK_SIZE = 20; // This is not used by default.
 
 static const unsigned int NUMBER_OF_BINS = 1024; // For histograms
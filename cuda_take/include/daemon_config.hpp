@@ -0,0 +1,82 @@
+#ifndef DAEMON_CONFIG_HPP
+#define DAEMON_CONFIG_HPP
+
+#include <cstdint>
+#include <string>
+#include "takeoptions.h"
+
+/*! \file
+ * \brief The configuration file of take_daemon.
+ * \paragraph
+ *
+ * One "key = value" per line; blank lines and anything after a '#' are ignored. Every key is optional:
+ * \code
+ * camera = pdv              # pdv, xio, rtp, rtpnextgen or synthetic
+ * width = 1280              # xio, rtp and synthetic sources; pdv takes the geometry from the board
+ * height = 481
+ * pdv_unit = 0
+ * pdv_channel = 0
+ * xio_directory = /data/xio
+ * rtp_port = 5004
+ * rtp_address = 239.1.1.1
+ * rtp_interface = eth2
+ * target_fps = 100
+ * synthetic_fps = 1000      # camera = synthetic, see syntheticcamera.hpp
+ * synthetic_pattern = ramp  # ramp or noise
+ * synthetic_sigma = 20
+ * synthetic_drop_every = 0  # drop one frame in every N on purpose
+ * std_dev = true
+ * no_gpu = false
+ * shm = true
+ * shm_name = /liveview_image
+ * instance = SWIR
+ * multibufs = 64
+ * ring_depth = 1500
+ * product_pool = 64
+ * thread_cpus = PDVCAM=2;SAVING=3
+ * thread_rtprio = PDVCAM=80
+ * mlock = false
+ * graph_threads = 4
+ * means_rate = display      # every, nth or display, see product_schedule.hpp
+ * std_dev_rate = display
+ * product_every = 10        # the n of nth
+ * mean_history = 500        # frame means kept for the PLANE_MEAN spectra
+ * fft_window = hann         # rect, hann, hamming or blackman, see fft.hpp
+ * hugepages = 2M            # 2M, 1G or none
+ * numa_node = 0
+ * dark_file = /data/dark.raw  # float32 dark mask loaded at startup
+ * data_location = /data     # where START_FLIGHT_SAVING records
+ * name_prefix = AV3
+ * server_address = 127.0.0.1
+ * server_port = 65000
+ * \endcode
+ * The strings given to takeOptionsType point into the daemon_config_t, so the take_object using its options
+ * must not outlive it.
+ */
+
+struct daemon_config_t {
+    daemon_config_t();
+    daemon_config_t(const daemon_config_t &) = delete;
+    daemon_config_t &operator=(const daemon_config_t &) = delete;
+
+    takeOptionsType options;
+
+    std::string serverAddress = "127.0.0.1";
+    uint16_t serverPort = 65000;
+    std::string dataLocation = "/tmp";
+    std::string namePrefix = "AV3";
+    std::string darkFile;
+
+    // Owned here, pointed at by options:
+    std::string rtpAddress;
+    std::string rtpInterface;
+    std::string shmName;
+    std::string instanceName;
+    std::string threadCpus;
+    std::string threadPriorities;
+    std::string xioDirectory;
+};
+
+bool load_daemon_config(const char *path, daemon_config_t &config, std::string &error);
+
+#endif // DAEMON_CONFIG_HPP
@@ -11,7 +11,7 @@
 #include <stdint.h>
 #include <mutex>
 
-#include "edtinc.h"
+#include "pdv_device.h"
 #include "constants.h"
 
 /*! \file
@@ -46,17 +46,21 @@ public:
     void finish_mask_collection();
 	void load_mask(float * mask_arr);
 	float * get_mask();
+	bool mask_ready() { return mask_collected; }
+
+    dark_subtraction_filter(const dark_subtraction_filter &) = delete;
+    dark_subtraction_filter &operator=(const dark_subtraction_filter &) = delete;
 
     std::mutex mask_mutex;
 private:
-	bool mask_collected;
+	bool mask_collected = false;
 	//boost::shared_array<float> picture_out;
-	unsigned int width;
-	unsigned int height;
+	unsigned int width = 0;
+	unsigned int height = 0;
 	unsigned int averaged_samples;
 
-    double mask_accum[MAX_SIZE];
-	float mask[MAX_SIZE];
+    double *mask_accum = NULL; // sized from the frame geometry in the constructor
+	float *mask = NULL;
 
 };
 
@@ -3,30 +3,95 @@
 #define _USE_MATH_DEFINES
 #include <cmath>
 #include <complex>
+#include <memory>
+#include <vector>
 #include "constants.h"
 #ifndef FFT_H_
 #define FFT_H_
 
 /*! \file
  * \brief Calulates the fast fourier transform of a time series.
+ * \paragraph
  *
- * The FFT is calculated using the complex value of the time series, using the bit twiddling method. It is then converted back to its real
- * magnitude only.
+ * An fft_plan holds everything about a transform length that does not depend on the data: the bit reversal table
+ * and twiddle factors of a radix-2 transform, or for any other length the chirp and its spectrum, so that Bluestein's
+ * algorithm can do it as a convolution with a power of 2 transform. Plans are made once per length by fft_plan::get()
+ * and shared by every fft object, and any length may be asked for. A real series of even length n goes through a
+ * complex transform of n/2 points, its even and odd samples packed together, which is then split into the n/2+1
+ * frequencies of the real series.
+ * \paragraph
+ *
+ * The fft class is what the filters use. doRealFFT() gives the magnitudes of the first FFT_INPUT_LENGTH/2 frequencies
+ * of FFT_INPUT_LENGTH points taken from a ring buffer, as it always has. welch() averages the power of half overlapping
+ * segments of a longer series, which gives segment/2 frequencies with less noise in each than one transform of the
+ * whole series. Both multiply the series by the window of setWindow() first, and scale the result by n/sum(window),
+ * so that a sine reads the same height with any window; with the default rectangular window the magnitudes are
+ * those of the plain transform.
  */
 
-class fft {
-	std::complex<float> * CFFT;
+enum fft_window_t {
+    FFT_WINDOW_RECT = 0,
+    FFT_WINDOW_HANN = 1,
+    FFT_WINDOW_HAMMING = 2,
+    FFT_WINDOW_BLACKMAN = 3
+};
+
+const char *fft_window_name(fft_window_t window);
 
+class fft_plan {
+public:
+    static std::shared_ptr<const fft_plan> get(unsigned int n); // n > 0, made on the first call for each n
+
+    unsigned int size() const { return n; }
+    // In place, forward. work is resized as needed and may be reused between calls.
+    void transform(std::complex<float> *data, std::vector<std::complex<float> > &work) const;
+    // The n/2+1 frequencies of the real series in, n/2+1 values in out.
+    void realTransform(const float *in, std::complex<float> *out, std::vector<std::complex<float> > &work) const;
+
+private:
+    explicit fft_plan(unsigned int n);
+    void radix2(std::complex<float> *data) const;
+    void bluestein(std::complex<float> *data, std::vector<std::complex<float> > &work) const;
+
+    unsigned int n;
+    bool pow2;
+    std::vector<unsigned int> bitReverse; // radix-2: where each element goes
+    std::vector<std::complex<float> > twiddles; // radix-2: exp(-2 pi i k/n), k < n/2
+    std::shared_ptr<const fft_plan> inner; // Bluestein: the power of 2 transform of the convolution
+    std::vector<std::complex<float> > chirp; // Bluestein: exp(-pi i k^2/n), k < n
+    std::vector<std::complex<float> > chirpSpectrum; // Bluestein: transform of the conjugate chirp, over inner's size
+    std::shared_ptr<const fft_plan> half; // even n: the n/2 point transform of realTransform()
+    std::vector<std::complex<float> > realTwiddles; // even n: exp(-2 pi i k/n), k < n/2
+};
+
+class fft {
 public:
 	fft();
 	virtual ~fft();
-void doRealFFT(float * arr, unsigned int ring_head, float *fft_real_result);
 
-std::complex<float> * doFFT(float * arr, unsigned int ring_head);
-std::complex<float> * doFFT(std::complex<float> * arr, unsigned int len);
+	void setWindow(fft_window_t window);
+	fft_window_t getWindow() const { return window; }
+
+	// FFT_INPUT_LENGTH points starting at arr[ring_head], wrapping at ring_length, FFT_INPUT_LENGTH/2 magnitudes out.
+	void doRealFFT(const float * arr, unsigned int ring_head, float *fft_real_result,
+	               unsigned int ring_length = FFT_MEAN_BUFFER_LENGTH);
+	// segment/2 magnitudes out, from segments of an even length, each half overlapping the last; returns how many were
+	// averaged, 0 if the series is shorter than one segment.
+	unsigned int welch(const float *series, unsigned int length, unsigned int segment, float *magnitude);
+
+	std::complex<float> * doFFT(std::complex<float> * arr, unsigned int len); // in place, any length
 
 private:
-void bitReverseOrder(std::complex<float> * arr, unsigned int len);
+	void prepare(unsigned int len);
+
+	fft_window_t window = FFT_WINDOW_RECT;
+	std::shared_ptr<const fft_plan> plan;
+	std::vector<float> windowValues; // for plan's size, empty for the rectangular window
+	float windowGain = 1; // n / sum(window)
+	std::vector<float> segmentIn;
+	std::vector<std::complex<float> > spectrum;
+	std::vector<std::complex<float> > work;
+	std::vector<double> power;
 };
 
 #endif /* FFT_H_ */
@@ -5,10 +5,18 @@
  *      Author: nlevy
  */
 #include <atomic>
+#include <mutex>
+#include <cstdlib>
+#include <cstring>
 #include "constants.h"
+#ifndef CPU_ONLY
 #include "cuda.h"
 #include "cuda_runtime.h"
 #include "cuda_utils.cuh"
+#endif
+#include "frame_memory.hpp"
+#include "frame_pool.hpp"
+#include "frame_metadata.hpp"
 #ifndef FRAME_C_HPP_
 #define FRAME_C_HPP_
 #define HANDLE_ERROR(err) (HandleError( err, __FILE__, __LINE__ ))
@@ -18,41 +26,53 @@
 /*! \brief The data structure which contains all data for a frame.
  *
  * The memory for a frame is page-locked at the host to save time during memory transfers to the device. By defining the macro
- * USE_PINNED_MEMORY, we are specifying to use heap arrays for the raw data and standard deviation data (which is filtered on the
- * device) using a page-locked format. The GPU uses this format by default. The other memory can be allocated as static arrays.
- * This procedure is standard as defined by the CUDA manual.
+ * USE_PINNED_MEMORY, we are specifying to use heap arrays for the raw data using a page-locked format. The GPU uses this format
+ * by default. This procedure is standard as defined by the CUDA manual.
+ *
+ * A frame_c holds only its raw data. take_object::start() gives each frame of the ring a slot of one large raw pool with
+ * attach_raw(), so that the whole ring is a single huge page backed region (see frame_memory.hpp); a stand-alone frame
+ * may instead own a buffer made by allocate(). The derived
+ * products (dark subtracted data, mean profiles and FFT, raw and dark subtracted histograms, standard deviation image
+ * and histogram) live in frame_pool slots
+ * which are attached to the frame by whichever filter computes them, see frame_pool.hpp. Until then those pointers are NULL,
+ * or still point at the product of an earlier frame which used the same ring slot.
+ *
+ * Readers outside of take_object hold a frame with a lease, see take_object::acquireLatest() and frame_lease.hpp. The
+ * lease count is -1 while the camera loop is writing the slot, and the camera loop never claims a slot which is leased,
+ * so a leased frame's raw data does not change under the reader. The first lease on a frame also pins the pool slots of
+ * its products, and the last one unpins them, so frame_pool::next() leaves them alone for as long as the frame is held,
+ * see frame_pool.hpp. A product attached while the frame is leased is pinned as it is attached. A product whose slot has
+ * already gone to a newer frame by the time of the lease cannot be pinned; it belongs to that newer frame.
  */
 
 struct frame_c{
-#ifdef USE_PINNED_MEMORY
-	uint16_t * raw_data_ptr;
+	uint16_t * raw_data_ptr = NULL;
+	float * std_dev_data = NULL;
+	uint32_t * std_dev_histogram = NULL;
 
-	float * std_dev_data;
-	uint32_t * std_dev_histogram;
-#else
-	uint16_t raw_data_ptr[MAX_SIZE];
-	float std_dev_data[MAX_SIZE];
-	uint32_t std_dev_histogram[NUMBER_OF_BINS];
-#endif
+        uint16_t * image_data_ptr = NULL;
 
-        uint16_t * image_data_ptr;
-
-        float dark_subtracted_data[MAX_SIZE];
-        float vertical_mean_profile[MAX_HEIGHT]; //These can use regular C++ allocation because they do not have to deal w/cuda
-        float vertical_mean_profile_lh[MAX_HEIGHT];
-        float vertical_mean_profile_rh[MAX_HEIGHT];
-        float horizontal_mean_profile[MAX_WIDTH];
-        float fftMagnitude[FFT_INPUT_LENGTH/2];
+        float * dark_subtracted_data = NULL;
+        float * vertical_mean_profile = NULL;
+        float * vertical_mean_profile_lh = NULL;
+        float * vertical_mean_profile_rh = NULL;
+        float * horizontal_mean_profile = NULL;
+        float * fftMagnitude = NULL; // FFT_INPUT_LENGTH/2 values
+        uint32_t * raw_histogram = NULL; // NUMBER_OF_BINS bins, see log_histogram.hpp
+        uint32_t * dark_histogram = NULL;
         std::atomic_int_least8_t async_filtering_done;
         std::atomic_int_least8_t has_valid_std_dev; //1 indicates doing std. dev, 2 indicates done with std. dev
+        std::atomic_int leases; // readers holding the frame, or -1 while the camera loop writes it
+        std::atomic<uint64_t> sequence; // frame_notifier sequence number of the frame in this slot
+
+        unsigned int width = 0;
+        unsigned int height = 0; // includes any line header rows
+        frame_metadata_t metadata; // line header as sent by the instrument, see frame_metadata.hpp
 
         frame_c() {
+            leases = 0;
+            sequence = 0;
             reset();
-#ifdef USE_PINNED_MEMORY
-            HANDLE_ERROR(cudaMallocHost( (void **)&raw_data_ptr, MAX_SIZE*sizeof(uint16_t), cudaHostAllocPortable));
-            HANDLE_ERROR(cudaMallocHost( (void **)&std_dev_data, MAX_SIZE*sizeof(float), cudaHostAllocPortable));
-            HANDLE_ERROR(cudaMallocHost( (void **)&std_dev_histogram, NUMBER_OF_BINS*sizeof(uint32_t), cudaHostAllocPortable));
-#endif
         }
         void reset()
         {
@@ -60,16 +80,204 @@ struct frame_c{
             has_valid_std_dev = 0;
         }
 
+        bool lease()
+        {
+            /*! \brief Adds a reader, pinning the products for the first one. Fails while the camera loop is writing the frame. */
+            int n = leases.load(std::memory_order_relaxed);
+            while(n >= 0)
+            {
+                if(leases.compare_exchange_weak(n, n + 1, std::memory_order_acquire, std::memory_order_relaxed))
+                {
+                    std::lock_guard<std::mutex> lock(productLock);
+                    if(productReaders++ == 0)
+                    {
+                        for(unsigned int p = 0; p < PRODUCT_SLOTS; p++)
+                            pinned[p] = frame_pool::pin(productSlots[p]);
+                    }
+                    return true;
+                }
+            }
+            return false;
+        }
+        void unlease()
+        {
+            {
+                std::lock_guard<std::mutex> lock(productLock);
+                if(--productReaders == 0)
+                    unpin_products();
+            }
+            leases.fetch_sub(1, std::memory_order_release);
+        }
+        bool claim()
+        {
+            /*! \brief Takes the frame for writing by the camera loop. Fails if any reader holds it. */
+            int expected = 0;
+            return leases.compare_exchange_strong(expected, -1, std::memory_order_acquire, std::memory_order_relaxed);
+        }
+        void end_claim()
+        {
+            leases.store(0, std::memory_order_release);
+        }
 
-	~frame_c()
-	{
+        bool allocate(unsigned int frWidth, unsigned int frHeight)
+        {
+            /*! \brief Allocates the raw buffer for a frWidth x frHeight frame, releasing any prior allocation.
+             * Returns false if the memory could not be allocated. */
+            deallocate();
+            size_t numel = (size_t)frWidth * frHeight;
 #ifdef USE_PINNED_MEMORY
-		HANDLE_ERROR(cudaFreeHost(raw_data_ptr));
-		HANDLE_ERROR(cudaFreeHost(std_dev_data));
-		HANDLE_ERROR(cudaFreeHost(std_dev_histogram));
+            raw_data_ptr = (uint16_t *)frame_memory::allocate(numel*sizeof(uint16_t), true);
+#else
+            raw_data_ptr = (uint16_t *)frame_memory::allocate(numel*sizeof(uint16_t), false);
 #endif
+            if(raw_data_ptr == NULL)
+                return false;
+            ownsRaw = true;
+            image_data_ptr = raw_data_ptr;
+            width = frWidth;
+            height = frHeight;
+            return true;
+        }
+
+        void attach_raw(void *slot, unsigned int frWidth, unsigned int frHeight)
+        {
+            /*! \brief Uses a frWidth x frHeight slot owned by someone else, such as a frame_pool, as the raw buffer. */
+            deallocate();
+            raw_data_ptr = (uint16_t *)slot;
+            image_data_ptr = raw_data_ptr;
+            width = frWidth;
+            height = frHeight;
+        }
+
+        void deallocate()
+        {
+            if(ownsRaw)
+                frame_memory::release(raw_data_ptr);
+            ownsRaw = false;
+            raw_data_ptr = NULL;
+            image_data_ptr = NULL;
+            width = 0;
+            height = 0;
+        }
 
+        // Sizes of the pooled products for a frWidth x frHeight frame:
+        static size_t dark_bytes(unsigned int frWidth, unsigned int frHeight)
+        {
+            return (size_t)frWidth * frHeight * sizeof(float);
+        }
+        static size_t mean_products_bytes(unsigned int frWidth, unsigned int frHeight)
+        {
+            return 3*aligned_bytes(profile_rows(frHeight)*sizeof(float)) + aligned_bytes(frWidth*sizeof(float)) +
+                    aligned_bytes(FFT_INPUT_LENGTH/2*sizeof(float)) + 2*aligned_bytes(NUMBER_OF_BINS*sizeof(uint32_t));
+        }
+        static size_t std_dev_bytes(unsigned int frWidth, unsigned int frHeight)
+        {
+            return aligned_bytes((size_t)frWidth * frHeight * sizeof(float)) + NUMBER_OF_BINS*sizeof(uint32_t);
+        }
+
+        void attach_dark(const frame_pool::slot_t &slot)
+        {
+            dark_subtracted_data = (float *)slot.data;
+            hold_product(DARK_SLOT, slot);
+        }
+        void attach_mean_products(const frame_pool::slot_t &slot)
+        {
+            /*! \brief Points the profiles, FFT and intensity histograms at a mean_products_bytes() sized slot. */
+            char *p = (char *)slot.data;
+            size_t verticalBytes = aligned_bytes(profile_rows(height)*sizeof(float));
+            vertical_mean_profile = (float *)p; p += verticalBytes;
+            vertical_mean_profile_lh = (float *)p; p += verticalBytes;
+            vertical_mean_profile_rh = (float *)p; p += verticalBytes;
+            horizontal_mean_profile = (float *)p; p += aligned_bytes(width*sizeof(float));
+            fftMagnitude = (float *)p; p += aligned_bytes(FFT_INPUT_LENGTH/2*sizeof(float));
+            raw_histogram = (uint32_t *)p; p += aligned_bytes(NUMBER_OF_BINS*sizeof(uint32_t));
+            dark_histogram = (uint32_t *)p;
+            hold_product(MEAN_SLOT, slot);
+        }
+        void attach_std_dev(const frame_pool::slot_t &slot)
+        {
+            /*! \brief Points the standard deviation image and histogram at a std_dev_bytes() sized slot. */
+            char *p = (char *)slot.data;
+            std_dev_data = (float *)p;
+            std_dev_histogram = (uint32_t *)(p + aligned_bytes((size_t)width * height * sizeof(float)));
+            hold_product(STD_DEV_SLOT, slot);
+        }
+        // For memory which is not from a pool, such as a stand-alone frame's:
+        void attach_dark(void *slot) { attach_dark(unpooled(slot)); }
+        void attach_mean_products(void *slot) { attach_mean_products(unpooled(slot)); }
+        void attach_std_dev(void *slot) { attach_std_dev(unpooled(slot)); }
+
+        void detach_products()
+        {
+            /*! \brief Forget every product, e.g. once the pools they came from are reallocated. */
+            dark_subtracted_data = NULL;
+            vertical_mean_profile = NULL;
+            vertical_mean_profile_lh = NULL;
+            vertical_mean_profile_rh = NULL;
+            horizontal_mean_profile = NULL;
+            fftMagnitude = NULL;
+            raw_histogram = NULL;
+            dark_histogram = NULL;
+            std_dev_data = NULL;
+            std_dev_histogram = NULL;
+            {
+                std::lock_guard<std::mutex> lock(productLock);
+                unpin_products();
+                for(unsigned int p = 0; p < PRODUCT_SLOTS; p++)
+                    productSlots[p] = frame_pool::slot_t();
+            }
+            reset();
+        }
+
+	~frame_c()
+	{
+		deallocate();
 	}
+
+private:
+        bool ownsRaw = false;
+
+        // The pool slots of the products, pinned while any reader leases the frame:
+        enum { DARK_SLOT, MEAN_SLOT, STD_DEV_SLOT, PRODUCT_SLOTS };
+        std::mutex productLock; // guards the members below
+        frame_pool::slot_t productSlots[PRODUCT_SLOTS];
+        bool pinned[PRODUCT_SLOTS] = {false, false, false};
+        int productReaders = 0;
+
+        static frame_pool::slot_t unpooled(void *data)
+        {
+            frame_pool::slot_t s;
+            s.data = data;
+            return s;
+        }
+        void hold_product(unsigned int p, const frame_pool::slot_t &slot)
+        {
+            std::lock_guard<std::mutex> lock(productLock);
+            if(pinned[p])
+                frame_pool::unpin(productSlots[p]);
+            productSlots[p] = slot;
+            pinned[p] = (productReaders > 0) && frame_pool::pin(slot);
+        }
+        void unpin_products()
+        {
+            for(unsigned int p = 0; p < PRODUCT_SLOTS; p++)
+            {
+                if(pinned[p])
+                    frame_pool::unpin(productSlots[p]);
+                pinned[p] = false;
+            }
+        }
+
+        static size_t aligned_bytes(size_t bytes)
+        {
+            return (bytes + 63) & ~(size_t)63;
+        }
+        static size_t profile_rows(unsigned int frHeight)
+        {
+            // The vertical profiles feed the vertical crosshair FFT, which reads FFT_INPUT_LENGTH
+            // values, so they are never shorter than that.
+            return (frHeight > FFT_INPUT_LENGTH) ? frHeight : FFT_INPUT_LENGTH;
+        }
 };
 
 #endif /* FRAME_C_HPP_ */
@@ -0,0 +1,69 @@
+#ifndef FRAME_CONDITIONING_HPP
+#define FRAME_CONDITIONING_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+/*! \file
+ * \brief Raw-conditioning stages shared by every camera loop in take_object.
+ * \paragraph
+ *
+ * Each camera loop (pdv_loop, fileImageCopyLoop, rtpConsumeFrames) copies the arriving frame into the ring buffer,
+ * optionally applies the 2s compliment filter, and optionally inverts the pixel magnitudes. Rather than make a separate
+ * pass over the frame for each of these with a branch per pixel, condition_frame performs all of the selected stages
+ * in a single pass. The stage set is chosen by template parameters, so every instantiation has a branch-free inner loop
+ * which the compiler is free to vectorize.
+ * \paragraph
+ *
+ * Since the stages may be toggled from the preference window while frames are arriving, select_frame_conditioner
+ * returns the instantiation matching the current settings. It is a table lookup and is cheap enough to call per frame.
+ */
+
+typedef void (*frame_conditioner_t)(uint16_t *dst, const uint16_t *src, size_t numel, uint16_t invFactor);
+
+template <bool twosCompliment, bool invert>
+void condition_frame(uint16_t * __restrict__ dst, const uint16_t * __restrict__ src, size_t numel, uint16_t invFactor)
+{
+    /*! \brief Copy src into dst, applying the selected stages to each pixel.
+     * \param dst The frame_c raw_data_ptr to fill
+     * \param src The frame as delivered by the camera. Must not overlap dst.
+     * \param numel Number of pixels in the frame
+     * \param invFactor Maximum pixel magnitude, used only when inverting
+     */
+    if(!twosCompliment && !invert)
+    {
+        memcpy(dst, src, numel*sizeof(uint16_t));
+        return;
+    }
+    for(size_t i = 0; i < numel; i++)
+    {
+        uint16_t v = src[i];
+        if(twosCompliment)
+            v ^= (1<<15);
+        if(invert)
+            v = invFactor - v;
+        dst[i] = v;
+    }
+}
+
+frame_conditioner_t select_frame_conditioner(bool twosCompliment, bool invert);
+
+/*! \brief Conditions a frame and dark subtracts it in the same pass.
+ * \paragraph
+ *
+ * The fused conditioner reads the camera buffer once, and writes both the conditioned uint16 frame and the float
+ * dark subtracted frame (conditioned pixel minus mask). This replaces the separate copy, 2s compliment, inversion,
+ * and dark_subtraction_filter::update_dark_subtraction passes when a dark mask is not being collected.
+ * \paragraph
+ *
+ * AVX2 and SSE2 versions are provided along with a scalar fallback. The instruction set is determined at runtime
+ * the first time select_fused_conditioner is called, so a single binary runs on any x86-64 machine.
+ */
+typedef void (*fused_conditioner_t)(uint16_t *dst, float *darkOut, const uint16_t *src, const float *mask,
+                                    size_t numel, uint16_t invFactor);
+
+fused_conditioner_t select_fused_conditioner(bool twosCompliment, bool invert);
+const char *fused_conditioner_isa();
+
+#endif // FRAME_CONDITIONING_HPP
@@ -0,0 +1,94 @@
+#ifndef FRAME_EXECUTOR_HPP
+#define FRAME_EXECUTOR_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <pthread.h>
+
+/*! \file
+ * \brief A small work-stealing thread pool for the per-frame products, and strands to keep each product in frame order.
+ * \paragraph
+ *
+ * take_object conditions each frame on the acquisition thread, and then hands the rest of the frame's work to a
+ * frame_executor as a small graph: dark subtraction followed by the mean profiles and FFT, and alongside those the
+ * standard deviation update, the shared memory copy and the save queue push. Each worker keeps its own deque of
+ * tasks. A worker runs the newest task it queued itself first, and when it runs dry it steals the oldest task of
+ * another worker, so independent products of the same frame spread over the pool while a chain of dependent tasks
+ * tends to stay on one core. Idle workers sleep on a condition variable.
+ * \paragraph
+ *
+ * Most of the products carry state from one frame to the next (the dark mask collection, the plane mean FFT history,
+ * the GPU standard deviation window, the shared memory ring and the single-producer save queue), so each of them must
+ * see the frames one at a time and in order. A frame_strand provides that: tasks posted to the same strand run one
+ * after another in the order posted, on whichever worker is free, while different strands run in parallel.
+ * \paragraph
+ *
+ * Several take_objects may run their strands on one executor (see take_object::shareFrameGraph), so that pipelines
+ * running side by side share one set of worker threads and cores rather than each starting their own.
+ */
+
+class frame_executor
+{
+public:
+    typedef std::function<void()> task_t;
+
+    frame_executor();
+    ~frame_executor();
+    frame_executor(const frame_executor &) = delete;
+    frame_executor &operator=(const frame_executor &) = delete;
+
+    void start(unsigned int workerCount, const char *name);
+    void stop();
+    void submit(task_t task);
+
+    unsigned int size() const { return (unsigned int)workers.size(); }
+    pthread_t nativeHandle(unsigned int worker);
+    std::string threadName(unsigned int worker) const;
+    uint64_t steals() const { return stealCount.load(std::memory_order_relaxed); }
+
+private:
+    struct worker_t {
+        std::mutex lock;
+        std::deque<task_t> tasks;
+        std::thread thread;
+    };
+    std::vector<std::unique_ptr<worker_t>> workers;
+    std::string baseName;
+    std::atomic<unsigned int> nextWorker;
+    std::atomic<int> queued; // tasks submitted and not yet taken
+    std::atomic<int> sleeping;
+    std::atomic<bool> running;
+    std::atomic<uint64_t> stealCount;
+    std::mutex sleepLock;
+    std::condition_variable wake;
+
+    bool take(unsigned int self, task_t &task);
+    void workerLoop(unsigned int self);
+};
+
+class frame_strand
+{
+public:
+    explicit frame_strand(frame_executor &executor) : executor(&executor) {}
+    frame_strand(const frame_strand &) = delete;
+    frame_strand &operator=(const frame_strand &) = delete;
+
+    void post(frame_executor::task_t task);
+    void bind(frame_executor &executor);
+
+private:
+    frame_executor *executor;
+    std::mutex lock;
+    std::deque<frame_executor::task_t> pending;
+    bool active = false; // a drain() is queued or running
+    void drain();
+};
+
+#endif // FRAME_EXECUTOR_HPP
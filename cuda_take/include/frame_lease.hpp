@@ -0,0 +1,52 @@
+#ifndef FRAME_LEASE_HPP
+#define FRAME_LEASE_HPP
+
+#include "frame_c.hpp"
+
+/*! \file
+ * \brief Scoped ownership of one lease on a frame_c.
+ * \paragraph
+ *
+ * A frame_lease takes over a lease which has already been acquired, for example from take_object::acquireLatest(),
+ * and releases it when it goes out of scope. While it exists the frame's raw data cannot be overwritten by the camera
+ * loops, nor its derived products by the filters, whose pool slots the lease pins. Leases are meant to be held for the time it takes to render or copy a frame, not indefinitely: a slot which
+ * stays leased is skipped by the camera loops, so holding many of them shrinks the usable ring.
+ */
+
+class frame_lease
+{
+public:
+    frame_lease() {}
+    explicit frame_lease(frame_c *leased) : frame(leased) {}
+    ~frame_lease() { reset(); }
+
+    frame_lease(const frame_lease &) = delete;
+    frame_lease &operator=(const frame_lease &) = delete;
+    frame_lease(frame_lease &&other) : frame(other.frame) { other.frame = NULL; }
+    frame_lease &operator=(frame_lease &&other)
+    {
+        if(this != &other)
+        {
+            reset();
+            frame = other.frame;
+            other.frame = NULL;
+        }
+        return *this;
+    }
+
+    frame_c *get() const { return frame; }
+    frame_c *operator->() const { return frame; }
+    explicit operator bool() const { return frame != NULL; }
+
+    void reset()
+    {
+        if(frame != NULL)
+            frame->unlease();
+        frame = NULL;
+    }
+
+private:
+    frame_c *frame = NULL;
+};
+
+#endif // FRAME_LEASE_HPP
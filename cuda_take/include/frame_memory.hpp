@@ -0,0 +1,61 @@
+#ifndef FRAME_MEMORY_HPP
+#define FRAME_MEMORY_HPP
+
+#include <cstddef>
+#include <string>
+
+/*! \file
+ * \brief Allocation of the large frame regions: the frame ring, the product pools, the save queue and the RTP packet buffers.
+ * \paragraph
+ *
+ * These regions are hundreds of megabytes to a few gigabytes, and every frame sweeps through a new part of them. With
+ * 4 KiB pages each frame touches a few hundred pages, and so a few hundred TLB misses. allocate() backs each region
+ * with huge pages when asked to: explicit 1 GiB or 2 MiB hugetlbfs pages if the kernel has them reserved
+ * (vm.nr_hugepages, or /sys/kernel/mm/hugepages/hugepages-1048576kB/nr_hugepages), otherwise transparent huge pages
+ * via madvise(MADV_HUGEPAGE), otherwise ordinary pages. The fallback is silent per allocation; describe() reports
+ * what each kind of backing ended up holding, for the startup status messages.
+ * \paragraph
+ *
+ * On a multi-socket machine the regions should be local to the thread which fills them. When a NUMA node is set,
+ * each region is bound to it with mbind(MPOL_PREFERRED) before it is first touched, so the pages land on that node no
+ * matter which thread allocated them, and spill to other nodes rather than fail if the node is full. Every region is
+ * touched before allocate() returns, so no page faults are left for the acquisition threads. Touching is most of the
+ * cost of a large region, so regions of more than a few dozen MiB are touched by up to FRAME_MEMORY_TOUCH_THREADS
+ * threads at once.
+ * \paragraph
+ *
+ * A region which need not be ready all at once, such as the frame ring, may instead be made with reserve(), which
+ * only maps and binds it. populate() then faults in one range at a time, e.g. the first frames of the ring straight
+ * away and the rest from a background thread, and complete() registers a pinned region once all of it is in. Until
+ * then the region is ordinary pageable memory, which device copies still accept, only more slowly.
+ * \paragraph
+ *
+ * Pinned regions are made usable as targets of asynchronous device copies with cudaHostRegister rather than
+ * cudaMallocHost, since the latter does not take huge pages or a node binding. In a CPU_ONLY build there is no device,
+ * and pinned regions are locked into memory with mlock instead, or left unlocked if RLIMIT_MEMLOCK does not allow it.
+ * The policy is process wide and is set
+ * by take_object::start() before any frame memory is allocated. With several take_objects in a process, start them one
+ * after another so that each allocates its regions under its own policy.
+ */
+
+namespace frame_memory
+{
+    enum page_size_t { PAGES_NORMAL = 0, PAGES_2M, PAGES_1G };
+    enum backing_t { BACKING_HUGETLB_1G = 0, BACKING_HUGETLB_2M, BACKING_TRANSPARENT, BACKING_NORMAL, BACKING_COUNT };
+
+    void setPolicy(page_size_t pages, int numaNode);
+    page_size_t pageSize();
+    int numaNode(); // -1 when regions are not bound
+
+    void *allocate(size_t bytes, bool pinned = false);
+    void *reserve(size_t bytes, bool pinned = false);
+    void populate(void *region, size_t offset, size_t bytes);
+    bool complete(void *region);
+    void release(void *region);
+    backing_t backing(const void *region);
+
+    const char *backingName(backing_t backing);
+    std::string describe();
+}
+
+#endif // FRAME_MEMORY_HPP
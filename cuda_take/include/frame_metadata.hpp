@@ -0,0 +1,127 @@
+#ifndef FRAME_METADATA_HPP
+#define FRAME_METADATA_HPP
+
+#include <cstdint>
+#include <atomic>
+#include <mutex>
+#include "constants.h"
+#include "camera_types.h"
+
+/*! \file
+ * \brief The line header of each frame, and continuity accounting built on its frame counter.
+ * \paragraph
+ *
+ * The 6604A instruments write a line header into the first row of every frame: a 16 bit frame counter at pixel 160
+ * and the OBC (on board calibrator) status at pixel 159. Each source decodes that row once per frame, straight from
+ * the camera buffer before any conditioning, into the frame_metadata_t of the frame_c, so the values are those the
+ * instrument sent even if the 2s compliment remap, the inversion or the dark status pixel change the image.
+ * frame_metadata_decoder looks the layout up per source, and for camera link per camera type, since only the
+ * CL_6604A has the header there; the 6604B rows are all image. A source without a header decodes every frame as
+ * not valid, and its frames are counted as unchecked rather than followed. Another header only needs an entry in
+ * the table of layouts.
+ * \paragraph
+ *
+ * frame_continuity follows the counter from frame to frame on the acquisition thread. A counter one past the last is
+ * the normal case. A jump forward is a gap, and the frames skipped are counted as dropped; the same counter again is a
+ * repeated frame; a counter behind the last one is out of order. If the counter keeps running behind, the source has
+ * restarted, and the new sequence is followed from there on as a resync. The totals and a short history of the most
+ * recent gaps, with their time, may be read from any thread.
+ */
+
+enum frame_source_t {
+    FRAME_SOURCE_PDV = 0, // camera link through the EDT PDV driver
+    FRAME_SOURCE_RTPNG,   // RTP NextGen receiver
+    FRAME_SOURCE_RTP,     // RTP through gstreamer
+    FRAME_SOURCE_XIO,     // XIO files
+    FRAME_SOURCE_SYNTHETIC, // SyntheticCamera
+    FRAME_SOURCE_COUNT
+};
+
+const char *frame_source_name(frame_source_t source);
+
+struct frame_metadata_t {
+    bool valid = false; // false when the frame has no line header, e.g. a test pattern
+    uint16_t counter = 0;
+    uint16_t obcStatus = 0;
+};
+
+class frame_metadata_decoder
+{
+public:
+    explicit frame_metadata_decoder(frame_source_t source = FRAME_SOURCE_PDV, camera_t camera = CL_6604A);
+
+    void decode(const uint16_t *frame, unsigned int width, frame_metadata_t &meta) const
+    {
+        // The header pixels must fall within the first row.
+        meta.valid = hasHeader && (frame != NULL) && (width > counterPixel) && (width > statusPixel);
+        if(!meta.valid)
+            return;
+        meta.counter = frame[counterPixel];
+        meta.obcStatus = frame[statusPixel];
+    }
+    frame_source_t source() const { return src; }
+    bool headerPresent() const { return hasHeader; }
+    const char *layoutName() const { return layout; }
+
+private:
+    frame_source_t src;
+    const char *layout;
+    bool hasHeader;
+    unsigned int counterPixel;
+    unsigned int statusPixel;
+};
+
+struct frame_gap_t {
+    uint64_t time_ms = 0; // system clock, milliseconds since the epoch
+    uint64_t frame = 0;   // take_object frame count when the gap was seen
+    uint16_t expected = 0;
+    uint16_t received = 0;
+    uint32_t missing = 0;
+};
+
+struct frame_continuity_summary {
+    uint64_t checked = 0;    // frames with a line header
+    uint64_t unchecked = 0;  // frames without one
+    uint64_t dropped = 0;    // counter values skipped over
+    uint64_t repeated = 0;
+    uint64_t outOfOrder = 0;
+    uint64_t resyncs = 0;
+    uint64_t gaps = 0;       // jumps forward, each of one or more dropped frames
+    uint16_t lastCounter = 0;
+    uint16_t lastObcStatus = 0;
+    frame_gap_t lastGap;
+};
+
+class frame_continuity
+{
+public:
+    frame_continuity();
+    frame_continuity(const frame_continuity &) = delete;
+    frame_continuity &operator=(const frame_continuity &) = delete;
+
+    bool observe(const frame_metadata_t &meta, uint64_t frame);
+    void reset();
+
+    frame_continuity_summary summary() const;
+    unsigned int recentGaps(frame_gap_t *gaps, unsigned int maxGaps) const;
+
+private:
+    // Written by the acquisition thread only:
+    bool haveLast = false;
+    uint16_t last = 0;
+    unsigned int behindRun = 0;
+
+    std::atomic<uint64_t> checked;
+    std::atomic<uint64_t> unchecked;
+    std::atomic<uint64_t> dropped;
+    std::atomic<uint64_t> repeated;
+    std::atomic<uint64_t> outOfOrder;
+    std::atomic<uint64_t> resyncs;
+    std::atomic<uint64_t> gaps;
+    std::atomic<uint32_t> lastHeader; // counter in the low half, OBC status in the high half
+
+    mutable std::mutex gapLock;
+    frame_gap_t gapHistory[FRAME_GAP_HISTORY];
+};
+
+#endif // FRAME_METADATA_HPP
@@ -0,0 +1,46 @@
+#ifndef FRAME_NOTIFIER_HPP
+#define FRAME_NOTIFIER_HPP
+
+#include <cstdint>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+/*! \file
+ * \brief Sequence-numbered "new frame" notification between a producer thread and any number of waiters.
+ * \paragraph
+ *
+ * The producer calls publish() with an increasing sequence number each time a frame is ready. Consumers remember
+ * the last sequence number they handled and call wait(), which returns as soon as a newer frame has been published,
+ * or when the timeout expires. Waiting is done on a condition variable (a futex on Linux), so a waiting consumer
+ * uses no CPU, and the producer only takes the lock when somebody is actually waiting.
+ * \paragraph
+ *
+ * For event loops which multiplex file descriptors (for example a QSocketNotifier), eventFd() returns a
+ * non-blocking eventfd which becomes readable whenever a frame is published. Reading it clears it.
+ */
+
+class frame_notifier
+{
+public:
+    frame_notifier();
+    ~frame_notifier();
+
+    // Producer side:
+    void publish(uint64_t seq);
+    void wakeAll();
+
+    // Consumer side:
+    uint64_t wait(uint64_t lastSeq, unsigned int timeout_ms);
+    uint64_t sequence() const { return seq.load(std::memory_order_acquire); }
+    int eventFd();
+
+private:
+    std::atomic<uint64_t> seq;
+    std::atomic<int> waiters;
+    std::atomic<int> efd;
+    std::mutex waitMutex;
+    std::condition_variable frameReady;
+};
+
+#endif // FRAME_NOTIFIER_HPP
@@ -0,0 +1,84 @@
+#ifndef FRAME_POOL_HPP
+#define FRAME_POOL_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <memory>
+
+/*! \file
+ * \brief A small pool of equally sized buffers for the derived products of a frame.
+ * \paragraph
+ *
+ * Every frame in the ring needs its raw data, but the derived products (dark subtracted data, mean profiles and FFT,
+ * standard deviation image and histogram) are only ever read for the last few frames. Rather than give each of the
+ * ring's frames its own copy, each product has a pool of a few dozen slots. When a product is computed for a frame,
+ * the producer takes the next slot with next() and points the frame_c at it. Slots are handed out in order, so a slot
+ * is reused depth() computations later, long after the display has moved on to newer frames.
+ * \paragraph
+ *
+ * A reader holding a frame with a lease pins the slots its products are in, see frame_c::lease(), and next() passes
+ * over pinned slots, so a displayed product is never overwritten however long the lease. Each slot has one atomic word,
+ * the slot's generation in the upper half and its pins in the lower: next() only takes a slot by moving its generation
+ * on while nothing pins it, and pin() only succeeds while the generation is still the one the frame was given, so a
+ * frame whose slot has already gone to a newer frame cannot pin it. Should every slot be pinned, next() takes the
+ * oldest anyway and counts a pin overrun, rather than stall the producer.
+ * \paragraph
+ *
+ * All of the slots come from one frame_memory region made by allocate(), each starting on a cache line. Pinned pools are
+ * registered with CUDA so that they may be the target of asynchronous device copies. next() is meant for a single producer.
+ * When the pipeline is reconfigured, reuse() keeps a block whose slots are large enough for the new products rather than
+ * allocating and registering it again.
+ * \paragraph
+ *
+ * A deferred pool is only reserved by allocate(). Its slots are faulted in with populate(), a range at a time, and the
+ * block is pinned by complete() once they all are, see frame_memory::reserve(). The frame ring uses this so that its
+ * first frames are ready at once and the rest follow in the background.
+ */
+
+class frame_pool
+{
+public:
+    enum memory_t { HOST_MEMORY, PINNED_MEMORY };
+
+    // One slot as handed out by next(), which the frame keeps to pin it.
+    struct slot_t {
+        void *data = NULL;
+        std::atomic<uint64_t> *state = NULL; // NULL for memory not from a pool
+        uint32_t generation = 0;
+    };
+
+    frame_pool() {}
+    ~frame_pool();
+    frame_pool(const frame_pool &) = delete;
+    frame_pool &operator=(const frame_pool &) = delete;
+
+    bool allocate(size_t slotBytes, unsigned int depth, memory_t kind, bool deferred = false);
+    bool reuse(size_t slotBytes, unsigned int depth, memory_t kind);
+    void deallocate();
+    void populate(unsigned int first, unsigned int count);
+    bool complete();
+
+    slot_t next();
+    void *slot(unsigned int index) const;
+
+    static bool pin(const slot_t &s);
+    static void unpin(const slot_t &s);
+    uint64_t pinOverruns() const { return overruns.load(std::memory_order_relaxed); }
+
+    unsigned int depth() const { return slotCount; }
+    size_t slotBytes() const { return stride; }
+    size_t bytes() const { return stride * slotCount; }
+    const void *base() const { return block; }
+
+private:
+    char *block = NULL;
+    size_t stride = 0;
+    unsigned int slotCount = 0;
+    unsigned int head = 0;
+    memory_t kind = HOST_MEMORY;
+    std::unique_ptr<std::atomic<uint64_t>[]> states; // generation << 32 | pins, one per slot
+    std::atomic<uint64_t> overruns{0};
+};
+
+#endif // FRAME_POOL_HPP
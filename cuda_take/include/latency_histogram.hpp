@@ -0,0 +1,76 @@
+#ifndef LATENCY_HISTOGRAM_HPP
+#define LATENCY_HISTOGRAM_HPP
+
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+
+/*! \file
+ * \brief Lock-free latency histograms for each stage of the acquisition pipeline.
+ * \paragraph
+ *
+ * Each histogram uses log-linear buckets in the style of HdrHistogram: every power of two is divided into 16
+ * linear sub-buckets, so any recorded value is known to within about 6%, from 1 ns up to about 39 hours.
+ * Recording is a single relaxed atomic increment plus a compare-and-swap when a new maximum is seen. It never
+ * locks or allocates, so the acquisition threads may record every frame. Any thread may call summary() at any time.
+ * \paragraph
+ *
+ * The raw copy, 2s compliment remap and inversion are done in a single pass (see frame_conditioning.hpp), so
+ * they are timed together as LATENCY_CONDITION. Once a dark mask exists the dark subtraction is fused into that
+ * pass as well, and LATENCY_DARK_SUBTRACT then only records frames where it runs separately.
+ * \paragraph
+ *
+ * The dark subtraction, mean filter, standard deviation, shared memory and save enqueue stages are the nodes of
+ * take_object's frame graph and run on its workers. LATENCY_FRAME_GRAPH covers all of them for a frame, including
+ * any time spent queued, so comparing it with the node stages shows which product limits the frame rate.
+ */
+
+enum latency_stage_t {
+    LATENCY_CAMERA_WAIT = 0, // waiting for the camera or file reader to deliver a frame
+    LATENCY_CONDITION,       // copy, 2s compliment and inversion into the frame ring
+    LATENCY_DARK_SUBTRACT,   // dark_subtraction_filter::update, when not fused
+    LATENCY_MEAN_FILTER,     // intensity histograms and mean_filter::calculate_means, on the frame graph
+    LATENCY_SHM_PUBLISH,     // copy into the shared memory segment
+    LATENCY_SAVE_ENQUEUE,    // push onto the save queue
+    LATENCY_SAVE_WRITE,      // fwrite of one frame by the saving thread
+    LATENCY_STD_DEV,         // std_dev_filter::update_GPU_buffer, on the frame graph
+    LATENCY_FRAME_GRAPH,     // from handing a frame to the frame graph until its last node is done
+    LATENCY_STAGE_COUNT
+};
+
+const char *latency_stage_name(latency_stage_t stage);
+
+struct latency_summary {
+    uint64_t count = 0;
+    uint64_t p50_ns = 0;
+    uint64_t p99_ns = 0;
+    uint64_t p999_ns = 0;
+    uint64_t max_ns = 0;
+};
+
+class latency_histogram
+{
+public:
+    latency_histogram();
+
+    void record(uint64_t ns);
+    void record(std::chrono::steady_clock::time_point begin, std::chrono::steady_clock::time_point end)
+    {
+        record((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count());
+    }
+    latency_summary summary() const;
+    void reset();
+
+    static const unsigned int subBucketBits = 5;
+    static const unsigned int maxValueBits = 47;
+    static const unsigned int bucketCount = (maxValueBits - subBucketBits + 2) * (1u << (subBucketBits - 1));
+
+    static unsigned int bucketIndex(uint64_t ns);
+    static uint64_t bucketUpperBound(unsigned int index);
+
+private:
+    std::atomic<uint64_t> buckets[bucketCount];
+    std::atomic<uint64_t> maxValue;
+};
+
+#endif // LATENCY_HISTOGRAM_HPP
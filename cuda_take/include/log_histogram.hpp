@@ -0,0 +1,88 @@
+#ifndef LOG_HISTOGRAM_HPP
+#define LOG_HISTOGRAM_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <vector>
+#include <cstring>
+#include <math.h>
+
+#include "constants.h"
+
+/*! \file
+ * \brief Histograms over the log spaced bins of getHistogramBinValues(), for the raw, dark subtracted and standard
+ * deviation images.
+ * \paragraph
+ *
+ * Bin c holds the values above bin c-1's value up to its own, exp(c*ln(2^16)/NUMBER_OF_BINS)-1, and the last bin
+ * everything above. This is what the standard deviation kernel finds by walking the bins one at a time. Here the
+ * bin is the inverse of that spacing, ceil(log2(1+v)*NUMBER_OF_BINS/16), with a quick approximation of the logarithm,
+ * followed by one comparison either way against the table, which also absorbs the table values having been accumulated
+ * in float. The result is the same bin as the linear search, for any value, in constant time and without branching on
+ * the value. 16 bit values go through a table of the bin for each of the 65536 values instead.
+ * \paragraph
+ *
+ * count() splits the pixels across threads, each with its own histogram, and adds those up at the end. take_object
+ * counts the raw and dark subtracted histograms of each frame with products, along with the mean profiles.
+ */
+
+static std::array<float, NUMBER_OF_BINS> getHistogramBinValues()
+{
+	std::array<float,NUMBER_OF_BINS> values;
+
+    float max = log((1<<16)); // ln(2^16)
+    float increment = (max - 0)/(NUMBER_OF_BINS);
+	float acc = 0;
+	for(unsigned int i = 0; i < NUMBER_OF_BINS; i++)
+	{
+		values[i] = exp(acc)-1;
+		acc+=increment;
+	}
+	return values;
+}
+
+class log_histogram
+{
+public:
+    log_histogram();
+
+    unsigned int bin(double value) const
+    {
+        // The first bin not below value, see above. NaN and anything not above
+        // the first bin go in the first, as with the linear search.
+        if(!(value > binValues[0]))
+            return 0;
+        if(value > binValues[NUMBER_OF_BINS-2])
+            return NUMBER_OF_BINS-1;
+        // log2(1+value) from the float exponent and a cubic in the mantissa, which is
+        // within a thousandth, a fifteenth of a bin, of the exact curve.
+        float x = (float)value + 1.0f;
+        uint32_t bits;
+        memcpy(&bits, &x, sizeof(bits));
+        float e = (float)((int)(bits >> 23) - 127);
+        bits = (bits & 0x007fffff) | 0x3f800000;
+        float t;
+        memcpy(&t, &bits, sizeof(t));
+        t -= 1.0f;
+        float guess = (e + t*(1.4425449f + t*(-0.7181452f + t*0.2755908f))) * binsPerOctave + 1.0f;
+        unsigned int c = (guess < 1) ? 1 : (guess > NUMBER_OF_BINS-2) ? NUMBER_OF_BINS-2 : (unsigned int)guess;
+        c -= (value <= binValues[c-1]);
+        c += (value > binValues[c]);
+        return c;
+    }
+    unsigned int bin(uint16_t value) const { return rawBins[value]; }
+
+    // histogram must have NUMBER_OF_BINS entries, and is overwritten.
+    void count(const uint16_t *data, size_t pixels, uint32_t *histogram) const;
+    void count(const float *data, size_t pixels, uint32_t *histogram) const;
+
+    const float *values() const { return binValues.data(); }
+
+private:
+    std::array<float, NUMBER_OF_BINS> binValues;
+    float binsPerOctave; // NUMBER_OF_BINS / 16
+    std::vector<uint16_t> rawBins; // the bin of each 16 bit value
+};
+
+#endif // LOG_HISTOGRAM_HPP
@@ -3,30 +3,58 @@
 #include <cstdint>
 #include <ccomplex>
 #include <mutex>
-#include <boost/thread.hpp>
 #include <atomic>
+#include <vector>
 #include "frame_c.hpp"
 #include "fft.hpp"
 #include "constants.h"
+#include "frame_notifier.hpp"
 
 /*! \brief Calculates the mean of image data within an x and y range and performs the Fast Fourier Transform.
  * \paragraph
  *
  * The Mean Filter calculates the vertical and horizontal mean values of the data and the FFT in a separate thread from the
- * main producer loop. Each time an instance of the mean filter is called, it is opened in a new boost thread, which is deallocated
- * at the end of the calculation. The type of FFT and whether or not to use dark subtracted data is determined outside of the scope
+ * main producer loop. take_object calls update() and calculate_means() from a node of its frame graph (see frame_executor.hpp),
+ * which is that thread. The type of FFT and whether or not to use dark subtracted data is determined outside of the scope
  * of this filter, so we must pass in this information, along with the coorinates from which to perform the mean, as parameters.
  * By default, a frame mean will simply be a mean using the frame's geometry as input parameters.
+ * \paragraph
+ *
+ * The PLANE_MEAN FFT is taken over the history of frame means, which must have every frame. For frames whose profiles
+ * and FFT are not wanted, see product_schedule.hpp, ingest_mean() adds only the frame mean to that history.
+ * \paragraph
+ *
+ * calculate_means() makes one pass over the rows of the region, split across threads. Each row gives its sum for the
+ * vertical profile and adds itself into the thread's column sums for the horizontal profile, eight or sixteen pixels at
+ * a time with AVX2 where the CPU has it, and the overlay and tap profile columns are taken from it on the way. Raw
+ * pixels are summed in integers. Only the profile entries outside the region are cleared, as the region is written
+ * in full.
+ *
+ * If a frame does not reach the history at all, commit_mean() repeats the last mean in its place, so that the
+ * PLANE_MEAN FFT keeps one value per frame, and counts it in seriesSummary().
+ * \paragraph
+ *
+ * The history holds FFT_MEAN_BUFFER_LENGTH means unless setHistoryLength() asks for more. The spectrum of each frame
+ * is always taken over the newest FFT_INPUT_LENGTH of them, so a longer history costs nothing per frame;
+ * planeMeanSpectrum() makes a finer spectrum of the whole history when it is asked for, averaging half overlapping
+ * segments with fft::welch().
  *
  * FFT types are also defined in this header.
  * \author JP Ryan
  * \author Noah Levy
  */
 
-static float mean_ring_buffer[FFT_MEAN_BUFFER_LENGTH];
-static std::atomic_uint_least16_t mean_ring_buffer_head;
 enum FFT_t {PLANE_MEAN, VERT_CROSS, TAP_PROFIL};
 
+const char *mean_profiles_isa();
+
+struct mean_series_summary {
+    unsigned long frames = 0;   // means added to the PLANE_MEAN history
+    unsigned long profiled = 0; // of those, from calculate_means()
+    unsigned long meanOnly = 0; // of those, from ingest_mean()
+    unsigned long holes = 0;    // frame counts missing from the history, filled with the mean before them
+};
+
 class mean_filter {
 public:
     mean_filter(frame_c * frame,
@@ -71,38 +99,60 @@ public:
 
     // Ridiculous parameter list lol :P
 
-	void start_mean();
 	void calculate_means();
-	void wait_mean();
+	void ingest_mean(const uint16_t *raw, const float *mask, unsigned long frame_count,
+	                 int startCol, int endCol, int startRow, int endRow, int actualWidth,
+	                 int actualHeight, int cent_start, int cent_end);
+	void setNotifier(frame_notifier *notifier);
+	mean_series_summary seriesSummary() const;
+	void setHistoryLength(unsigned int length);
+	unsigned int getHistoryLength();
+	unsigned int planeMeanSpectrum(unsigned int segment, std::vector<float> &magnitude);
 
 	fft myFFT;
 
 private:
-        boost::thread mean_thread;
-        std::atomic<bool> doThreadWork;
-        std::atomic<bool> runningMF;
-        std::mutex locking_mutex;
-        void threadEntry();
-        int beginCol;
-        int width;
-        int beginRow;
-        int height;
-        int frWidth;
-        bool useDSF;
-        int FFTtype;
-        // overlay parameters:
-        int lh_start;
-        int lh_end;
-        int cent_start;
-        int cent_end;
-        int rh_start;
-        int rh_end;
+        // Everything one frame's calculation needs, as given to update():
+        struct mean_params_t {
+            frame_c *frame = NULL;
+            unsigned long frame_count = 0;
+            int beginCol = 0;
+            int width = 0;
+            int beginRow = 0;
+            int height = 0;
+            int frWidth = 0;
+            bool useDSF = false;
+            FFT_t FFTtype = PLANE_MEAN;
+            // overlay parameters:
+            int lh_start = 0;
+            int lh_end = 0;
+            int cent_start = 0;
+            int cent_end = 0;
+            int rh_start = 0;
+            int rh_end = 0;
+        };
+
+        frame_notifier *notifier = NULL; // told when a frame's means are done
+        void calculate(const mean_params_t &work);
+        unsigned int commit_mean(unsigned long frame_count, float mean, bool profiled);
+        mean_params_t next; // the frame and parameters of the last update()
 
-    float tap_profile[TAP_WIDTH*MAX_HEIGHT];
-	float frame_mean;
-	unsigned int mean_ring_buffer_fft_head;
-	unsigned long frame_count;
-	frame_c * frame;
+    float *tap_profile = NULL; // TAP_WIDTH x frame height, sized on the first frame
+    size_t tap_profile_len = 0;
+	// History of frame means for the PLANE_MEAN FFT, one per filter so that
+	// each take_object has its own:
+	std::mutex historyLock; // taken by commit_mean() and planeMeanSpectrum()
+	std::vector<float> mean_ring_buffer; // historyLength means, see setHistoryLength()
+	unsigned int historyLength = 0;
+	unsigned int historyFilled = 0; // means in the history so far, up to historyLength
+	unsigned int mean_ring_buffer_head = 0;
+	unsigned int mean_ring_buffer_fft_head = 0;
+	unsigned long lastSeriesCount = 0; // frame count of the newest mean in the history
+	bool seriesStarted = false;
+	std::atomic<unsigned long> seriesFrames;
+	std::atomic<unsigned long> seriesProfiled;
+	std::atomic<unsigned long> seriesMeanOnly;
+	std::atomic<unsigned long> seriesHoles;
 };
 
 #endif /* MEAN_FILTER_HPP */
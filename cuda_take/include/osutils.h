@@ -3,8 +3,10 @@
 
 #include <dirent.h>
 #include <sys/stat.h>
+#include <pthread.h>
 
 #include <vector>
+#include <map>
 #include <regex>
 #include <string>
 
@@ -14,6 +16,17 @@ namespace os
     void listdir(std::vector<std::string> &out, const std::string &directory);
     std::string getext(const std::string &f);
     std::string trim(const std::string &value);
+
+    // Thread placement and memory locking, for the acquisition threads.
+    // Each returns false and fills in error if the OS refused.
+    std::map<std::string, std::string> parseThreadMap(const char *spec);
+    bool parseCpuList(const std::string &list, std::vector<int> &cpus);
+    bool setThreadAffinity(pthread_t thread, const std::vector<int> &cpus, std::string &error);
+    bool setThreadRealtime(pthread_t thread, int priority, std::string &error);
+    bool lockMemory(const void *addr, size_t len, std::string &error);
+    std::string describeThreadPolicy(pthread_t thread);
+    size_t residentSetBytes();
+    int cpuNumaNode(int cpu);
 }
 
 
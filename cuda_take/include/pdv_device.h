@@ -0,0 +1,17 @@
+#ifndef PDV_DEVICE_H
+#define PDV_DEVICE_H
+
+/*! \file
+ * \brief Selects the frame grabber API used by cuda_take.
+ *
+ * The EDT PDV library is used unless PDV_SIMULATOR is defined (HARDWARE=SIMULATED in the Makefile),
+ * in which case the software stand-in in pdv_sim.h provides the same calls.
+ */
+
+#ifdef PDV_SIMULATOR
+#include "pdv_sim.h"
+#else
+#include "edtinc.h"
+#endif
+
+#endif // PDV_DEVICE_H
@@ -0,0 +1,47 @@
+#ifndef PDV_SIM_H
+#define PDV_SIM_H
+
+#include <cstdint>
+
+/*! \file
+ * \brief A software stand-in for the EDT PDV camera link API.
+ * \paragraph
+ *
+ * This provides the subset of the EDT library that take_object uses, so that the camera link acquisition path
+ * (pdv_loop) can be run and load tested on a machine without a frame grabber. Frames are emitted on a fixed
+ * schedule at the configured rate into a ring of multibuf buffers, just as the hardware does. If the caller does
+ * not keep enough images started, frames which had nowhere to go are skipped and counted as overruns.
+ * \paragraph
+ *
+ * Each frame is a diagonal ramp which moves by one pixel per frame, with the frame number stored at pixel 160,
+ * where the camera link hardware places its frame counter.
+ * \paragraph
+ *
+ * The geometry and rate can be set with pdv_sim_configure() before pdv_open_channel(), or with the
+ * environment variables PDV_SIM_WIDTH, PDV_SIM_HEIGHT, and PDV_SIM_FPS. The defaults are 640x481 at 100 FPS.
+ * A rate of 0 emits frames as quickly as they are requested.
+ */
+
+#define EDT_INTERFACE "pdv"
+
+typedef unsigned char u_char;
+struct PdvDev;
+
+// Simulator controls:
+void pdv_sim_configure(unsigned int width, unsigned int height, double fps);
+uint64_t pdv_sim_overruns(PdvDev *pdv_p);
+
+// EDT compatible calls:
+PdvDev *pdv_open_channel(const char *dev_name, int unit, int channel);
+int pdv_close(PdvDev *pdv_p);
+int pdv_get_width(PdvDev *pdv_p);
+int pdv_get_height(PdvDev *pdv_p);
+int pdv_get_dmasize(PdvDev *pdv_p);
+int pdv_multibuf(PdvDev *pdv_p, int numbufs);
+void pdv_start_image(PdvDev *pdv_p);
+void pdv_start_images(PdvDev *pdv_p, int count);
+u_char *pdv_wait_image(PdvDev *pdv_p);
+u_char *pdv_wait_last_image(PdvDev *pdv_p, int *nSkipped);
+int pdv_timeouts(PdvDev *pdv_p);
+
+#endif // PDV_SIM_H
@@ -0,0 +1,62 @@
+#ifndef PRODUCT_SCHEDULE_HPP
+#define PRODUCT_SCHEDULE_HPP
+
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+
+/*! \file
+ * \brief Which frames take_object computes a derived product for.
+ * \paragraph
+ *
+ * Displays redraw at about 30 Hz, so at high frame rates most of the derived products would never be seen. Each
+ * product has a product_schedule with one of three policies: every frame, every n-th frame (n defaults to the
+ * filter_refresh_rate given to take_object), or display rate, where a product is computed at most once every
+ * PRODUCT_DISPLAY_PERIOD_MS and only once a reader has leased a frame since the last one, so that nothing is computed
+ * while nobody is looking. The first frame after reset() is always due.
+ * \paragraph
+ *
+ * The camera loop asks due() for each frame, and calls produced() for those it computed the product for; a frame
+ * which was due but could not be computed, e.g. because the product pools were busy, leaves the next frame due.
+ * The policy may be changed from any thread while frames arrive. Frames between the computed ones still feed the
+ * histories which need every frame, the frame means of the PLANE_MEAN FFT, the dark mask being collected and the
+ * standard deviation ring, see take_object::submitFrameGraph.
+ */
+
+enum derived_product_t {
+    PRODUCT_MEANS = 0,   // mean profiles and FFT, from the dark subtracted frame, and the frame announced for display
+    PRODUCT_STD_DEV = 1, // standard deviation image and histogram
+    PRODUCT_KIND_COUNT = 2
+};
+
+enum product_policy_t {
+    PRODUCT_EVERY_FRAME = 0,
+    PRODUCT_EVERY_NTH = 1,
+    PRODUCT_DISPLAY_RATE = 2
+};
+
+class product_schedule
+{
+public:
+    product_schedule();
+
+    void setPolicy(product_policy_t policy, unsigned int every);
+    product_policy_t policy() const { return (product_policy_t)policyValue.load(std::memory_order_relaxed); }
+    unsigned int every() const { return everyValue.load(std::memory_order_relaxed); }
+    void reset();
+
+    bool due(uint64_t frameCount, std::chrono::steady_clock::time_point now,
+             std::chrono::steady_clock::time_point lastDemand) const;
+    void produced(uint64_t frameCount, std::chrono::steady_clock::time_point now);
+    uint64_t producedFrames() const { return producedCount.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<unsigned int> policyValue;
+    std::atomic<unsigned int> everyValue;
+    std::atomic<bool> havePrior;
+    std::atomic<uint64_t> lastFrame;
+    std::atomic<int64_t> lastNs; // steady_clock time of the last produced(), in ns since its epoch
+    std::atomic<uint64_t> producedCount;
+};
+
+#endif // PRODUCT_SCHEDULE_HPP
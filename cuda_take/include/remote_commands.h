@@ -0,0 +1,22 @@
+#ifndef REMOTE_COMMANDS_H
+#define REMOTE_COMMANDS_H
+
+#include <stdint.h>
+
+// The command codes of the remote recording protocol, answered by
+// saveServer in LiveView and by command_server in take_daemon.
+// A client may send the numbers without this header, so the values
+// of existing commands must never change; new ones are appended.
+
+const uint16_t CMD_START_SAVING = 2;
+const uint16_t CMD_STATUS = 3;
+const uint16_t CMD_STATUS_EXTENDED = 4;
+const uint16_t CMD_START_DARKSUB = 5;
+const uint16_t CMD_STOP_DARKSUB = 6;
+const uint16_t CMD_START_FLIGHT_SAVING = 7;
+const uint16_t CMD_STOP_SAVING = 8;
+const uint16_t CMD_LATENCY_STATS = 9;
+const uint16_t CMD_CONTINUITY_STATS = 10;
+const uint16_t CMD_MEAN_SPECTRUM = 11;
+
+#endif // REMOTE_COMMANDS_H
@@ -26,6 +26,7 @@ extern "C" {
 #include "constants.h"
 #include "rtplog.h"
 #include "takeoptions.h"
+#include "frame_notifier.hpp"
 
 // define FPS_MEAS_ACQ
 
@@ -54,6 +55,7 @@ typedef struct
     unsigned int doneFrameNumber = 0; // good frame to copy out
     uint64_t frameCounter = 0;
     uint16_t **buffer;
+    frame_notifier *notifier; // publishes frameCounter for getFrameWait
 } ProgramData;
 
 
@@ -80,6 +82,7 @@ public:
     uint16_t* getFrameWait(unsigned int lastFrameNumber, CameraModel::camStatusEnum *stat);
     uint16_t* getFrame(CameraModel::camStatusEnum *stat);
     void streamLoop(); // This should be its own thread and is effectivly the producer of image data.
+    void stop();
     virtual camControlType* getCamControlPtr();
     virtual void setCamControlPtr(camControlType* p);
 
@@ -97,6 +100,7 @@ private:
     unsigned int *doneFrameNumber = 0;
     unsigned int lastFrameDelivered = 0;
     uint64_t *frameCounter = 0;
+    frame_notifier frameNotifier;
     bool haveInitialized = false;
     bool loopRunning = false;
     bool destructorRunning = false;
@@ -30,6 +30,8 @@
 #include "constants.h"
 #include "cudalog.h"
 #include "takeoptions.h"
+#include "frame_notifier.hpp"
+#include "frame_memory.hpp"
 
 
 #define RTPNG_TIMEOUT_DURATION 100
@@ -78,6 +80,7 @@ public:
     uint16_t* getFrameWait(unsigned int lastFrameNumber, CameraModel::camStatusEnum *stat);
     uint16_t* getFrame(CameraModel::camStatusEnum *stat);
     void streamLoop(); // This should be its own thread and is effectivly the producer of image data.
+    void stop();
     virtual camControlType* getCamControlPtr();
     virtual void setCamControlPtr(camControlType* p);
 
@@ -98,6 +101,7 @@ private:
     unsigned int doneFrameNumber = 0;
     unsigned int lastFrameDelivered = 0;
     uint64_t frameCounterNetworkSocket = 0;
+    frame_notifier frameNotifier; // published with frameCounterNetworkSocket as each frame completes
     uint64_t framesDeliveredCounter = 0;
     uint64_t lagLevel = 0;
     uint64_t lagLevelPrior = 0;
@@ -122,6 +126,7 @@ private:
     size_t chunksPerFramePrior = 0;
 
     uint8_t *largePacketBuffer[networkPacketBufferFrames] = {NULL};
+    uint8_t *largePacketBlock = NULL; // one frame_memory region holding every largePacketBuffer frame
     //                        [lpbFramePos][lpbPos]
     int lpbPos = 0;
     int lpbFramePos = 0;
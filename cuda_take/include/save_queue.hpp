@@ -0,0 +1,77 @@
+#ifndef SAVE_QUEUE_HPP
+#define SAVE_QUEUE_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+/*! \file
+ * \brief A fixed-capacity single-producer/single-consumer queue of frames waiting to be written to disk.
+ * \paragraph
+ *
+ * The acquisition loop (pdv_loop, fileImageCopyLoop, rtpConsumeFrames) is the only producer and the savingLoop
+ * thread is the only consumer. All of the frame slots are allocated once by allocate(), so pushing a frame is a
+ * single memcpy into the next free slot and never touches the heap. Head and tail are atomic counters, thus the
+ * producer never takes a lock. The consumer sleeps on a condition variable while the queue is empty and is
+ * woken by the producer only when it is actually waiting.
+ * \paragraph
+ *
+ * If the writer falls behind and all of the slots are full, the incoming frame is dropped and counted rather
+ * than blocking the acquisition loop. The depth, high-water mark, and dropped frame count are available
+ * for status reporting.
+ */
+
+class save_queue
+{
+public:
+    save_queue();
+    ~save_queue();
+
+    bool allocate(size_t frameElements, unsigned int capacity);
+    bool reuse(size_t frameElements, unsigned int capacity);
+    void deallocate();
+
+    // Producer side:
+    bool push(const uint16_t *frame);
+
+    // Consumer side:
+    uint16_t *front(unsigned int timeout_ms);
+    void pop();
+    void discardAll();
+    void wake();
+
+    // Status:
+    bool empty() const;
+    unsigned int depth() const;
+    unsigned int capacity() const { return slotCount; }
+    unsigned int highWaterMark() const { return highWater.load(std::memory_order_relaxed); }
+    uint64_t droppedFrames() const { return dropped.load(std::memory_order_relaxed); }
+    const void *storage() const { return slots; }
+    size_t storageBytes() const { return frameElements * slotCount * sizeof(uint16_t); }
+    void resetStats();
+
+private:
+    uint16_t *slots = NULL;
+    size_t frameElements = 0;
+    size_t allocatedElements = 0; // of the whole allocation, which may exceed frameElements * slotCount after reuse()
+    unsigned int slotCount = 0;
+
+    // head is only written by the consumer and tail only by the producer.
+    // They are padded apart so that the two threads do not share a cache line.
+    char padA[64];
+    std::atomic<uint64_t> head;
+    char padB[64];
+    std::atomic<uint64_t> tail;
+    char padC[64];
+
+    std::atomic<unsigned int> highWater;
+    std::atomic<uint64_t> dropped;
+
+    std::mutex waitMutex;
+    std::condition_variable frameReady;
+    std::atomic<bool> consumerWaiting;
+};
+
+#endif // SAVE_QUEUE_HPP
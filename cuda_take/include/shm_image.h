@@ -6,7 +6,8 @@
 
 // This file describes the shared memory segment
 // used for images and image meta-data.
-// The segment is named "/liveview_image"
+// The segment is named "/liveview_image" unless another name is given
+// (--shm-name), as each pipeline in a process needs a segment of its own.
 // Data are processed for 2s compliment and "invertedness" and then
 // memcpy'd to the shared memory segment.
 // Data are written here whenever liveview is open.
@@ -20,6 +21,8 @@
 #define shmWidth (1280)
 #define shmFrameBufferSize (10)
 #define shmFilenameBufferSize (256)
+#define shmLatencyStageCount (9)
+#define shmGapHistoryCount (16)
 
 // Shared Memory Segment statusByte:
 #define SHM_STATUS_READY (31)
@@ -28,6 +31,50 @@
 #define SHM_STATUS_CLOSED (24)
 #define SHM_STATUS_ERROR (13)
 
+// Latency summary for one stage of the acquisition pipeline, in microseconds.
+// stageLatency[] holds shmLatencyStageCount of them, indexed as latency_stage_t
+// in cuda_take/include/latency_histogram.hpp:
+//   0 LATENCY_CAMERA_WAIT    waiting for the camera or file reader
+//   1 LATENCY_CONDITION      copy, 2s compliment and inversion (and the dark subtraction once fused)
+//   2 LATENCY_DARK_SUBTRACT  dark subtraction, when not fused
+//   3 LATENCY_MEAN_FILTER    intensity histograms and means
+//   4 LATENCY_SHM_PUBLISH    copy into this segment
+//   5 LATENCY_SAVE_ENQUEUE   push onto the save queue
+//   6 LATENCY_SAVE_WRITE     write of one frame to disk
+//   7 LATENCY_STD_DEV        std. dev. filter update
+//   8 LATENCY_FRAME_GRAPH    a whole frame through the frame graph
+// Later stages are appended, so a reader's indices stay valid.
+struct shmLatencyStats {
+    uint64_t count; // frames recorded for this stage
+    uint32_t p50;
+    uint32_t p99;
+    uint32_t p999;
+    uint32_t max;
+};
+
+// Frame counter continuity, from the line header of each frame.
+// Updated with every frame. The counts are since the acquisition started.
+struct shmFrameGap {
+    uint64_t time; // system time since epoch, in milliseconds, when the gap was seen
+    uint64_t frame; // liveview's frame count at the gap
+    uint32_t missing; // frames skipped over
+    uint16_t expected; // counter value expected
+    uint16_t received; // counter value received instead
+};
+
+struct shmContinuityStats {
+    uint64_t checked; // frames whose line header was checked
+    uint64_t dropped; // total frames missing from the counter sequence
+    uint64_t repeated; // frames with the same counter as the one before
+    uint64_t outOfOrder; // frames with a counter behind the latest one
+    uint64_t resyncs; // times the counter restarted and was followed from there
+    uint64_t gaps; // jumps forward in the counter. Written last, after recentGaps.
+    uint16_t lastCounter;
+    uint16_t lastObcStatus; // OBC status pixel of the latest frame, as sent
+    uint32_t recentGapCount; // valid entries of recentGaps, oldest first
+    struct shmFrameGap recentGaps[shmGapHistoryCount];
+};
+
 // Shared Memory Segment Data Structure:
 struct shmSharedDataStruct {
     char statusByte; // Packed as four bytes, see above
@@ -45,6 +92,9 @@ struct shmSharedDataStruct {
     uint16_t frameBuffer[shmFrameBufferSize][shmWidth*shmHeight]; // Buffer of frames. Read into the buffer by offsetting how many bytes-of-frame are needed.
     //uint16_t *frameBuffer[shmFrameBufferSize];
     char lastFilename[shmFilenameBufferSize]; // Last used filename for saving data out. Is not cleared or reset after saving.
+    // Appended after lastFilename, so that older readers keep their offsets:
+    struct shmLatencyStats stageLatency[shmLatencyStageCount]; // See above. Refreshed every LATENCY_SHM_UPDATE_FRAMES (constants.h) frames.
+    struct shmContinuityStats continuity; // Dropped frame accounting, see above. Refreshed with every frame.
 };
 
 // Union for manipulating the buffers as either pixels or bytes:
@@ -12,14 +12,23 @@
 #include <cmath>
 #include <vector>
 #include <array>
+#include <pthread.h>
 
 #include "constants.h"
-#include "edtinc.h"
+#include "pdv_device.h"
+#ifdef CPU_ONLY
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#else
 #include "cuda.h"
 #include "cuda_runtime.h"
 #include "cuda_utils.cuh"
 #include "std_dev_filter_device_code.cuh"
+#endif
 #include "frame_c.hpp"
+#include "frame_pool.hpp"
+#include "log_histogram.hpp"
 
 /*! \brief Host code for the standard deviation calculation.
  *
@@ -27,9 +36,20 @@
  * Synchronously, and at others Asynchronously. This host code acts as a "staging point" for the memory
  * operations and handles the input and output to and from the rest of the software. It also launches
  * the kernel on the deivce, and copies the results back to the host after the kernel completes.
+ *
+ * A CPU_ONLY build has the same interface without a device, see std_dev_filter_cpu.cpp. The ring of frames is kept
+ * in host memory, and a worker thread stands in for the CUDA stream: a calculation is started for a frame only when
+ * the previous one has finished, exactly as the kernel is only launched once the stream is idle. Instead of reading
+ * all N frames for each result, the worker slides integer per-pixel sums along the ring, so a result costs the frames
+ * added since the last one plus one pass over the pixels, whatever N is.
+ *
+ * Every frame should be handed to update_GPU_buffer(), so that the ring holds the true history. With calculate false
+ * the frame is only added to the ring, for frames whose result nobody will display, see product_schedule.hpp.
  */
 
+#ifndef CPU_ONLY
 static const int STD_DEV_DEVICE_NUM = (1 % getDeviceCount());
+#endif
 static const bool DEBUG = false;
 
 class std_dev_filter
@@ -38,13 +58,27 @@ public:
 	std_dev_filter(int nWidth, int nHeight);
 	virtual ~std_dev_filter();
 
-	void update_GPU_buffer(frame_c *, unsigned int);
+	bool update_GPU_buffer(frame_c *, unsigned int, bool calculate = true);
 	bool outputReady();
 	float * wait_std_dev_filter();
 	uint32_t * wait_std_dev_histogram();
 	std::vector<float> * getHistogramBins();
 	uint16_t * getEntireRingBuffer(); //For testing only
+	size_t resultPoolBytes() const { return resultPool.bytes(); }
+	// The STDDEV worker of a CPU_ONLY build, for take_object's thread policy. False where the device does the work.
+	bool workerThread(pthread_t &thread)
+	{
+#ifdef CPU_ONLY
+		thread = worker.native_handle();
+		return true;
+#else
+		(void)thread;
+		return false;
+#endif
+	}
+#ifndef CPU_ONLY
 	cudaStream_t std_dev_stream;
+#endif
 private:
     std_dev_filter() {} //Private default constructor
 	std::vector <float> shb;
@@ -57,6 +91,30 @@ private:
         unsigned int optimalBlockSizeY = 0;
         unsigned int optimalBlockSizeX = 0;
 
+#ifdef CPU_ONLY
+	uint16_t * pictures_host = NULL; // GPU_FRAME_BUFFER_SIZE frames, like pictures_device
+	std::thread worker;
+	std::mutex workLock;
+	std::condition_variable workReady;
+	bool workPending = false;
+	bool workBusy = false;
+	bool workerExit = false;
+	frame_c * workFrame = NULL;
+	uint64_t workEnd = 0; // frame number after the last one of the calculation
+	unsigned int workN = 0;
+	uint64_t framesAdded = 0; // frame numbers count from 0, frame k is in slot k % GPU_FRAME_BUFFER_SIZE
+	// The sliding window, owned by the worker: per pixel sums of the windowN frames before windowEnd.
+	uint32_t * window_sum = NULL;
+	uint64_t * window_sq_sum = NULL;
+	uint64_t windowEnd = 0;
+	unsigned int windowN = 0;
+	uint64_t windowSummedAt = 0; // windowEnd when the window was last summed afresh
+	log_histogram log_bins;
+	void workerLoop();
+	const uint16_t *ringFrame(uint64_t index) const;
+	void moveWindow(uint64_t end, unsigned int N);
+	void calculate(frame_c *frame, uint64_t end, unsigned int N);
+#else
 	uint16_t * pictures_device;
 	uint16_t * current_picture_device;
 
@@ -64,22 +122,11 @@ private:
 	float * histogram_bins_device;
 
 	uint32_t * histogram_out_device;
+	uint64_t framesAdded = 0; // frames copied into the device ring by this filter
+#endif
 	float histogram_bins[NUMBER_OF_BINS];
 	float * std_dev_result;
 	frame_c * prevFrame = NULL;
+	frame_pool resultPool; // pinned std. dev. image and histogram, attached to each frame the kernel runs for; next() skips those of leased frames
 };
-static std::array<float, NUMBER_OF_BINS> getHistogramBinValues()
-{
-	std::array<float,NUMBER_OF_BINS> values;
-
-    float max = log((1<<16)); // ln(2^16)
-    float increment = (max - 0)/(NUMBER_OF_BINS);
-	float acc = 0;
-	for(unsigned int i = 0; i < NUMBER_OF_BINS; i++)
-	{
-		values[i] = exp(acc)-1;
-		acc+=increment;
-	}
-	return values;
-}
 #endif /* STD_DEV_FILTER_CUH_ */
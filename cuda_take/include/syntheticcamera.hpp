@@ -0,0 +1,106 @@
+#ifndef SYNTHETICCAMERA_HPP
+#define SYNTHETICCAMERA_HPP
+
+#include <cstdint>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+
+#include "cameramodel.h"
+#include "constants.h"
+#include "cudalog.h"
+#include "takeoptions.h"
+
+/*! \file
+ * \brief A camera which makes its own frames at a set rate, to load take_object without hardware or a sender.
+ * \paragraph
+ *
+ * SyntheticCamera produces frames on its streamLoop() thread, as rtpnextgen does from the network, and take_object
+ * consumes them with getFrameWait() on the same consumer loop. Each frame is a deterministic pattern: a ramp, where
+ * pixel (x,y) of frame n is (x+y+n) & 0xffff, or gaussian noise around 8192 with a known sigma, drawn once from a
+ * fixed seed so that every run sees the same values. The line header carries the frame counter at pixel 160 and the
+ * science OBC status at pixel 159, as the instruments do, so the continuity accounting of take_object works on it.
+ * \paragraph
+ *
+ * Frames are paced against absolute deadlines on CLOCK_MONOTONIC, so that the rate does not drift with the time
+ * spent making each frame: the producer sleeps until SYNTHETIC_SPIN_US before the deadline and spins the rest of the
+ * way. A tick which starts more than SYNTHETIC_SPIN_US after its deadline is counted as late; the frame is still made,
+ * so a producer that cannot keep up shows as late ticks and a lower rate rather than as gaps.
+ * \paragraph
+ *
+ * Every tick uses up one counter value. A frame is lost, and its counter value with it, in two ways, counted
+ * separately: one in every syntheticDropEvery ticks is dropped on purpose, and a tick which finds the ring full, the
+ * consumer being SYNTHETIC_RING_FRAMES-1 frames behind, is an overrun, as a frame grabber out of buffers would drop
+ * it. Their sum is what frame_continuity should report as dropped, which is how the drop accounting is tested; the
+ * totals are logged by stop().
+ */
+
+enum synthetic_pattern_t {
+    SYNTHETIC_RAMP = 0,
+    SYNTHETIC_NOISE = 1
+};
+
+struct synthetic_stats_t {
+    uint64_t ticks = 0;         // counter values used up
+    uint64_t delivered = 0;     // frames handed to the consumer
+    uint64_t injectedDrops = 0; // dropped on purpose, syntheticDropEvery
+    uint64_t overruns = 0;      // the ring was full
+    uint64_t lateTicks = 0;     // ticks which started late, see above
+    double seconds = 0;         // since the first tick
+};
+
+class SyntheticCamera : public CameraModel
+{
+public:
+    explicit SyntheticCamera(const takeOptionsType &options);
+    ~SyntheticCamera();
+
+    uint16_t* getFrame(CameraModel::camStatusEnum *stat);
+    uint16_t* getFrameWait(unsigned int lastFrameNumber, CameraModel::camStatusEnum *stat);
+    void streamLoop(); // the producer, on its own thread
+    void stop();
+    virtual camControlType* getCamControlPtr();
+    virtual void setCamControlPtr(camControlType* p);
+
+    synthetic_stats_t stats();
+    double noiseSigma() const { return poolSigma; } // of the noise pool as stored, 0 for the ramp
+
+    static const uint16_t headerStatus = 3; // obcStatusScience
+
+private:
+    void makeFrame(uint16_t *frame, uint64_t tick);
+    void report();
+
+    unsigned int pattern;
+    double fps;
+    double sigma;
+    unsigned int dropEvery;
+
+    size_t framePixels = 0;
+    uint16_t *ringBlock = NULL; // SYNTHETIC_RING_FRAMES frames, one frame_memory region
+    uint16_t *ring[SYNTHETIC_RING_FRAMES] = {NULL};
+    uint16_t *doneFrame = NULL; // handed out once stopped
+    std::vector<uint16_t> rampRow; // one row of the ramp, with frame_width+65536 values
+    std::vector<uint16_t> noisePool; // framePixels+65536 values, each frame starts somewhere in it
+    double poolSigma = 0;
+
+    // The handoff: frames are numbered from 1 as they are delivered, and frame d is in ring[d % SYNTHETIC_RING_FRAMES].
+    std::mutex handoffLock;
+    std::condition_variable frameReady;
+    uint64_t published = 0; // the newest complete frame
+    uint64_t held = 0; // the frame the consumer has, which must not be written
+    bool reported = false;
+
+    std::atomic<uint64_t> ticks;
+    std::atomic<uint64_t> delivered;
+    std::atomic<uint64_t> injectedDrops;
+    std::atomic<uint64_t> overruns;
+    std::atomic<uint64_t> lateTicks;
+    std::atomic<int64_t> startNs; // CLOCK_MONOTONIC of the first tick, 0 before it
+    std::atomic<int64_t> lastNs;
+
+    camControlType *camcontrol = NULL;
+};
+
+#endif // SYNTHETICCAMERA_HPP
@@ -26,6 +26,11 @@
 #include <boost/thread/mutex.hpp>
 #include <pthread.h>
 #include <mutex>
+#include <memory>
+#include <condition_variable>
+#include <vector>
+#include <map>
+#include <set>
 #include <gsl/gsl_statistics_uint.h>
 #include <gsl/gsl_statistics.h>
 //#include <boost/atomic.hpp>
@@ -36,14 +41,25 @@
 #include "chroma_translate_filter.hpp"
 #include "dark_subtraction_filter.hpp"
 #include "mean_filter.hpp"
+#include "save_queue.hpp"
+#include "frame_pool.hpp"
+#include "frame_conditioning.hpp"
+#include "frame_notifier.hpp"
+#include "latency_histogram.hpp"
+#include "log_histogram.hpp"
+#include "frame_executor.hpp"
+#include "frame_metadata.hpp"
+#include "product_schedule.hpp"
 #include "camera_types.h"
 #include "cameramodel.h"
 #include "xiocamera.h"
 #include "constants.h"
 #include "safestringset.h"
 #include "takeoptions.h"
+#include "osutils.h"
 #include "fileformats.h"
 #include "rtpnextgen.hpp"
+#include "syntheticcamera.hpp"
 #include "rtpcamera.hpp"
 
 //** Harware Macros ** These Macros set the hardware type that take_object will use to collect data
@@ -65,8 +81,6 @@
 
 using std::string;
 
-static const bool CHECK_FOR_MISSED_FRAMES_6604A = false; // toggles the presence or absence of the "WARNING: MISSED FRAME X" line
-
 #define meanDeltaSize (20)
 
 #define obcStatusPixel (159)
@@ -80,7 +94,7 @@ class take_object {
     PdvDev * pdv_p = NULL;
     unsigned int channel;
     unsigned int numbufs;
-    unsigned int filter_refresh_rate;
+    unsigned int filter_refresh_rate; // n of PRODUCT_EVERY_NTH, unless takeOptionsType::productEvery is set
 
     // Shared memory support:
     int shmFd = 0;
@@ -141,13 +155,15 @@ public:
     void initialSetup(int channel_num = 0, int number_of_buffers = 64,
                       int filter_refresh_rate = 10, bool runStdDev = true);
     void start();
+    bool reconfigure(takeOptionsType newOptions);
     void changeOptions(takeOptionsType options);
     void setReadDirectory(const char* directory);
     camControlType* getCamControl();
     dark_subtraction_filter* dsf;
     camera_t cam_type;
-    frame_c * frame_ring_buffer;
-    unsigned long count = 0; // running frame counter
+    frame_c * frame_ring_buffer = NULL;
+    unsigned int getRingDepth() { return ringDepth; }
+    unsigned long count = 0; // running frame counter, carried on across reconfigure()
     int xioCount = 0; // counter for each set of xio files.
     uint16_t* prior_temp_frame = NULL;
     int getMicroSecondsPerFrame();
@@ -181,8 +197,8 @@ public:
     // Frame saving functions
     void startSavingRaws(std::string raw_file_name, unsigned int frames_to_save, unsigned int num_avgs_save);
 	void stopSavingRaws();
+    bool isSaving();
     //void panicSave(std::string);
-    std::list<uint16_t *> saving_list;
 	std::atomic <uint_fast32_t> save_framenum;
 	std::atomic <uint_fast32_t> save_count;
 	unsigned int save_num_avgs;
@@ -194,6 +210,45 @@ public:
     bool std_dev_ready();
     std::vector<float> * getHistogramBins();
     FFT_t getFFTtype();
+    unsigned int getSaveQueueDepth();
+    unsigned int getSaveQueueHighWater();
+    uint64_t getSaveQueueDropped();
+
+    // Frame-ready notification, replaces polling count:
+    uint64_t waitForFrame(uint64_t lastSeq, unsigned int timeout_ms);
+    uint64_t frameSequence();
+    int getFrameEventFd();
+
+    // Frame leases, so readers never see a slot being overwritten:
+    frame_c *acquireLatest();
+    void release(frame_c *frame);
+    uint64_t getLeaseSkips();
+    uint64_t getLeaseOverruns();
+
+    // Frame graph, see submitFrameGraph:
+    void shareFrameGraph(frame_executor *executor);
+    uint64_t getProductSkips();
+    uint64_t getFrameGraphStalls();
+    mean_series_summary getMeanSeries(); // of the running acquisition, or of the last one once stopped
+    unsigned int getPlaneMeanSpectrum(unsigned int segment, std::vector<float> &magnitude); // segment 0, or beyond the history, for the whole history
+
+    // Which frames get the derived products, see product_schedule.hpp:
+    void setProductPolicy(derived_product_t product, product_policy_t policy, unsigned int every = 0);
+    product_policy_t getProductPolicy(derived_product_t product);
+    uint64_t getProducedFrames(derived_product_t product);
+
+    // Frame counter continuity, from each frame's line header:
+    frame_continuity_summary getContinuity();
+    unsigned int getRecentFrameGaps(frame_gap_t *gaps, unsigned int maxGaps);
+
+    // Source and geometry switching, see reconfigure:
+    bool isReconfiguring() { return reconfiguring.load(std::memory_order_relaxed); }
+    uint64_t getLastSwitchMicros();
+    uint64_t getFirstFrameMicros();
+
+    // Per-stage latency of the acquisition pipeline:
+    latency_summary getStageLatency(latency_stage_t stage);
+    void resetStageLatency();
 
 private:
     // PDV Camera Link:
@@ -213,18 +268,148 @@ private:
     void prepareRTPNGCamera();
     void rtpNGStreamLoop();
 
+    // Synthetic frames, for load tests:
+    void prepareSyntheticCamera();
+
     CameraModel *Camera = NULL;
+    std::shared_ptr<mean_filter> loopMeanFilter; // made by the camera loop, released once it has stopped; readers hold a copy
+    std::mutex loopMeanFilterLock; // guards loopMeanFilter and lastMeanSeries
+    mean_series_summary lastMeanSeries; // loopMeanFilter's, kept when it is released
     bool fileReadingLoopRun = false;
     bool rtpConsumerRun = false;
     camControlType cameraController;
     CameraModel::camStatusEnum camStatus;
 
+    // Shared by every camera loop: condition the frame into curFrame and run the filters.
+    void processFrame(const uint16_t *source, mean_filter *mf, bool liveSource, bool hasLineHeader = true);
+
+    // The work for each frame after conditioning, run by frameGraph:
+    struct frame_job_t {
+        frame_c *frame = NULL;
+        unsigned long frameCount = 0;
+        mean_filter *mf = NULL;
+        bool fusedDark = false;
+        unsigned int stdDevN = 0;
+        int meanStartCol = 0;
+        int meanWidth = 0;
+        int meanStartRow = 0;
+        int meanHeight = 0;
+        bool useDSF = false;
+        FFT_t fftType = PLANE_MEAN;
+        int lh_start = 0;
+        int lh_end = 0;
+        int cent_start = 0;
+        int cent_end = 0;
+        int rh_start = 0;
+        int rh_end = 0;
+        bool ingest = false; // no products, only the histories which need every frame
+        bool stdDevCalculate = false;
+        std::atomic<int> pending; // nodes left to run
+        std::chrono::steady_clock::time_point submitted;
+    };
+    frame_executor frameGraph;
+    frame_executor *sharedGraph = NULL; // runs the strands instead of frameGraph, see shareFrameGraph
+    bool frameGraphStarted = false;
+    frame_strand darkStrand{frameGraph};
+    frame_strand meanStrand{frameGraph};
+    frame_strand stdDevStrand{frameGraph};
+    frame_strand shmStrand{frameGraph};
+    frame_strand saveStrand{frameGraph};
+    frame_job_t frameJobs[FRAME_GRAPH_MAX_JOBS];
+    std::vector<frame_job_t *> freeFrameJobs;
+    std::mutex frameJobLock;
+    std::condition_variable frameJobFreed;
+    unsigned int productLimit = 1; // frames whose products may be in the graph at once
+    std::atomic<unsigned int> productsInFlight;
+    std::atomic<uint64_t> productSkips;
+    std::atomic<uint64_t> graphStalls;
+    product_schedule productSchedules[PRODUCT_KIND_COUNT];
+    log_histogram intensityBins; // for the raw and dark subtracted histograms of the frames with products
+    std::atomic<std::chrono::steady_clock::time_point> lastDemand{std::chrono::steady_clock::time_point()}; // of acquireLatest
+    void applyProductPolicies();
+    void setupMeanFilter(mean_filter *mf);
+    void startFrameGraph();
+    void setProductLimit();
+    void waitFrameGraphIdle();
+    void drainFrameGraph();
+    frame_job_t *takeFrameJob();
+    void submitFrameGraph(mean_filter *mf, bool shmNode, bool products, bool fusedDark, bool filters, bool stdDevDue);
+    void runDarkNode(frame_job_t *job);
+    void runMeanNode(frame_job_t *job);
+    void runIngestNode(frame_job_t *job);
+    void runMeanIngestNode(frame_job_t *job);
+    void runStdDevNode(frame_job_t *job);
+    void runShmNode(frame_job_t *job);
+    void finishFrameNode(frame_job_t *job);
+
     void savingLoop(std::string, unsigned int num_avgs, unsigned int num_frames);
+    void queueFrameForSaving(uint16_t *frame);
+    save_queue saving_queue; // preallocated frames waiting for the savingLoop, allocated by the first recording
+    bool prepareSavingQueue();
+    frame_notifier frameNotifier; // published once a frame is ready for display
+    latency_histogram stageLatency[LATENCY_STAGE_COUNT];
+    unsigned int ringDepth = CPU_FRAME_BUFFER_SIZE; // frames in frame_ring_buffer
+    frame_pool rawPool; // raw data of every frame in the ring, one slot per frame
+    frame_pool darkPool; // dark subtracted data, attached to frames the filters run for
+    frame_pool meanPool; // mean profiles and FFT magnitude
+    std::atomic<unsigned int> *sequenceSlot = NULL; // ring slot of each recent sequence number
+    unsigned int ringCursor = 0; // next slot for claimNextFrame to try
+    bool curFrameClaimed = false;
+    std::atomic<uint64_t> leaseSkips;
+    std::atomic<uint64_t> leaseOverruns;
+    frame_c *claimNextFrame();
+    void endFrameClaim();
+    void setFrameMemoryPolicy();
+    const char *acquisitionThreadName();
+    void allocateFrameMemory();
+    void reportMemoryUsage();
+
+    // The ring past its first RING_EAGER_FRAMES is populated in the background, see allocateFrameMemory():
+    void ringFillLoop();
+    void stopRingFill();
+    boost::thread ringFillThread;
+    std::atomic<bool> ringFillRun{false};
+    std::atomic<unsigned int> ringReady{0}; // slots claimNextFrame may use
+    unsigned int ringPopulated = 0; // slots of rawPool faulted in so far
+
+    // Time to first frame, from start() or reconfigure():
+    void reportFirstFrame();
+    std::chrono::steady_clock::time_point startBegin;
+    std::atomic<bool> firstFramePending{false};
+    std::atomic<uint64_t> firstFrameMicros{0};
+    void publishLatencyToShm();
+    void publishContinuityToShm();
+    frame_source_t frameSource();
+    void setupContinuity();
+    frame_metadata_decoder metadataDecoder;
+    frame_continuity continuity;
+    uint64_t shmGapsPublished = 0;
+    std::chrono::steady_clock::time_point lastGapWarning;
+    void reportFrameGap();
     std::mutex savingMutex;
     bool savingData = false;
 
+    // The source, from start() or reconfigure():
+    bool openSource();
+    void startAcquisition();
+    void stopAcquisition();
+    bool waitForReaders(unsigned int timeout_ms);
+    void updateShmGeometry();
+    std::mutex reconfigureMutex; // held by reconfigure() and startSavingRaws()
+    std::atomic<bool> reconfiguring{false}; // acquireLatest hands out no frames while set
+    std::atomic<uint64_t> lastSwitchMicros{0};
+
     takeOptionsType options;
 
+    // Thread placement and memory locking from takeOptionsType:
+    void applyThreadPolicy(pthread_t thread, const char *name);
+    void applyStdDevThreadPolicy();
+    void reportThreadPolicy();
+    void lockFrameMemory();
+    std::map<std::string, std::string> threadCpuMap;
+    std::map<std::string, std::string> threadPriorityMap;
+    std::set<std::string> policyThreadNames; // threads started so far, for the report
+
     float deltaT_micros = 100.0;
     int measuredDelta_micros_final = 0;
     int meanDeltaArrayPos = 0;
@@ -235,6 +420,7 @@ private:
     void clearAllRingBuffer();
 
     std::streambuf *coutbuf;
+    std::string messageTag();
     void errorMessage(const char* message);
     void warningMessage(const char* message);
     void statusMessage(const char* message);
@@ -244,10 +430,12 @@ private:
     void statusMessage(std::ostringstream &message);
 
     // variables needed by the Raw Filters
+    chroma_translate_filter chromaFilter;
     unsigned int invFactor; // inversion factor as determined by the maximum possible pixel magnitude
     bool inverted = false;
     bool pixRemap = false; // Enable Parallel Pixel Mapping (Chroma Translate filter)
-    bool continuousRecording = false; // flag to enable continuous recording
+    std::atomic<bool> continuousRecording{false}; // flag to enable continuous recording
+    std::atomic<bool> producerQueueing{false}; // set by queueFrameForSaving() while it may push
     FFT_t whichFFT;
 };
 
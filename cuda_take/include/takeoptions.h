@@ -44,11 +44,50 @@ struct takeOptionsType
     bool rtprgb = true;
     bool rtpNextGen = false;
 
+    // Frames made by SyntheticCamera, see syntheticcamera.hpp:
+    bool syntheticCam = false;
+    uint16_t syntheticWidth = 1280;
+    uint16_t syntheticHeight = 481;
+    float syntheticFPS = 1000;
+    int syntheticPattern = 0; // 0 for a ramp, 1 for gaussian noise
+    float syntheticSigma = 20; // of the noise
+    unsigned int syntheticDropEvery = 0; // drop one frame in every N on purpose, 0 for none
+
     bool er2mode = false;
     bool headless = false;
     bool noGPU = false;
 
     bool useSHM = false;
+    const char* shmName = NULL; // shared memory segment, NULL for "/liveview_image"
+
+    // Several take_objects may run in one process, e.g. a VNIR and a SWIR camera:
+    const char* instanceName = NULL; // tags the messages of this instance, e.g. "SWIR"
+    unsigned int pdvUnit = 0; // EDT board
+    int pdvChannel = -1; // -1 uses the channel given to the take_object constructor
+
+    unsigned int pdvMultibufs = 64;
+    unsigned int frameRingDepth = 1500; // frames kept in take_object's ring
+    unsigned int productPoolDepth = 64; // slots for each derived product (dark, profiles)
+
+    // Thread placement, as "NAME=value;NAME=value" using the pthread names
+    // (TAKE, PDVCAM, XIOCAM, READING, RTPNG Stream, RTPNG Consume, SAVING, STDDEV, ...)
+    const char* threadCpus = NULL; // e.g. "PDVCAM=2;SAVING=3-5"
+    const char* threadPriorities = NULL; // SCHED_FIFO priority, e.g. "PDVCAM=80"
+    bool lockMemory = false; // mlock the frame ring and save queue
+    unsigned int graphThreads = 0; // frame graph workers (GRAPH0, ...), 0 picks from the CPU count
+
+    // Which frames get the derived products, see product_schedule.hpp:
+    unsigned int meansPolicy = 0; // product_policy_t for the profiles and FFT: 0 every frame, 1 every n-th, 2 display rate
+    unsigned int stdDevPolicy = 0; // product_policy_t for the standard deviation
+    unsigned int productEvery = 0; // n of every n-th, 0 uses the filter_refresh_rate given to take_object
+
+    // Spectra of the profiles and plane means, see fft.hpp:
+    unsigned int meanHistory = 500; // frame means kept for the PLANE_MEAN spectra, at least FFT_INPUT_LENGTH
+    unsigned int fftWindow = 0; // fft_window_t: 0 rectangular, 1 Hann, 2 Hamming, 3 Blackman
+
+    // Frame memory placement, see frame_memory.hpp:
+    unsigned int hugePageSize = 0; // MiB per huge page: 0 for normal pages, 2 or 1024
+    int numaNode = -1; // -1 follows the CPUs of the acquisition thread, if pinned
 
     uint16_t height;
     uint16_t width;
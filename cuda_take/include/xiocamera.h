@@ -60,6 +60,7 @@ public:
     }
 
     void readLoop();
+    void stop();
     virtual camControlType* getCamControlPtr();
     virtual void setCamControlPtr(camControlType* p);
 
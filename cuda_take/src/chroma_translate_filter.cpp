@@ -1,12 +1,31 @@
 #include "chroma_translate_filter.hpp"
 #include <iostream>
 #include "camera_types.h"
+#include <cstdlib>
+#include <cstring>
 
-void setup_filter(camera_t camera_type)
+chroma_translate_filter::~chroma_translate_filter()
+{
+    free(pic_buffer);
+}
+
+void chroma_translate_filter::resize_buffer(unsigned int h, unsigned int w)
+{
+    frHeight = h;
+    frWidth = w;
+    free(pic_buffer);
+    pic_buffer = (uint16_t *)malloc((size_t)h*w*sizeof(uint16_t));
+    if(pic_buffer == NULL)
+    {
+        std::cerr << "Could not allocate the chroma translate buffer for a " << w << "x" << h << " frame." << std::endl;
+        abort();
+    }
+}
+
+void chroma_translate_filter::setup_filter(camera_t camera_type)
 {
 	hardware = camera_type;
-	frHeight = height[hardware];
-	frWidth = width[hardware];
+	resize_buffer(height[hardware], width[hardware]);
 	num_taps = number_of_taps[hardware];
 	MAX_VAL = max_val[hardware];
     //std::cout << "------------------ Completed setup_filter(camType) with height: " << frHeight << ", width: " << frWidth << std::endl;
@@ -14,15 +33,14 @@ void setup_filter(camera_t camera_type)
 
 }
 
-void setup_filter(unsigned int h, unsigned int w)
+void chroma_translate_filter::setup_filter(unsigned int h, unsigned int w)
 {
-    frHeight = h;
-    frWidth = w;
+    resize_buffer(h, w);
     std::cout << "Setting camera geometry:\n";
     std::cout << "  Completed setup_filter(h,w) with height: " << frHeight << ", width: " << frWidth << std::endl;
 }
 
-uint16_t* apply_chroma_translate_filter(uint16_t *picture_in)
+uint16_t* chroma_translate_filter::apply_chroma_translate_filter(uint16_t *picture_in)
 {
     unsigned int row, col;
     //unsigned int div, mod;
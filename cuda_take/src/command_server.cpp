@@ -0,0 +1,548 @@
+#include "command_server.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <sstream>
+#include <unistd.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+namespace
+{
+    // Reads the QDataStream (Qt_4_0) encoding of a message, failing once it runs past the end.
+    class stream_in
+    {
+    public:
+        stream_in(const uint8_t *data, size_t length) : p(data), end(data + length) {}
+        bool ok() const { return good; }
+
+        uint16_t u16()
+        {
+            if(!have(2))
+                return 0;
+            uint16_t v = (uint16_t)((p[0] << 8) | p[1]);
+            p += 2;
+            return v;
+        }
+        uint32_t u32()
+        {
+            uint32_t hi = u16();
+            return (hi << 16) | u16();
+        }
+        std::string string(size_t &units)
+        {
+            // UTF-16 to UTF-8, counting UTF-16 code units as QString::length() does.
+            std::string out;
+            units = 0;
+            uint32_t bytes = u32();
+            if(!good || (bytes == 0xffffffff))
+                return out;
+            if((bytes % 2 != 0) || !have(bytes))
+            {
+                good = false;
+                return out;
+            }
+            units = bytes / 2;
+            for(size_t u = 0; u < units; u++)
+            {
+                uint32_t c = u16();
+                if((c >= 0xd800) && (c < 0xdc00) && (u + 1 < units))
+                {
+                    c = 0x10000 + ((c - 0xd800) << 10) + (u16() - 0xdc00);
+                    u++;
+                }
+                if(c < 0x80) {
+                    out += (char)c;
+                } else if(c < 0x800) {
+                    out += (char)(0xc0 | (c >> 6));
+                    out += (char)(0x80 | (c & 0x3f));
+                } else if(c < 0x10000) {
+                    out += (char)(0xe0 | (c >> 12));
+                    out += (char)(0x80 | ((c >> 6) & 0x3f));
+                    out += (char)(0x80 | (c & 0x3f));
+                } else {
+                    out += (char)(0xf0 | (c >> 18));
+                    out += (char)(0x80 | ((c >> 12) & 0x3f));
+                    out += (char)(0x80 | ((c >> 6) & 0x3f));
+                    out += (char)(0x80 | (c & 0x3f));
+                }
+            }
+            return out;
+        }
+
+    private:
+        const uint8_t *p;
+        const uint8_t *end;
+        bool good = true;
+        bool have(size_t n)
+        {
+            if(good && ((size_t)(end - p) >= n))
+                return true;
+            good = false;
+            return false;
+        }
+    };
+
+    // Writes a reply block. The first quint16 is filled in with the size by finish().
+    class stream_out
+    {
+    public:
+        stream_out() { u16(0); }
+        void u16(uint16_t v)
+        {
+            block.push_back(v >> 8);
+            block.push_back(v & 0xff);
+        }
+        void u32(uint32_t v)
+        {
+            u16(v >> 16);
+            u16(v & 0xffff);
+        }
+        void u64(uint64_t v)
+        {
+            u32(v >> 32);
+            u32(v & 0xffffffff);
+        }
+        void f32(float v)
+        {
+            // As QDataStream writes a float at version Qt_4_0, IEEE single precision.
+            uint32_t bits;
+            memcpy(&bits, &v, sizeof(bits));
+            u32(bits);
+        }
+        void string(const std::string &s)
+        {
+            // UTF-8 to UTF-16. Only the reply to STATUS_EXTENDED carries anything but ASCII.
+            std::vector<uint16_t> units;
+            for(size_t i = 0; i < s.size(); )
+            {
+                uint8_t b = s[i];
+                uint32_t c = b;
+                int extra = 0;
+                if(b >= 0xf0) { c = b & 0x07; extra = 3; }
+                else if(b >= 0xe0) { c = b & 0x0f; extra = 2; }
+                else if(b >= 0xc0) { c = b & 0x1f; extra = 1; }
+                i++;
+                for(int e = 0; (e < extra) && (i < s.size()); e++, i++)
+                    c = (c << 6) | (s[i] & 0x3f);
+                if(c >= 0x10000)
+                {
+                    c -= 0x10000;
+                    units.push_back(0xd800 + (c >> 10));
+                    units.push_back(0xdc00 + (c & 0x3ff));
+                } else {
+                    units.push_back(c);
+                }
+            }
+            u32(units.size() * 2);
+            for(uint16_t u : units)
+                u16(u);
+        }
+        const std::vector<uint8_t> &finish()
+        {
+            uint16_t size = block.size() - sizeof(uint16_t);
+            block[0] = size >> 8;
+            block[1] = size & 0xff;
+            return block;
+        }
+
+    private:
+        std::vector<uint8_t> block;
+    };
+
+    bool makeDirectories(const std::string &path)
+    {
+        for(size_t slash = 0; slash != std::string::npos; )
+        {
+            slash = path.find('/', slash + 1);
+            std::string part = path.substr(0, slash);
+            if((mkdir(part.c_str(), 0775) != 0) && (errno != EEXIST))
+                return false;
+        }
+        return true;
+    }
+}
+
+command_server::command_server(take_object *to)
+{
+    this->to = to;
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+}
+
+command_server::~command_server()
+{
+    stop();
+    if(wakeFd >= 0)
+        close(wakeFd);
+}
+
+bool command_server::start(const char *address, uint16_t port)
+{
+    /*! \brief Listen on address:port and start serving. Returns false if the port cannot be had. */
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if(inet_pton(AF_INET, address, &addr.sin_addr) != 1)
+    {
+        errorMessage(std::string("Not an IPv4 address: ") + address);
+        return false;
+    }
+    listenFd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    int on = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    if((listenFd < 0) || (bind(listenFd, (sockaddr *)&addr, sizeof(addr)) != 0) || (listen(listenFd, 4) != 0))
+    {
+        std::ostringstream msg;
+        msg << "Cannot listen on " << address << ":" << port << ", " << strerror(errno);
+        errorMessage(msg.str());
+        if(listenFd >= 0)
+            close(listenFd);
+        listenFd = -1;
+        return false;
+    }
+    std::ostringstream msg;
+    msg << "Listening on " << address << ":" << port;
+    statusMessage(msg.str());
+    serverThread = std::thread(&command_server::serverLoop, this);
+    pthread_setname_np(serverThread.native_handle(), "SERVER");
+    return true;
+}
+
+void command_server::stop()
+{
+    if(serverThread.joinable())
+    {
+        uint64_t one = 1;
+        if(write(wakeFd, &one, sizeof(one)) != sizeof(one))
+            errorMessage("Could not wake the server thread.");
+        serverThread.join();
+    }
+    closeClient();
+    if(listenFd >= 0)
+        close(listenFd);
+    listenFd = -1;
+}
+
+void command_server::setFlightNaming(const std::string &dataLocation, const std::string &namePrefix)
+{
+    std::lock_guard<std::mutex> lock(namingLock);
+    this->dataLocation = dataLocation;
+    this->namePrefix = namePrefix;
+}
+
+std::string command_server::flightFilename()
+{
+    /*! \brief A new name for a flight recording, the same as LiveView's flight mode gives. */
+    char stamp[32];
+    time_t now = time(NULL);
+    struct tm utc;
+    gmtime_r(&now, &utc);
+    strftime(stamp, sizeof(stamp), "%Y%m%dt%H%M%S", &utc);
+    std::lock_guard<std::mutex> lock(namingLock);
+    return dataLocation + "/" + namePrefix + stamp + "_raw";
+}
+
+void command_server::serverLoop()
+{
+    while(true)
+    {
+        pollfd fds[3];
+        fds[0] = { wakeFd, POLLIN, 0 };
+        fds[1] = { listenFd, POLLIN, 0 };
+        fds[2] = { clientFd, POLLIN, 0 }; // ignored by poll() while there is no client
+        if(poll(fds, 3, -1) < 0)
+        {
+            if(errno == EINTR)
+                continue;
+            errorMessage(std::string("poll failed, ") + strerror(errno));
+            return;
+        }
+        if(fds[0].revents)
+            return;
+        if(fds[1].revents & POLLIN)
+            acceptClient();
+        if((clientFd >= 0) && (fds[2].revents & (POLLIN | POLLHUP | POLLERR)))
+            readClient();
+    }
+}
+
+void command_server::acceptClient()
+{
+    int fd = accept4(listenFd, NULL, NULL, SOCK_CLOEXEC);
+    if(fd < 0)
+    {
+        errorMessage("Client connection refused by host.");
+        return;
+    }
+    closeClient();
+    clientFd = fd;
+    statusMessage("New remote connection is active.");
+}
+
+void command_server::closeClient()
+{
+    if(clientFd >= 0)
+        close(clientFd);
+    clientFd = -1;
+    received.clear();
+}
+
+void command_server::readClient()
+{
+    uint8_t buffer[4096];
+    ssize_t n = recv(clientFd, buffer, sizeof(buffer), 0);
+    if(n <= 0)
+    {
+        if((n < 0) && ((errno == EINTR) || (errno == EAGAIN)))
+            return;
+        statusMessage("Remote host disconnected.");
+        closeClient();
+        return;
+    }
+    received.insert(received.end(), buffer, buffer + n);
+
+    // Each message is its size, then that many bytes. Anything short waits for the rest.
+    size_t used = 0;
+    while(received.size() - used >= sizeof(uint16_t))
+    {
+        size_t blockSize = (received[used] << 8) | received[used + 1];
+        if(received.size() - used - sizeof(uint16_t) < blockSize)
+            break;
+        if(!handleCommand(&received[used + sizeof(uint16_t)], blockSize))
+        {
+            errorMessage("Disconnecting remote host now.");
+            closeClient();
+            return;
+        }
+        used += sizeof(uint16_t) + blockSize;
+    }
+    received.erase(received.begin(), received.begin() + used);
+}
+
+bool command_server::checkValues(uint16_t framesToSaveCount, size_t filenameLength, uint16_t naverages)
+{
+    bool ok = true;
+    if(framesToSaveCount > 60000)
+        ok = false;
+    if((filenameLength < 4) || (filenameLength > 4096))
+        ok = false;
+    if( (naverages > 2000) || (naverages > framesToSaveCount))
+        ok = false;
+    return ok;
+}
+
+uint16_t command_server::framesPerSecond()
+{
+    int microSecondsPerFrame = to->getMicroSecondsPerFrame();
+    if(microSecondsPerFrame == 0)
+        return 0;
+    return (uint16_t)(1000000.0f / microSecondsPerFrame);
+}
+
+bool command_server::handleCommand(const uint8_t *message, size_t length)
+{
+    /*! \brief Carry out one message. Returns false for an unknown command, after which the client is dropped. */
+    stream_in in(message, length);
+    uint16_t commandType = in.u16();
+    if(!in.ok())
+    {
+        errorMessage("Empty message received.");
+        return true;
+    }
+
+    switch(commandType) {
+    case CMD_START_SAVING:
+    {
+        statusMessage("SAVE command received.");
+        uint16_t framesToSave = in.u16();
+        size_t nameLength = 0;
+        std::string name = in.string(nameLength);
+        uint16_t naverages = in.u16();
+        if(!in.ok())
+        {
+            errorMessage("Incomplete SAVE command.");
+        } else if(to->isSaving()) {
+            errorMessage("Received SAVE command while already saving.");
+        } else if(!checkValues(framesToSave, nameLength, naverages)) {
+            errorMessage("SAVE command has bad values.");
+        } else {
+            navgs = naverages;
+            fname = name;
+            to->startSavingRaws(name, framesToSave, naverages);
+        }
+        break;
+    }
+    case CMD_START_FLIGHT_SAVING:
+    {
+        statusMessage("START_FLIGHT_SAVING command received.");
+        if(to->isSaving())
+        {
+            errorMessage("Received START_FLIGHT_SAVING command while already saving.");
+            break;
+        }
+        std::string name = flightFilename();
+        std::string directory = name.substr(0, name.rfind('/'));
+        if(!makeDirectories(directory))
+        {
+            errorMessage("Could not create the data directory " + directory);
+            break;
+        }
+        // Records until STOP_SAVING, without averaging, as LiveView's flight mode does.
+        navgs = 1;
+        fname = name;
+        to->startSavingRaws(name, 0, 1);
+        statusMessage("Saving data to file [" + name + "]");
+        break;
+    }
+    case CMD_STATUS:
+    {
+        statusMessage("Sending STATUS information back.");
+        stream_out out;
+        out.u16((uint16_t)to->save_framenum.load(std::memory_order_relaxed));
+        out.u16(framesPerSecond());
+        out.u16(navgs);
+        reply(out.finish());
+        break;
+    }
+    case CMD_STOP_SAVING:
+        statusMessage("Received STOP_SAVING command");
+        to->stopSavingRaws();
+        break;
+    case CMD_STATUS_EXTENDED:
+    {
+        statusMessage("Sending STATUS_EXTENDED information back.");
+        stream_out out;
+        out.u16(CMD_STATUS_EXTENDED);
+        out.u16((uint16_t)to->save_framenum.load(std::memory_order_relaxed));
+        out.u16(framesPerSecond());
+        out.u16(navgs);
+        out.string(fname);
+        frame_continuity_summary continuity = to->getContinuity();
+        out.u64(continuity.checked);
+        out.u64(continuity.dropped);
+        out.u64(continuity.repeated);
+        out.u64(continuity.outOfOrder);
+        out.u64(continuity.gaps);
+        reply(out.finish());
+        break;
+    }
+    case CMD_LATENCY_STATS:
+    {
+        statusMessage("Sending LATENCY_STATS information back.");
+        stream_out out;
+        out.u16(CMD_LATENCY_STATS);
+        out.u16(LATENCY_STAGE_COUNT);
+        for(int s = 0; s < LATENCY_STAGE_COUNT; s++)
+        {
+            latency_summary summary = to->getStageLatency((latency_stage_t)s);
+            out.string(latency_stage_name((latency_stage_t)s));
+            out.u64(summary.count);
+            out.u32(summary.p50_ns / 1000);
+            out.u32(summary.p99_ns / 1000);
+            out.u32(summary.p999_ns / 1000);
+            out.u32(summary.max_ns / 1000);
+        }
+        reply(out.finish());
+        break;
+    }
+    case CMD_CONTINUITY_STATS:
+    {
+        statusMessage("Sending CONTINUITY_STATS information back.");
+        frame_continuity_summary continuity = to->getContinuity();
+        frame_gap_t gaps[FRAME_GAP_HISTORY];
+        unsigned int gapCount = to->getRecentFrameGaps(gaps, FRAME_GAP_HISTORY);
+        stream_out out;
+        out.u16(CMD_CONTINUITY_STATS);
+        out.u64(continuity.checked);
+        out.u64(continuity.dropped);
+        out.u64(continuity.repeated);
+        out.u64(continuity.outOfOrder);
+        out.u64(continuity.resyncs);
+        out.u64(continuity.gaps);
+        out.u16(gapCount);
+        for(unsigned int g = 0; g < gapCount; g++)
+        {
+            out.u64(gaps[g].time_ms);
+            out.u64(gaps[g].frame);
+            out.u16(gaps[g].expected);
+            out.u16(gaps[g].received);
+            out.u32(gaps[g].missing);
+        }
+        reply(out.finish());
+        break;
+    }
+    case CMD_MEAN_SPECTRUM:
+    {
+        statusMessage("Sending MEAN_SPECTRUM information back.");
+        uint16_t segment = in.u16();
+        if(!in.ok())
+        {
+            errorMessage("Incomplete MEAN_SPECTRUM command.");
+            break;
+        }
+        if((segment == 0) || (segment > MEAN_SPECTRUM_MAX_SEGMENT))
+            segment = MEAN_SPECTRUM_MAX_SEGMENT;
+        std::vector<float> magnitude;
+        uint32_t segments = to->getPlaneMeanSpectrum(segment & ~1u, magnitude);
+        stream_out out;
+        out.u16(CMD_MEAN_SPECTRUM);
+        out.u32(2*magnitude.size());
+        out.u32(segments);
+        out.u16(magnitude.size());
+        for(size_t k = 0; k < magnitude.size(); k++)
+            out.f32(magnitude[k]);
+        reply(out.finish());
+        break;
+    }
+    case CMD_START_DARKSUB:
+        statusMessage("Client requested CMD_START_DARKSUB, starting dark collection.");
+        to->startCapturingDSFMask();
+        break;
+    case CMD_STOP_DARKSUB:
+        statusMessage("Client requested CMD_STOP_DARKSUB, stopping dark collection.");
+        to->finishCapturingDSFMask();
+        break;
+    default:
+    {
+        std::ostringstream msg;
+        msg << "Unknown command received: 0x" << std::hex << commandType;
+        errorMessage(msg.str());
+        return false;
+    }
+    }
+    return true;
+}
+
+void command_server::reply(const std::vector<uint8_t> &block)
+{
+    size_t sent = 0;
+    while(sent < block.size())
+    {
+        ssize_t n = send(clientFd, block.data() + sent, block.size() - sent, MSG_NOSIGNAL);
+        if(n < 0)
+        {
+            if(errno == EINTR)
+                continue;
+            errorMessage(std::string("Reply not sent, ") + strerror(errno));
+            return;
+        }
+        sent += n;
+    }
+}
+
+void command_server::statusMessage(const std::string &message)
+{
+    std::cout << "[command_server]: Status: " << message << std::endl;
+}
+
+void command_server::errorMessage(const std::string &message)
+{
+    std::cerr << "[command_server]: ERROR: " << message << std::endl;
+}
@@ -0,0 +1,265 @@
+#include "daemon_config.hpp"
+#include "syntheticcamera.hpp"
+#include "product_schedule.hpp"
+#include "fft.hpp"
+
+#include <cstdlib>
+#include <cerrno>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+namespace
+{
+    std::string trim(const std::string &s)
+    {
+        size_t b = s.find_first_not_of(" \t\r");
+        if(b == std::string::npos)
+            return "";
+        size_t e = s.find_last_not_of(" \t\r");
+        return s.substr(b, e - b + 1);
+    }
+
+    bool parseBool(const std::string &v, bool &out)
+    {
+        std::string l = v;
+        std::transform(l.begin(), l.end(), l.begin(), ::tolower);
+        if((l == "true") || (l == "yes") || (l == "on") || (l == "1"))
+            out = true;
+        else if((l == "false") || (l == "no") || (l == "off") || (l == "0"))
+            out = false;
+        else
+            return false;
+        return true;
+    }
+
+    bool parseUnsigned(const std::string &v, unsigned long max, unsigned long &out)
+    {
+        if(v.empty() || (v[0] == '-'))
+            return false;
+        char *end = NULL;
+        errno = 0;
+        out = strtoul(v.c_str(), &end, 10);
+        return (errno == 0) && (*end == '\0') && (out <= max);
+    }
+
+    bool parseInt(const std::string &v, int &out)
+    {
+        char *end = NULL;
+        errno = 0;
+        long n = strtol(v.c_str(), &end, 10);
+        if(v.empty() || (errno != 0) || (*end != '\0') || (n < -1) || (n > 0xffff))
+            return false;
+        out = (int)n;
+        return true;
+    }
+
+    bool parseFloat(const std::string &v, float &out)
+    {
+        char *end = NULL;
+        errno = 0;
+        out = strtof(v.c_str(), &end);
+        return !v.empty() && (errno == 0) && (*end == '\0') && (out > 0);
+    }
+}
+
+daemon_config_t::daemon_config_t()
+{
+    options.headless = true;
+    options.xioDirectory = &xioDirectory;
+}
+
+bool load_daemon_config(const char *path, daemon_config_t &config, std::string &error)
+{
+    /*! \brief Read the file at path into config, which should be freshly constructed.
+     * Returns false, with the file and line in error, at the first line that cannot be used. */
+    std::ifstream in(path);
+    if(!in.is_open())
+    {
+        error = std::string("Cannot open ") + path;
+        return false;
+    }
+
+    takeOptionsType &o = config.options;
+    bool widthSet = false;
+    bool heightSet = false;
+    std::string line;
+    unsigned int lineNumber = 0;
+    while(std::getline(in, line))
+    {
+        lineNumber++;
+        size_t hash = line.find('#');
+        if(hash != std::string::npos)
+            line.erase(hash);
+        line = trim(line);
+        if(line.empty())
+            continue;
+
+        std::ostringstream where;
+        where << path << ":" << lineNumber << ": ";
+        size_t eq = line.find('=');
+        if(eq == std::string::npos)
+        {
+            error = where.str() + "expected key = value";
+            return false;
+        }
+        std::string key = trim(line.substr(0, eq));
+        std::string value = trim(line.substr(eq + 1));
+        unsigned long n = 0;
+        bool ok = true;
+
+        if(key == "camera") {
+            o.xioCam = (value == "xio");
+            o.rtpCam = (value == "rtp") || (value == "rtpnextgen");
+            o.rtpNextGen = (value == "rtpnextgen");
+            o.syntheticCam = (value == "synthetic");
+            ok = o.xioCam || o.rtpCam || o.syntheticCam || (value == "pdv");
+        } else if(key == "width") {
+            ok = parseUnsigned(value, 0xffff, n);
+            o.width = o.xioWidth = o.rtpWidth = o.syntheticWidth = (uint16_t)n;
+            widthSet = true;
+        } else if(key == "height") {
+            ok = parseUnsigned(value, 0xffff, n);
+            o.height = o.xioHeight = o.rtpHeight = o.syntheticHeight = (uint16_t)n;
+            heightSet = true;
+        } else if(key == "pdv_unit") {
+            ok = parseUnsigned(value, 0xffff, n);
+            o.pdvUnit = (unsigned int)n;
+        } else if(key == "pdv_channel") {
+            ok = parseInt(value, o.pdvChannel);
+        } else if(key == "xio_directory") {
+            config.xioDirectory = value;
+        } else if(key == "rtp_port") {
+            ok = parseUnsigned(value, 0xffff, n);
+            o.rtpPort = (int)n;
+        } else if(key == "rtp_address") {
+            config.rtpAddress = value;
+        } else if(key == "rtp_interface") {
+            config.rtpInterface = value;
+        } else if(key == "target_fps") {
+            ok = parseFloat(value, o.targetFPS);
+        } else if(key == "synthetic_fps") {
+            ok = parseFloat(value, o.syntheticFPS);
+        } else if(key == "synthetic_pattern") {
+            o.syntheticPattern = (value == "noise") ? SYNTHETIC_NOISE : SYNTHETIC_RAMP;
+            ok = (value == "noise") || (value == "ramp");
+        } else if(key == "synthetic_sigma") {
+            ok = parseFloat(value, o.syntheticSigma);
+        } else if(key == "synthetic_drop_every") {
+            ok = parseUnsigned(value, 0xffff, n);
+            o.syntheticDropEvery = (unsigned int)n;
+        } else if(key == "std_dev") {
+            ok = parseBool(value, o.runStdDevCalculation);
+        } else if(key == "no_gpu") {
+            ok = parseBool(value, o.noGPU);
+        } else if(key == "shm") {
+            ok = parseBool(value, o.useSHM);
+        } else if(key == "shm_name") {
+            config.shmName = value;
+            o.useSHM = true;
+        } else if(key == "instance") {
+            config.instanceName = value;
+        } else if(key == "multibufs") {
+            ok = parseUnsigned(value, 1024, n) && (n > 0);
+            o.pdvMultibufs = (unsigned int)n;
+        } else if(key == "ring_depth") {
+            ok = parseUnsigned(value, 1000000, n) && (n > 0);
+            o.frameRingDepth = (unsigned int)n;
+        } else if(key == "product_pool") {
+            ok = parseUnsigned(value, 100000, n) && (n > 0);
+            o.productPoolDepth = (unsigned int)n;
+        } else if(key == "thread_cpus") {
+            config.threadCpus = value;
+        } else if(key == "thread_rtprio") {
+            config.threadPriorities = value;
+        } else if(key == "mlock") {
+            ok = parseBool(value, o.lockMemory);
+        } else if(key == "graph_threads") {
+            ok = parseUnsigned(value, 256, n);
+            o.graphThreads = (unsigned int)n;
+        } else if((key == "means_rate") || (key == "std_dev_rate")) {
+            unsigned int &policy = (key == "means_rate") ? o.meansPolicy : o.stdDevPolicy;
+            if(value == "every")
+                policy = PRODUCT_EVERY_FRAME;
+            else if(value == "nth")
+                policy = PRODUCT_EVERY_NTH;
+            else if(value == "display")
+                policy = PRODUCT_DISPLAY_RATE;
+            else
+                ok = false;
+        } else if(key == "product_every") {
+            ok = parseUnsigned(value, 1000000, n) && (n > 0);
+            o.productEvery = (unsigned int)n;
+        } else if(key == "mean_history") {
+            ok = parseUnsigned(value, 100000000, n) && (n > 0);
+            o.meanHistory = (unsigned int)n;
+        } else if(key == "fft_window") {
+            if(value == "rect")
+                o.fftWindow = FFT_WINDOW_RECT;
+            else if(value == "hann")
+                o.fftWindow = FFT_WINDOW_HANN;
+            else if(value == "hamming")
+                o.fftWindow = FFT_WINDOW_HAMMING;
+            else if(value == "blackman")
+                o.fftWindow = FFT_WINDOW_BLACKMAN;
+            else
+                ok = false;
+        } else if(key == "hugepages") {
+            if((value == "2M") || (value == "2m"))
+                o.hugePageSize = 2;
+            else if((value == "1G") || (value == "1g"))
+                o.hugePageSize = 1024;
+            else if(value == "none")
+                o.hugePageSize = 0;
+            else
+                ok = false;
+        } else if(key == "numa_node") {
+            ok = parseInt(value, o.numaNode);
+        } else if(key == "dark_file") {
+            config.darkFile = value;
+        } else if(key == "data_location") {
+            config.dataLocation = value;
+            o.dataLocationSet = !value.empty();
+        } else if(key == "name_prefix") {
+            config.namePrefix = value;
+        } else if(key == "server_address") {
+            config.serverAddress = value;
+        } else if(key == "server_port") {
+            ok = parseUnsigned(value, 0xffff, n) && (n > 0);
+            config.serverPort = (uint16_t)n;
+        } else {
+            error = where.str() + "unknown key \"" + key + "\"";
+            return false;
+        }
+        if(!ok)
+        {
+            error = where.str() + "bad value \"" + value + "\" for " + key;
+            return false;
+        }
+    }
+
+    if(widthSet != heightSet)
+    {
+        error = std::string(path) + ": width and height must be given together";
+        return false;
+    }
+    o.heightWidthSet = widthSet && heightSet;
+    if(o.xioCam && config.xioDirectory.empty())
+    {
+        error = std::string(path) + ": camera = xio needs xio_directory";
+        return false;
+    }
+    if(o.noGPU)
+        o.runStdDevCalculation = false;
+
+    o.xioDirSet = !config.xioDirectory.empty();
+    o.havertpAddress = !config.rtpAddress.empty();
+    o.rtpAddress = o.havertpAddress ? config.rtpAddress.c_str() : NULL;
+    o.havertpInterface = !config.rtpInterface.empty();
+    o.rtpInterface = o.havertpInterface ? config.rtpInterface.c_str() : NULL;
+    o.shmName = config.shmName.empty() ? NULL : config.shmName.c_str();
+    o.instanceName = config.instanceName.empty() ? NULL : config.instanceName.c_str();
+    o.threadCpus = config.threadCpus.empty() ? NULL : config.threadCpus.c_str();
+    o.threadPriorities = config.threadPriorities.empty() ? NULL : config.threadPriorities.c_str();
+    return true;
+}
@@ -3,6 +3,7 @@
 //#include <cuda.h>
 //#include <cuda_runtime_api.h>
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #define HANDLE_ERROR(err) (HandleError( err, __FILE__, __LINE__ ))
 //Kernel code, this runs on the GPU (device)
@@ -117,9 +118,17 @@ dark_subtraction_filter::dark_subtraction_filter(int nWidth, int nHeight)
     mask_collected = false;
     width = nWidth;
     height = nHeight;
+    size_t numel = (size_t)width*height;
+    if( (posix_memalign((void **)&mask, 64, numel*sizeof(float)) != 0) ||
+        (posix_memalign((void **)&mask_accum, 64, numel*sizeof(double)) != 0) )
+    {
+        std::cerr << "dark_subtraction_filter: ERROR: could not allocate the mask for a " << width << "x" << height << " frame." << std::endl;
+        abort();
+    }
     for(unsigned int i = 0; i < width*height; i++)
     {
         mask[i]=0;
+        mask_accum[i]=0;
     }
 }
 dark_subtraction_filter::~dark_subtraction_filter()
@@ -127,4 +136,6 @@ dark_subtraction_filter::~dark_subtraction_filter()
     /*! When deallocating the filter, dark subtraction must be turned off to avoid
      * bad memory access. */
 	mask_collected = false; //Do this to prevent reading after object has been killed
+    free(mask);
+    free(mask_accum);
 }
@@ -1,135 +1,294 @@
 //Written by Noah
 #include "fft.hpp"
 #include <assert.h>
-#include <iostream>
-#define printComp(a) printf("%f+i%f,",creal(a),cimag(a))
-#define SWAPC(a,b) tempc = a; a = b; b = tempc;
-#define IS_POW2(n) (n & (n - 1)) == 0
-#define BIT_REVERSE(v,BASE) ( (unsigned int)( (BitReverseTable256[v & 0xff] << 24) | \
-		(BitReverseTable256[(v >> 8) & 0xff] << 16) | \
-		(BitReverseTable256[(v >> 16) & 0xff] << 8) | \
-		(BitReverseTable256[(v >> 24) & 0xff])  )) >> (32-BASE)
-
-std::complex<float> I(0,1);
-std::complex<float> tempc;
-
-static const unsigned char BitReverseTable256[] =
+#include <map>
+#include <mutex>
+
+namespace
+{
+    std::mutex planLock;
+    std::map<unsigned int, std::shared_ptr<const fft_plan> > plans;
+
+    std::complex<float> unit(double turns)
+    {
+        // exp(2 pi i turns), worked out in double so long transforms keep their accuracy
+        return std::complex<float>((float)cos(2*M_PI*turns), (float)sin(2*M_PI*turns));
+    }
+
+    void makeWindow(fft_window_t window, unsigned int n, std::vector<float> &values)
+    {
+        // Periodic windows, as spectral estimates use.
+        values.resize(n);
+        for(unsigned int j = 0; j < n; j++)
+        {
+            double x = 2*M_PI*j/n;
+            switch(window)
+            {
+            case FFT_WINDOW_HANN: values[j] = (float)(0.5 - 0.5*cos(x)); break;
+            case FFT_WINDOW_HAMMING: values[j] = (float)(0.54 - 0.46*cos(x)); break;
+            case FFT_WINDOW_BLACKMAN: values[j] = (float)(0.42 - 0.5*cos(x) + 0.08*cos(2*x)); break;
+            default: values[j] = 1; break;
+            }
+        }
+    }
+}
+
+const char *fft_window_name(fft_window_t window)
+{
+    switch(window)
+    {
+    case FFT_WINDOW_HANN: return "hann";
+    case FFT_WINDOW_HAMMING: return "hamming";
+    case FFT_WINDOW_BLACKMAN: return "blackman";
+    default: return "rect";
+    }
+}
+
+std::shared_ptr<const fft_plan> fft_plan::get(unsigned int n)
+{
+    /*! \brief The plan for n points, shared by every caller asking for n. */
+    assert(n > 0);
+    {
+        std::lock_guard<std::mutex> lock(planLock);
+        std::map<unsigned int, std::shared_ptr<const fft_plan> >::iterator found = plans.find(n);
+        if(found != plans.end())
+            return found->second;
+    }
+    // Made outside the lock, as it may ask for the plans it is built on.
+    std::shared_ptr<const fft_plan> plan(new fft_plan(n));
+    std::lock_guard<std::mutex> lock(planLock);
+    return plans.insert(std::make_pair(n, plan)).first->second;
+}
+
+fft_plan::fft_plan(unsigned int n) : n(n)
+{
+    pow2 = (n & (n - 1)) == 0;
+    if(pow2)
+    {
+        unsigned int bits = 0;
+        while((1u << bits) < n)
+            bits++;
+        bitReverse.resize(n);
+        for(unsigned int i = 0; i < n; i++)
+        {
+            unsigned int r = 0;
+            for(unsigned int b = 0; b < bits; b++)
+                r |= ((i >> b) & 1) << (bits - 1 - b);
+            bitReverse[i] = r;
+        }
+        twiddles.resize(n/2);
+        for(unsigned int k = 0; k < n/2; k++)
+            twiddles[k] = unit(-(double)k/n);
+    } else {
+        unsigned int m = 1;
+        while(m < 2*n - 1)
+            m <<= 1;
+        inner = fft_plan::get(m);
+        chirp.resize(n);
+        for(unsigned int k = 0; k < n; k++)
+            chirp[k] = unit(-(double)(((unsigned long long)k*k) % (2ull*n)) / (2.0*n));
+        // The conjugate chirp, wrapped to both ends so the circular convolution is
+        // the linear one; divided by m for the inverse transform done later.
+        chirpSpectrum.assign(m, std::complex<float>(0, 0));
+        chirpSpectrum[0] = std::conj(chirp[0]) / (float)m;
+        for(unsigned int k = 1; k < n; k++)
+            chirpSpectrum[k] = chirpSpectrum[m - k] = std::conj(chirp[k]) / (float)m;
+        std::vector<std::complex<float> > scratch;
+        inner->transform(chirpSpectrum.data(), scratch);
+    }
+    if((n % 2 == 0) && (n > 2))
+    {
+        half = fft_plan::get(n/2);
+        realTwiddles.resize(n/2);
+        for(unsigned int k = 0; k < n/2; k++)
+            realTwiddles[k] = unit(-(double)k/n);
+    }
+}
+
+void fft_plan::radix2(std::complex<float> *data) const
+{
+    for(unsigned int i = 0; i < n; i++)
+    {
+        unsigned int j = bitReverse[i];
+        if(i < j)
+            std::swap(data[i], data[j]);
+    }
+    for(unsigned int len = 2; len <= n; len <<= 1)
+    {
+        unsigned int stride = n / len; // W_len^r is W_n^(r*stride)
+        for(unsigned int index = 0; index < n; index += len)
+        {
+            for(unsigned int r = 0; r < len/2; r++)
+            {
+                std::complex<float> a = data[index + r];
+                std::complex<float> b = data[index + r + len/2] * twiddles[r*stride];
+                data[index + r] = a + b;
+                data[index + r + len/2] = a - b;
+            }
+        }
+    }
+}
+
+void fft_plan::bluestein(std::complex<float> *data, std::vector<std::complex<float> > &work) const
+{
+    // X[k] = chirp[k] * sum_j (x[j] chirp[j]) conj(chirp[k-j]), the sum done as a circular
+    // convolution of inner's size, and the inverse transform as a forward one of the conjugate.
+    unsigned int m = inner->size();
+    work.resize(m);
+    for(unsigned int k = 0; k < n; k++)
+        work[k] = data[k] * chirp[k];
+    for(unsigned int k = n; k < m; k++)
+        work[k] = 0;
+    inner->radix2(work.data());
+    for(unsigned int k = 0; k < m; k++)
+        work[k] = std::conj(work[k] * chirpSpectrum[k]);
+    inner->radix2(work.data());
+    for(unsigned int k = 0; k < n; k++)
+        data[k] = std::conj(work[k]) * chirp[k];
+}
+
+void fft_plan::transform(std::complex<float> *data, std::vector<std::complex<float> > &work) const
+{
+    if(pow2)
+        radix2(data);
+    else
+        bluestein(data, work);
+}
+
+void fft_plan::realTransform(const float *in, std::complex<float> *out, std::vector<std::complex<float> > &work) const
 {
-		0x00, 0x80, 0x40, 0xC0, 0x20, 0xA0, 0x60, 0xE0, 0x10, 0x90, 0x50, 0xD0, 0x30, 0xB0, 0x70, 0xF0,
-		0x08, 0x88, 0x48, 0xC8, 0x28, 0xA8, 0x68, 0xE8, 0x18, 0x98, 0x58, 0xD8, 0x38, 0xB8, 0x78, 0xF8,
-		0x04, 0x84, 0x44, 0xC4, 0x24, 0xA4, 0x64, 0xE4, 0x14, 0x94, 0x54, 0xD4, 0x34, 0xB4, 0x74, 0xF4,
-		0x0C, 0x8C, 0x4C, 0xCC, 0x2C, 0xAC, 0x6C, 0xEC, 0x1C, 0x9C, 0x5C, 0xDC, 0x3C, 0xBC, 0x7C, 0xFC,
-		0x02, 0x82, 0x42, 0xC2, 0x22, 0xA2, 0x62, 0xE2, 0x12, 0x92, 0x52, 0xD2, 0x32, 0xB2, 0x72, 0xF2,
-		0x0A, 0x8A, 0x4A, 0xCA, 0x2A, 0xAA, 0x6A, 0xEA, 0x1A, 0x9A, 0x5A, 0xDA, 0x3A, 0xBA, 0x7A, 0xFA,
-		0x06, 0x86, 0x46, 0xC6, 0x26, 0xA6, 0x66, 0xE6, 0x16, 0x96, 0x56, 0xD6, 0x36, 0xB6, 0x76, 0xF6,
-		0x0E, 0x8E, 0x4E, 0xCE, 0x2E, 0xAE, 0x6E, 0xEE, 0x1E, 0x9E, 0x5E, 0xDE, 0x3E, 0xBE, 0x7E, 0xFE,
-		0x01, 0x81, 0x41, 0xC1, 0x21, 0xA1, 0x61, 0xE1, 0x11, 0x91, 0x51, 0xD1, 0x31, 0xB1, 0x71, 0xF1,
-		0x09, 0x89, 0x49, 0xC9, 0x29, 0xA9, 0x69, 0xE9, 0x19, 0x99, 0x59, 0xD9, 0x39, 0xB9, 0x79, 0xF9,
-		0x05, 0x85, 0x45, 0xC5, 0x25, 0xA5, 0x65, 0xE5, 0x15, 0x95, 0x55, 0xD5, 0x35, 0xB5, 0x75, 0xF5,
-		0x0D, 0x8D, 0x4D, 0xCD, 0x2D, 0xAD, 0x6D, 0xED, 0x1D, 0x9D, 0x5D, 0xDD, 0x3D, 0xBD, 0x7D, 0xFD,
-		0x03, 0x83, 0x43, 0xC3, 0x23, 0xA3, 0x63, 0xE3, 0x13, 0x93, 0x53, 0xD3, 0x33, 0xB3, 0x73, 0xF3,
-		0x0B, 0x8B, 0x4B, 0xCB, 0x2B, 0xAB, 0x6B, 0xEB, 0x1B, 0x9B, 0x5B, 0xDB, 0x3B, 0xBB, 0x7B, 0xFB,
-		0x07, 0x87, 0x47, 0xC7, 0x27, 0xA7, 0x67, 0xE7, 0x17, 0x97, 0x57, 0xD7, 0x37, 0xB7, 0x77, 0xF7,
-		0x0F, 0x8F, 0x4F, 0xCF, 0x2F, 0xAF, 0x6F, 0xEF, 0x1F, 0x9F, 0x5F, 0xDF, 0x3F, 0xBF, 0x7F, 0xFF
-};
+    if(!half)
+    {
+        // Odd lengths, and n <= 2, are not worth splitting.
+        std::vector<std::complex<float> > full(in, in + n);
+        transform(full.data(), work);
+        for(unsigned int k = 0; k <= n/2; k++)
+            out[k] = full[k];
+        return;
+    }
+    // The even samples as the real part and the odd ones as the imaginary part,
+    // transformed together in out, then separated: with h = n/2 and Z that transform,
+    // X[k] = (Z[k] + conj(Z[h-k]))/2 - i W^k (Z[k] - conj(Z[h-k]))/2.
+    const unsigned int h = n/2;
+    for(unsigned int j = 0; j < h; j++)
+        out[j] = std::complex<float>(in[2*j], in[2*j + 1]);
+    half->transform(out, work);
+
+    const std::complex<float> i(0, 1);
+    std::complex<float> z0 = out[0];
+    out[0] = std::complex<float>(z0.real() + z0.imag(), 0);
+    out[h] = std::complex<float>(z0.real() - z0.imag(), 0);
+    for(unsigned int k = 1; k <= h/2; k++)
+    {
+        std::complex<float> a = out[k];
+        std::complex<float> b = std::conj(out[h - k]);
+        std::complex<float> even = (a + b) * 0.5f;
+        std::complex<float> odd = (a - b) * 0.5f;
+        out[k] = even - i * realTwiddles[k] * odd;
+        if(k != h - k)
+        {
+            // The same for h-k, whose even and odd parts are the conjugates of k's.
+            out[h - k] = std::conj(even) - i * realTwiddles[h - k] * std::conj(-odd);
+        }
+    }
+}
+
 fft::fft()
 {
-    /*! \brief Allocates memory for the complex array copy of the input series. */
-	CFFT = new std::complex<float>[MAX_FFT_SIZE];
+    /*! \brief Prepares the plan for FFT_INPUT_LENGTH points, which the filters use on every frame. */
+	prepare(FFT_INPUT_LENGTH);
 }
 fft::~fft() {
-	delete CFFT;
 }
-void fft::bitReverseOrder(std::complex<float> * arr, unsigned int len) //Overloaded for
+
+void fft::setWindow(fft_window_t window)
 {
-    /*! \brief Standard method for reversing the bits of a 2-byte number.
-     */
-	unsigned int base = (int)ceil(log10((float)len)/log10(2.0));
-	unsigned int i = 0;
-	//printf("base %u\n",base);
-	for(i = 0; i < len; i++)
-	{
-		unsigned int j = BIT_REVERSE(i,base);
-		if(i < j)
-		{
-			// printf("b4 swapc");
-			SWAPC(arr[i],arr[j]);
-		}
-	}
+    /*! \brief Selects the window applied by doRealFFT() and welch(). */
+    this->window = window;
+    unsigned int len = plan->size();
+    plan.reset();
+    prepare(len);
+}
+
+void fft::prepare(unsigned int len)
+{
+    if(plan && (plan->size() == len))
+        return;
+    plan = fft_plan::get(len);
+    spectrum.resize(len/2 + 1);
+    segmentIn.resize(len);
+    if(window == FFT_WINDOW_RECT)
+    {
+        windowValues.clear();
+        windowGain = 1;
+        return;
+    }
+    makeWindow(window, len, windowValues);
+    double sum = 0;
+    for(unsigned int j = 0; j < len; j++)
+        sum += windowValues[j];
+    windowGain = (float)(len / sum);
 }
 
-void fft::doRealFFT(float * real_arr, unsigned int ring_head,float *fft_real_result)
+void fft::doRealFFT(const float * real_arr, unsigned int ring_head, float *fft_real_result, unsigned int ring_length)
 {
     /*! \brief Topmost function for calculating the FFT of the time series.
      * \param real_arr The input series to the function.
      * \param ring_head The current position in the ring buffer, if applicable.
      * \param fft_real_result The output of real FFT magnitudes.
+     * \param ring_length The length of the ring buffer, at least FFT_INPUT_LENGTH.
      */
-	CFFT  =  doFFT(real_arr, ring_head);
-	double max = 0;
-	
-	//std::cout<<"Ring head late= "<< ring_head<< std::endl;
-	//realFFT[len/2] = (float) std::real(CFFT[len/2]);
-	for(unsigned int i = 0; i < FFT_INPUT_LENGTH/2; i++)
+	prepare(FFT_INPUT_LENGTH);
+	for(unsigned int i = 0; i < FFT_INPUT_LENGTH; i++)
 	{
-		fft_real_result[i] = std::abs(CFFT[i]);
-		if(fft_real_result[i] > max && i !=0)
-		{
-            max = fft_real_result[i];
-		}
+		unsigned int p = ring_head + i;
+		if(p >= ring_length)
+			p -= ring_length;
+		segmentIn[i] = windowValues.empty() ? real_arr[p] : real_arr[p] * windowValues[i];
 	}
-	//printf("max nonconst in fft:%f\n",max);
-
-
+	plan->realTransform(segmentIn.data(), spectrum.data(), work);
+	for(unsigned int i = 0; i < FFT_INPUT_LENGTH/2; i++)
+		fft_real_result[i] = std::abs(spectrum[i]) * windowGain;
 }
-std::complex<float> * fft::doFFT(float * real_arr, unsigned int ring_head)
+
+unsigned int fft::welch(const float *series, unsigned int length, unsigned int segment, float *magnitude)
 {
-    /*! \brief Middle layer function which converts the series to a complex-valued array.
-     *
-     * Also passes the array to the method which actually calculates the FFT of the complex input
-     * array.
+    /*! \brief Welch's average of the spectra of a series.
+     * \param series The series, oldest first.
+     * \param length Number of values in series.
+     * \param segment Points in each transform, even. Each segment starts segment/2 after the last.
+     * \param magnitude The output, the square root of the mean power of each of segment/2 frequencies.
      */
-	for(unsigned int i = 0; i < FFT_INPUT_LENGTH; i++)
-	{
-        CFFT[i] = std::complex<float>(real_arr[(ring_head+i) % FFT_MEAN_BUFFER_LENGTH],0);
-	}
-	return doFFT(CFFT,FFT_INPUT_LENGTH);
+    if((segment < 2) || (segment % 2) || (length < segment))
+        return 0;
+    prepare(segment);
+    const unsigned int step = segment/2;
+    const unsigned int segments = (length - segment)/step + 1;
+    power.assign(segment/2, 0);
+    for(unsigned int s = 0; s < segments; s++)
+    {
+        const float *in = series + (size_t)s*step;
+        if(!windowValues.empty())
+        {
+            for(unsigned int j = 0; j < segment; j++)
+                segmentIn[j] = in[j] * windowValues[j];
+            in = segmentIn.data();
+        }
+        plan->realTransform(in, spectrum.data(), work);
+        for(unsigned int k = 0; k < segment/2; k++)
+            power[k] += std::norm(spectrum[k]);
+    }
+    for(unsigned int k = 0; k < segment/2; k++)
+        magnitude[k] = (float)sqrt(power[k] / segments) * windowGain;
+    return segments;
 }
+
 std::complex<float> * fft::doFFT(std::complex<float> * arr, unsigned int len)
 {
-    /*! \brief Calculate the FFT on the complex input array
-     *
-     * This is a textbook method for calculating the FFT. The function asserts that the input array has a length that
-     * is a power of 2 and the length is less than the maximum allowed length.
+    /*! \brief Calculate the FFT on the complex input array, in place.
      * \param arr Complex form of the input time series.
-     * \param len Number of elements in the array parameter, here set to the FFT_INPUT_LENGTH macro.
+     * \param len Number of elements in the array parameter, any length.
      */
-    assert(IS_POW2(len));
-    assert(len <= MAX_FFT_SIZE);
-	bitReverseOrder(arr,len);
-	//printf("doing fft\n");
-	unsigned int base = (int)ceil(log10((float)len)/log10(2.0));
-
-	std::complex<float> Wn = std::exp(std::complex<float>(0,-1.0f*2*M_PI/len)); //For twiddle factors
-
-	for(unsigned int stage = 1; stage <= base; stage++)
-	{
-		unsigned int N = pow(2,stage);
-		//float complex Wn = cexp(((float complex)-2*M_PI)*I/N);
-		//printf("on stage:%u N=%u Wn=%f+i%f\n",stage,N,creal(Wn),cimag(Wn));
-		for(unsigned int index = 0; index < len; index+=N)
-		{
-			for(unsigned int r = 0; r < N/2; r++)
-			{
-				std::complex<float> a = arr[index+r]; //Save temp values to avoid data availability problem
-				std::complex<float> b = arr[index+r+N/2];
-				std::complex<float> exponent =(len/N)*r;
-				std::complex<float> twiddle = std::pow(Wn,exponent); //This twiddle is equivalent to global N twiddle seen in some books (i.e. W_8^2 = W_4^1)
-				arr[index+r] = a + b*twiddle;
-				arr[index+r+N/2] = a - b*twiddle;
-			}
-
-		}
-	}
+	fft_plan::get(len)->transform(arr, work);
 	return arr;
 }
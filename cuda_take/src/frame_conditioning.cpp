@@ -0,0 +1,144 @@
+#include "frame_conditioning.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define FRAME_CONDITIONING_X86
+#endif
+
+frame_conditioner_t select_frame_conditioner(bool twosCompliment, bool invert)
+{
+    /*! \brief Returns the condition_frame instantiation for the requested stage set. */
+    static const frame_conditioner_t table[4] = {
+        &condition_frame<false, false>,
+        &condition_frame<false, true>,
+        &condition_frame<true, false>,
+        &condition_frame<true, true>
+    };
+    return table[(twosCompliment?2:0) + (invert?1:0)];
+}
+
+template <bool twosCompliment, bool invert>
+static inline void fused_condition_tail(uint16_t *dst, float *darkOut, const uint16_t *src, const float *mask,
+                                        size_t begin, size_t numel, uint16_t invFactor)
+{
+    for(size_t i = begin; i < numel; i++)
+    {
+        uint16_t v = src[i];
+        if(twosCompliment)
+            v ^= (1<<15);
+        if(invert)
+            v = invFactor - v;
+        dst[i] = v;
+        darkOut[i] = (float)v - mask[i];
+    }
+}
+
+template <bool twosCompliment, bool invert>
+static void fused_condition_scalar(uint16_t *dst, float *darkOut, const uint16_t *src, const float *mask,
+                                   size_t numel, uint16_t invFactor)
+{
+    fused_condition_tail<twosCompliment, invert>(dst, darkOut, src, mask, 0, numel, invFactor);
+}
+
+#ifdef FRAME_CONDITIONING_X86
+template <bool twosCompliment, bool invert>
+__attribute__((target("sse2")))
+static void fused_condition_sse2(uint16_t *dst, float *darkOut, const uint16_t *src, const float *mask,
+                                 size_t numel, uint16_t invFactor)
+{
+    const __m128i signBit = _mm_set1_epi16((short)0x8000);
+    const __m128i factor = _mm_set1_epi16((short)invFactor);
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    for(; i + 8 <= numel; i += 8)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+        if(twosCompliment)
+            v = _mm_xor_si128(v, signBit);
+        if(invert)
+            v = _mm_sub_epi16(factor, v);
+        _mm_storeu_si128((__m128i *)(dst + i), v);
+
+        __m128 lo = _mm_cvtepi32_ps(_mm_unpacklo_epi16(v, zero));
+        __m128 hi = _mm_cvtepi32_ps(_mm_unpackhi_epi16(v, zero));
+        _mm_storeu_ps(darkOut + i, _mm_sub_ps(lo, _mm_loadu_ps(mask + i)));
+        _mm_storeu_ps(darkOut + i + 4, _mm_sub_ps(hi, _mm_loadu_ps(mask + i + 4)));
+    }
+    fused_condition_tail<twosCompliment, invert>(dst, darkOut, src, mask, i, numel, invFactor);
+}
+
+template <bool twosCompliment, bool invert>
+__attribute__((target("avx2")))
+static void fused_condition_avx2(uint16_t *dst, float *darkOut, const uint16_t *src, const float *mask,
+                                 size_t numel, uint16_t invFactor)
+{
+    const __m256i signBit = _mm256_set1_epi16((short)0x8000);
+    const __m256i factor = _mm256_set1_epi16((short)invFactor);
+    size_t i = 0;
+    for(; i + 16 <= numel; i += 16)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(src + i));
+        if(twosCompliment)
+            v = _mm256_xor_si256(v, signBit);
+        if(invert)
+            v = _mm256_sub_epi16(factor, v);
+        _mm256_storeu_si256((__m256i *)(dst + i), v);
+
+        __m256 lo = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm256_castsi256_si128(v)));
+        __m256 hi = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm256_extracti128_si256(v, 1)));
+        _mm256_storeu_ps(darkOut + i, _mm256_sub_ps(lo, _mm256_loadu_ps(mask + i)));
+        _mm256_storeu_ps(darkOut + i + 8, _mm256_sub_ps(hi, _mm256_loadu_ps(mask + i + 8)));
+    }
+    fused_condition_tail<twosCompliment, invert>(dst, darkOut, src, mask, i, numel, invFactor);
+}
+#endif
+
+enum fused_isa_t {ISA_SCALAR = 0, ISA_SSE2 = 1, ISA_AVX2 = 2};
+
+static fused_isa_t detect_fused_isa()
+{
+#ifdef FRAME_CONDITIONING_X86
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2"))
+        return ISA_AVX2;
+    if(__builtin_cpu_supports("sse2"))
+        return ISA_SSE2;
+#endif
+    return ISA_SCALAR;
+}
+
+static fused_isa_t fused_isa()
+{
+    static const fused_isa_t isa = detect_fused_isa();
+    return isa;
+}
+
+fused_conditioner_t select_fused_conditioner(bool twosCompliment, bool invert)
+{
+    /*! \brief Returns the fastest fused conditioner supported by this CPU for the requested stage set. */
+    static const fused_conditioner_t table[3][4] = {
+        { &fused_condition_scalar<false, false>, &fused_condition_scalar<false, true>,
+          &fused_condition_scalar<true, false>, &fused_condition_scalar<true, true> },
+#ifdef FRAME_CONDITIONING_X86
+        { &fused_condition_sse2<false, false>, &fused_condition_sse2<false, true>,
+          &fused_condition_sse2<true, false>, &fused_condition_sse2<true, true> },
+        { &fused_condition_avx2<false, false>, &fused_condition_avx2<false, true>,
+          &fused_condition_avx2<true, false>, &fused_condition_avx2<true, true> }
+#else
+        { NULL, NULL, NULL, NULL },
+        { NULL, NULL, NULL, NULL }
+#endif
+    };
+    return table[fused_isa()][(twosCompliment?2:0) + (invert?1:0)];
+}
+
+const char *fused_conditioner_isa()
+{
+    /*! \brief Name of the instruction set used by select_fused_conditioner, for status messages. */
+    switch(fused_isa())
+    {
+    case ISA_AVX2: return "AVX2";
+    case ISA_SSE2: return "SSE2";
+    default: return "scalar";
+    }
+}
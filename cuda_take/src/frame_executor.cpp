@@ -0,0 +1,189 @@
+#include "frame_executor.hpp"
+
+namespace
+{
+    // Index of the worker running on this thread, or -1 for any other thread.
+    thread_local int currentWorker = -1;
+    thread_local const void *currentExecutor = NULL;
+}
+
+frame_executor::frame_executor()
+{
+    nextWorker.store(0);
+    queued.store(0);
+    sleeping.store(0);
+    running.store(false);
+    stealCount.store(0);
+}
+
+frame_executor::~frame_executor()
+{
+    stop();
+}
+
+void frame_executor::start(unsigned int workerCount, const char *name)
+{
+    /*! \brief Start workerCount threads, named name0, name1, ...
+     * The names are limited to 15 characters by pthread_setname_np, so name should be short. */
+    stop();
+    if(workerCount == 0)
+        workerCount = 1;
+    baseName = name;
+    running.store(true);
+    for(unsigned int w = 0; w < workerCount; w++)
+        workers.emplace_back(new worker_t);
+    for(unsigned int w = 0; w < workerCount; w++)
+    {
+        workers[w]->thread = std::thread(&frame_executor::workerLoop, this, w);
+        pthread_setname_np(workers[w]->thread.native_handle(), threadName(w).c_str());
+    }
+}
+
+void frame_executor::stop()
+{
+    /*! \brief Run every queued task, then join the workers.
+     * Tasks submitted by those tasks are run as well, so a strand is always drained. */
+    if(workers.empty())
+        return;
+    {
+        std::lock_guard<std::mutex> guard(sleepLock);
+        running.store(false);
+    }
+    wake.notify_all();
+    for(size_t w = 0; w < workers.size(); w++)
+    {
+        if(workers[w]->thread.joinable())
+            workers[w]->thread.join();
+    }
+    workers.clear();
+}
+
+void frame_executor::submit(task_t task)
+{
+    /*! \brief Queue a task. From a worker the task goes on that worker's own deque, otherwise the workers take turns. */
+    if(workers.empty())
+    {
+        task(); // not started, run inline
+        return;
+    }
+    unsigned int w;
+    if((currentExecutor == this) && (currentWorker >= 0))
+        w = (unsigned int)currentWorker;
+    else
+        w = nextWorker.fetch_add(1, std::memory_order_relaxed) % workers.size();
+    {
+        std::lock_guard<std::mutex> guard(workers[w]->lock);
+        workers[w]->tasks.push_back(std::move(task));
+    }
+    // Sequentially consistent, paired with the sleeping/queued pair in
+    // workerLoop, so a worker cannot go to sleep on a task just queued.
+    queued.fetch_add(1);
+    if(sleeping.load() > 0)
+    {
+        std::lock_guard<std::mutex> guard(sleepLock);
+        wake.notify_one();
+    }
+}
+
+pthread_t frame_executor::nativeHandle(unsigned int worker)
+{
+    return workers.at(worker)->thread.native_handle();
+}
+
+std::string frame_executor::threadName(unsigned int worker) const
+{
+    return baseName + std::to_string(worker);
+}
+
+bool frame_executor::take(unsigned int self, task_t &task)
+{
+    // Newest of our own tasks first, then the oldest task of the others.
+    {
+        worker_t &own = *workers[self];
+        std::lock_guard<std::mutex> guard(own.lock);
+        if(!own.tasks.empty())
+        {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            queued.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    for(size_t n = 1; n < workers.size(); n++)
+    {
+        worker_t &victim = *workers[(self + n) % workers.size()];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if(!victim.tasks.empty())
+        {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            queued.fetch_sub(1, std::memory_order_relaxed);
+            stealCount.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+void frame_executor::workerLoop(unsigned int self)
+{
+    currentWorker = (int)self;
+    currentExecutor = this;
+    task_t task;
+    while(true)
+    {
+        if(take(self, task))
+        {
+            task();
+            task = nullptr;
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepLock);
+        if(!running.load() && (queued.load(std::memory_order_acquire) == 0))
+            break;
+        sleeping.fetch_add(1);
+        wake.wait(lock, [this] { return (queued.load() > 0) || !running.load(); });
+        sleeping.fetch_sub(1);
+    }
+    currentWorker = -1;
+    currentExecutor = NULL;
+}
+
+void frame_strand::post(frame_executor::task_t task)
+{
+    /*! \brief Queue task to run after every task posted to this strand before it. */
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        pending.push_back(std::move(task));
+        if(active)
+            return;
+        active = true;
+    }
+    executor->submit([this] { drain(); });
+}
+
+void frame_strand::bind(frame_executor &executor)
+{
+    /*! \brief Run later tasks on executor. Only call this while nothing is posted to the strand. */
+    std::lock_guard<std::mutex> guard(lock);
+    this->executor = &executor;
+}
+
+void frame_strand::drain()
+{
+    frame_executor::task_t task;
+    while(true)
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            if(pending.empty())
+            {
+                active = false;
+                return;
+            }
+            task = std::move(pending.front());
+            pending.pop_front();
+        }
+        task();
+    }
+}
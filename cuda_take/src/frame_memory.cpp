@@ -0,0 +1,321 @@
+#include "frame_memory.hpp"
+#include "constants.h"
+
+#include <cstring>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <system_error>
+#include <thread>
+#include <vector>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#ifndef CPU_ONLY
+#include "cuda_runtime.h"
+#endif
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+#ifndef MAP_HUGE_2MB
+#define MAP_HUGE_2MB (21 << MAP_HUGE_SHIFT)
+#endif
+#ifndef MAP_HUGE_1GB
+#define MAP_HUGE_1GB (30 << MAP_HUGE_SHIFT)
+#endif
+#ifndef MPOL_PREFERRED
+#define MPOL_PREFERRED 1
+#endif
+
+namespace
+{
+    const size_t hugePage2M = (size_t)2 << 20;
+    const size_t hugePage1G = (size_t)1 << 30;
+    const size_t parallelTouchBytes = (size_t)64 << 20; // smaller ranges are touched by the calling thread
+
+    struct region_t {
+        size_t mappedBytes;
+        size_t requestedBytes;
+        frame_memory::backing_t backing;
+        bool pinned;
+        bool pinPending; // made by reserve(), to be pinned by complete()
+    };
+
+    std::mutex regionLock;
+    std::map<const void *, region_t> regions;
+    size_t backingBytes[frame_memory::BACKING_COUNT] = {0};
+    frame_memory::page_size_t policyPages = frame_memory::PAGES_NORMAL;
+    int policyNode = -1;
+
+    size_t roundUp(size_t bytes, size_t unit)
+    {
+        return (bytes + unit - 1) / unit * unit;
+    }
+
+    void *mapHuge(size_t bytes, size_t pageBytes, int sizeFlag, size_t &mapped)
+    {
+        mapped = roundUp(bytes, pageBytes);
+        void *p = mmap(NULL, mapped, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | sizeFlag, -1, 0);
+        return (p == MAP_FAILED) ? NULL : p;
+    }
+
+    void bindToNode(void *p, size_t bytes, int node)
+    {
+        // Called before the first touch. A failure (no NUMA support, or an
+        // out of range node) leaves the default first-touch placement.
+        if((node < 0) || (node >= (int)(8*sizeof(unsigned long))))
+            return;
+        unsigned long mask = 1UL << node;
+        syscall(SYS_mbind, p, bytes, MPOL_PREFERRED, &mask, 8*sizeof(unsigned long), 0);
+    }
+
+    void touchRange(char *begin, char *end)
+    {
+        // One write per page faults it in. The first write is at begin rather
+        // than at its page boundary, so that nothing outside the range is
+        // written: the neighbouring frames of the ring may be in use.
+        const uintptr_t page = 4096;
+        for(char *c = begin; c < end; c = (char *)(((uintptr_t)c + page) & ~(page - 1)))
+            *(volatile char *)c = 0;
+    }
+
+    void touchPages(char *begin, size_t bytes)
+    {
+        // The kernel zeroes each page as it is faulted in, which is most of the
+        // cost of a large region, so large ranges are split between threads.
+        unsigned int threads = std::thread::hardware_concurrency();
+        if(threads > FRAME_MEMORY_TOUCH_THREADS)
+            threads = FRAME_MEMORY_TOUCH_THREADS;
+        if((bytes < parallelTouchBytes) || (threads < 2))
+        {
+            touchRange(begin, begin + bytes);
+            return;
+        }
+        size_t share = bytes / threads;
+        std::vector<std::thread> workers;
+        for(unsigned int t = 1; t < threads; t++)
+        {
+            char *first = begin + share*t;
+            char *last = (t == threads - 1) ? begin + bytes : first + share;
+            try {
+                workers.push_back(std::thread(touchRange, first, last));
+            } catch(const std::system_error &) {
+                touchRange(first, last); // out of threads, do it here
+            }
+        }
+        touchRange(begin, begin + share);
+        for(size_t w = 0; w < workers.size(); w++)
+            workers[w].join();
+    }
+}
+
+void frame_memory::setPolicy(page_size_t pages, int numaNode)
+{
+    std::lock_guard<std::mutex> lock(regionLock);
+    policyPages = pages;
+    policyNode = numaNode;
+}
+
+frame_memory::page_size_t frame_memory::pageSize()
+{
+    std::lock_guard<std::mutex> lock(regionLock);
+    return policyPages;
+}
+
+int frame_memory::numaNode()
+{
+    std::lock_guard<std::mutex> lock(regionLock);
+    return policyNode;
+}
+
+void *frame_memory::allocate(size_t bytes, bool pinned)
+{
+    /*! \brief Allocate a zeroed, page aligned region of at least bytes, following the current policy.
+     * \param bytes Size of the region
+     * \param pinned Also register the region with CUDA as page-locked, portable memory
+     *
+     * Returns NULL if no backing at all could be found, or if a pinned region could not be registered.
+     * A size which is not a whole number of huge pages is rounded up, so the 1 GiB size is only tried
+     * for regions of at least 1 GiB.
+     */
+    void *p = reserve(bytes, pinned);
+    if(p == NULL)
+        return NULL;
+    populate(p, 0, bytes);
+    if(!complete(p))
+    {
+        release(p);
+        return NULL;
+    }
+    return p;
+}
+
+void *frame_memory::reserve(size_t bytes, bool pinned)
+{
+    /*! \brief Map and bind a region as allocate() does, without touching it.
+     * The region reads as zero. Call populate() on each range before it is used by a thread which must not page
+     * fault, and complete() once the whole region is populated; a pinned region is only pinned then.
+     */
+    if(bytes == 0)
+        return NULL;
+
+    page_size_t pages;
+    int node;
+    {
+        std::lock_guard<std::mutex> lock(regionLock);
+        pages = policyPages;
+        node = policyNode;
+    }
+
+    void *p = NULL;
+    size_t mapped = 0;
+    backing_t kind = BACKING_NORMAL;
+    if((pages == PAGES_1G) && (bytes >= hugePage1G))
+    {
+        p = mapHuge(bytes, hugePage1G, MAP_HUGE_1GB, mapped);
+        kind = BACKING_HUGETLB_1G;
+    }
+    if((p == NULL) && (pages != PAGES_NORMAL))
+    {
+        p = mapHuge(bytes, hugePage2M, MAP_HUGE_2MB, mapped);
+        kind = BACKING_HUGETLB_2M;
+    }
+    if(p == NULL)
+    {
+        mapped = roundUp(bytes, (size_t)sysconf(_SC_PAGESIZE));
+        p = mmap(NULL, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(p == MAP_FAILED)
+            return NULL;
+        kind = BACKING_NORMAL;
+        if((pages != PAGES_NORMAL) && (madvise(p, mapped, MADV_HUGEPAGE) == 0))
+            kind = BACKING_TRANSPARENT;
+    }
+
+    bindToNode(p, mapped, node); // before any page is touched
+
+    std::lock_guard<std::mutex> lock(regionLock);
+    region_t r;
+    r.mappedBytes = mapped;
+    r.requestedBytes = bytes;
+    r.backing = kind;
+    r.pinned = false;
+    r.pinPending = pinned;
+    regions[p] = r;
+    backingBytes[kind] += bytes;
+    return p;
+}
+
+void frame_memory::populate(void *region, size_t offset, size_t bytes)
+{
+    /*! \brief Fault in bytes of a region from reserve(), starting at offset, on its bound node.
+     * Only the bytes of the range are written, so other ranges of the region may be in use meanwhile. */
+    size_t mapped = 0;
+    {
+        std::lock_guard<std::mutex> lock(regionLock);
+        std::map<const void *, region_t>::const_iterator it = regions.find(region);
+        if(it != regions.end())
+            mapped = it->second.mappedBytes;
+    }
+    if(offset >= mapped)
+        return;
+    if(bytes > mapped - offset)
+        bytes = mapped - offset;
+    touchPages((char *)region + offset, bytes);
+}
+
+bool frame_memory::complete(void *region)
+{
+    /*! \brief Pin a region from reserve() which asked for it, once every range has been populated.
+     * Returns false only if CUDA could not register the region, which then stays usable as pageable memory. */
+    size_t mapped = 0;
+    {
+        std::lock_guard<std::mutex> lock(regionLock);
+        std::map<const void *, region_t>::const_iterator it = regions.find(region);
+        if((it == regions.end()) || !it->second.pinPending)
+            return true;
+        mapped = it->second.mappedBytes;
+    }
+#ifdef CPU_ONLY
+    bool pinned = (mlock(region, mapped) == 0); // over RLIMIT_MEMLOCK, the region is still usable
+    bool ok = true;
+#else
+    bool pinned = (cudaHostRegister(region, mapped, cudaHostRegisterPortable) == cudaSuccess);
+    bool ok = pinned;
+#endif
+    std::lock_guard<std::mutex> lock(regionLock);
+    region_t &r = regions[region];
+    r.pinPending = false;
+    r.pinned = pinned;
+    return ok;
+}
+
+void frame_memory::release(void *region)
+{
+    /*! \brief Return a region obtained from allocate(). NULL is ignored. */
+    if(region == NULL)
+        return;
+    region_t r;
+    {
+        std::lock_guard<std::mutex> lock(regionLock);
+        std::map<const void *, region_t>::iterator it = regions.find(region);
+        if(it == regions.end())
+            return;
+        r = it->second;
+        backingBytes[r.backing] -= r.requestedBytes;
+        regions.erase(it);
+    }
+#ifdef CPU_ONLY
+    if(r.pinned)
+        munlock(region, r.mappedBytes);
+#else
+    if(r.pinned)
+        cudaHostUnregister(region);
+#endif
+    munmap(region, r.mappedBytes);
+}
+
+frame_memory::backing_t frame_memory::backing(const void *region)
+{
+    std::lock_guard<std::mutex> lock(regionLock);
+    std::map<const void *, region_t>::const_iterator it = regions.find(region);
+    if(it == regions.end())
+        return BACKING_NORMAL;
+    return it->second.backing;
+}
+
+const char *frame_memory::backingName(backing_t backing)
+{
+    switch(backing)
+    {
+    case BACKING_HUGETLB_1G: return "1 GiB huge pages";
+    case BACKING_HUGETLB_2M: return "2 MiB huge pages";
+    case BACKING_TRANSPARENT: return "transparent huge pages";
+    default: return "normal pages";
+    }
+}
+
+std::string frame_memory::describe()
+{
+    /*! \brief One line summary of the live regions by backing, e.g. for the startup status messages. */
+    std::lock_guard<std::mutex> lock(regionLock);
+    std::ostringstream out;
+    out.precision(1);
+    out << std::fixed << "Frame memory backing:";
+    bool any = false;
+    for(int b = 0; b < BACKING_COUNT; b++)
+    {
+        if(backingBytes[b] == 0)
+            continue;
+        out << (any ? ", " : " ") << backingBytes[b]/(1024.0*1024.0) << " MiB on " << backingName((backing_t)b);
+        any = true;
+    }
+    if(!any)
+        out << " none";
+    if(policyNode >= 0)
+        out << ", preferring NUMA node " << policyNode;
+    out << ".";
+    return out.str();
+}
@@ -0,0 +1,190 @@
+#include "frame_metadata.hpp"
+
+#include <chrono>
+
+namespace
+{
+    struct header_layout_t {
+        const char *name;
+        bool present;
+        unsigned int counterPixel;
+        unsigned int statusPixel;
+    };
+
+    const header_layout_t noHeader = { "no line header", false, 0, 0 };
+    const header_layout_t header6604A = { "6604A line header", true, 160, 159 };
+
+    const char *sourceNames[FRAME_SOURCE_COUNT] = {
+        "camera link",
+        "RTP NextGen",
+        "RTP",
+        "XIO",
+        "synthetic"
+    };
+
+    // The streamed, recorded and synthetic frames all come from, or imitate,
+    // the 6604A instruments.
+    const header_layout_t *sourceLayouts[FRAME_SOURCE_COUNT] = {
+        NULL, // camera link: by camera type, see cameraLayout()
+        &header6604A,
+        &header6604A,
+        &header6604A,
+        &header6604A
+    };
+
+    const header_layout_t &cameraLayout(camera_t camera)
+    {
+        switch(camera)
+        {
+        case CL_6604A: return header6604A;
+        default: return noHeader;
+        }
+    }
+}
+
+const char *frame_source_name(frame_source_t source)
+{
+    if((source < 0) || (source >= FRAME_SOURCE_COUNT))
+        return "unknown";
+    return sourceNames[source];
+}
+
+frame_metadata_decoder::frame_metadata_decoder(frame_source_t source, camera_t camera)
+{
+    /*! \brief The line header layout of a source.
+     * \param source Where the frames come from
+     * \param camera The camera type, only looked at for camera link, which has cameras without a header
+     */
+    if((source < 0) || (source >= FRAME_SOURCE_COUNT))
+        source = FRAME_SOURCE_PDV;
+    src = source;
+    const header_layout_t &l = (sourceLayouts[source] != NULL) ? *sourceLayouts[source] : cameraLayout(camera);
+    layout = l.name;
+    hasHeader = l.present;
+    counterPixel = l.counterPixel;
+    statusPixel = l.statusPixel;
+}
+
+frame_continuity::frame_continuity()
+{
+    reset();
+}
+
+void frame_continuity::reset()
+{
+    /*! \brief Forget the last counter and zero the totals, e.g. when the source changes. Not safe during observe(). */
+    haveLast = false;
+    last = 0;
+    behindRun = 0;
+    checked.store(0);
+    unchecked.store(0);
+    dropped.store(0);
+    repeated.store(0);
+    outOfOrder.store(0);
+    resyncs.store(0);
+    gaps.store(0);
+    lastHeader.store(0);
+    std::lock_guard<std::mutex> lock(gapLock);
+    for(unsigned int g = 0; g < FRAME_GAP_HISTORY; g++)
+        gapHistory[g] = frame_gap_t();
+}
+
+bool frame_continuity::observe(const frame_metadata_t &meta, uint64_t frame)
+{
+    /*! \brief Account for the next frame from the acquisition thread.
+     * \param meta The decoded line header of the frame
+     * \param frame The running frame count, kept with any gap
+     * Returns true if the frame follows a gap, so the caller may warn about it.
+     */
+    if(!meta.valid)
+    {
+        unchecked.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    checked.fetch_add(1, std::memory_order_relaxed);
+    lastHeader.store((uint32_t)meta.counter | ((uint32_t)meta.obcStatus << 16), std::memory_order_relaxed);
+    if(!haveLast)
+    {
+        haveLast = true;
+        last = meta.counter;
+        return false;
+    }
+
+    // The counter wraps at 16 bits, so a step of up to half the range
+    // forward is a gap, and anything further is a frame from behind.
+    uint16_t step = (uint16_t)(meta.counter - last);
+    if(step == 1)
+    {
+        last = meta.counter;
+        behindRun = 0;
+        return false;
+    }
+    if(step == 0)
+    {
+        repeated.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    if(step >= 0x8000)
+    {
+        outOfOrder.fetch_add(1, std::memory_order_relaxed);
+        if(++behindRun >= FRAME_CONTINUITY_RESYNC)
+        {
+            resyncs.fetch_add(1, std::memory_order_relaxed);
+            last = meta.counter;
+            behindRun = 0;
+        }
+        return false;
+    }
+
+    frame_gap_t gap;
+    gap.time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+    gap.frame = frame;
+    gap.expected = (uint16_t)(last + 1);
+    gap.received = meta.counter;
+    gap.missing = step - 1;
+    {
+        std::lock_guard<std::mutex> lock(gapLock);
+        gapHistory[gaps.load(std::memory_order_relaxed) % FRAME_GAP_HISTORY] = gap;
+        gaps.fetch_add(1, std::memory_order_relaxed);
+    }
+    dropped.fetch_add(gap.missing, std::memory_order_relaxed);
+    last = meta.counter;
+    behindRun = 0;
+    return true;
+}
+
+frame_continuity_summary frame_continuity::summary() const
+{
+    /*! \brief The totals since the last reset(). May be called from any thread. */
+    frame_continuity_summary s;
+    s.checked = checked.load(std::memory_order_relaxed);
+    s.unchecked = unchecked.load(std::memory_order_relaxed);
+    s.dropped = dropped.load(std::memory_order_relaxed);
+    s.repeated = repeated.load(std::memory_order_relaxed);
+    s.outOfOrder = outOfOrder.load(std::memory_order_relaxed);
+    s.resyncs = resyncs.load(std::memory_order_relaxed);
+    uint32_t header = lastHeader.load(std::memory_order_relaxed);
+    s.lastCounter = (uint16_t)(header & 0xffff);
+    s.lastObcStatus = (uint16_t)(header >> 16);
+    std::lock_guard<std::mutex> lock(gapLock);
+    s.gaps = gaps.load(std::memory_order_relaxed);
+    if(s.gaps > 0)
+        s.lastGap = gapHistory[(s.gaps - 1) % FRAME_GAP_HISTORY];
+    return s;
+}
+
+unsigned int frame_continuity::recentGaps(frame_gap_t *out, unsigned int maxGaps) const
+{
+    /*! \brief Copy up to maxGaps of the most recent gaps into out, oldest first. Returns the number copied. */
+    std::lock_guard<std::mutex> lock(gapLock);
+    uint64_t total = gaps.load(std::memory_order_relaxed);
+    uint64_t n = total;
+    if(n > FRAME_GAP_HISTORY)
+        n = FRAME_GAP_HISTORY;
+    if(n > maxGaps)
+        n = maxGaps;
+    for(uint64_t g = 0; g < n; g++)
+        out[g] = gapHistory[(total - n + g) % FRAME_GAP_HISTORY];
+    return (unsigned int)n;
+}
@@ -0,0 +1,80 @@
+#include "frame_notifier.hpp"
+
+#include <chrono>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+frame_notifier::frame_notifier()
+{
+    seq.store(0);
+    waiters.store(0);
+    efd.store(-1);
+}
+
+frame_notifier::~frame_notifier()
+{
+    wakeAll();
+    int fd = efd.exchange(-1);
+    if(fd >= 0)
+        close(fd);
+}
+
+void frame_notifier::publish(uint64_t newSeq)
+{
+    /*! \brief Announce that the frame with sequence number newSeq is ready.
+     * Sequence numbers must increase. Safe to call from a real-time thread:
+     * no lock is taken unless a consumer is blocked in wait(). */
+    seq.store(newSeq, std::memory_order_seq_cst);
+    if(waiters.load(std::memory_order_seq_cst) > 0)
+    {
+        std::lock_guard<std::mutex> lock(waitMutex);
+        frameReady.notify_all();
+    }
+    int fd = efd.load(std::memory_order_relaxed);
+    if(fd >= 0)
+    {
+        uint64_t one = 1;
+        ssize_t rtn = write(fd, &one, sizeof(one));
+        (void)rtn; // EAGAIN just means nobody has read it yet
+    }
+}
+
+void frame_notifier::wakeAll()
+{
+    /*! \brief Wake every waiter without publishing, for example when closing. */
+    std::lock_guard<std::mutex> lock(waitMutex);
+    frameReady.notify_all();
+}
+
+uint64_t frame_notifier::wait(uint64_t lastSeq, unsigned int timeout_ms)
+{
+    /*! \brief Block until a frame newer than lastSeq is published or timeout_ms passes.
+     * \return The current sequence number, which equals lastSeq on timeout. */
+    uint64_t current = seq.load(std::memory_order_acquire);
+    if(current != lastSeq)
+        return current;
+
+    std::unique_lock<std::mutex> lock(waitMutex);
+    waiters.fetch_add(1, std::memory_order_seq_cst);
+    frameReady.wait_for(lock, std::chrono::milliseconds(timeout_ms), [this, lastSeq] {
+        return seq.load(std::memory_order_seq_cst) != lastSeq;
+    });
+    waiters.fetch_sub(1, std::memory_order_seq_cst);
+    return seq.load(std::memory_order_acquire);
+}
+
+int frame_notifier::eventFd()
+{
+    /*! \brief Returns an eventfd which is signalled on every publish(), creating it on first use. */
+    int fd = efd.load(std::memory_order_acquire);
+    if(fd >= 0)
+        return fd;
+    std::lock_guard<std::mutex> lock(waitMutex);
+    fd = efd.load(std::memory_order_acquire);
+    if(fd < 0)
+    {
+        fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        efd.store(fd, std::memory_order_release);
+    }
+    return fd;
+}
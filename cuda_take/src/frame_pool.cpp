@@ -0,0 +1,146 @@
+#include "frame_pool.hpp"
+
+#include "frame_memory.hpp"
+
+frame_pool::~frame_pool()
+{
+    deallocate();
+}
+
+bool frame_pool::allocate(size_t slotBytes, unsigned int depth, memory_t kind, bool deferred)
+{
+    /*! \brief Allocate depth slots of at least slotBytes each.
+     * \param slotBytes Size of one product, rounded up to a whole cache line
+     * \param depth Number of slots, at least one
+     * \param kind HOST_MEMORY for CPU-only products, PINNED_MEMORY for device copy targets
+     * \param deferred Only reserve the block, see populate() and complete()
+     *
+     * The slots are zeroed, so a product which has not been computed yet reads as zero.
+     * The block follows the huge page and NUMA policy of frame_memory.hpp.
+     */
+    deallocate();
+    if((slotBytes == 0) || (depth == 0))
+        return false;
+
+    size_t padded = (slotBytes + 63) & ~(size_t)63;
+    size_t total = padded * depth;
+    void *mem = deferred ? frame_memory::reserve(total, kind == PINNED_MEMORY) :
+                           frame_memory::allocate(total, kind == PINNED_MEMORY);
+    if(mem == NULL)
+        return false;
+
+    block = (char *)mem;
+    stride = padded;
+    slotCount = depth;
+    head = 0;
+    this->kind = kind;
+    states.reset(new std::atomic<uint64_t>[depth]);
+    for(unsigned int s = 0; s < depth; s++)
+        states[s].store(0, std::memory_order_relaxed);
+    return true;
+}
+
+bool frame_pool::reuse(size_t slotBytes, unsigned int depth, memory_t kind)
+{
+    /*! \brief Keep the current block for depth slots of slotBytes each, if it already holds them.
+     * Returns false, leaving the pool untouched, if the block is missing, of another depth or kind, or its slots
+     * are too small; allocate() is then needed. Unlike allocate(), the slots keep their contents.
+     */
+    size_t padded = (slotBytes + 63) & ~(size_t)63;
+    if((block == NULL) || (slotBytes == 0) || (depth != slotCount) || (kind != this->kind) || (padded > stride))
+        return false;
+    head = 0;
+    return true;
+}
+
+void frame_pool::deallocate()
+{
+    frame_memory::release(block);
+    block = NULL;
+    stride = 0;
+    slotCount = 0;
+    head = 0;
+    states.reset();
+}
+
+void frame_pool::populate(unsigned int first, unsigned int count)
+{
+    /*! \brief Fault in count slots from first, of a deferred pool. Other slots may be in use meanwhile. */
+    if((block == NULL) || (first >= slotCount))
+        return;
+    if(count > slotCount - first)
+        count = slotCount - first;
+    frame_memory::populate(block, (size_t)first * stride, (size_t)count * stride);
+}
+
+bool frame_pool::complete()
+{
+    /*! \brief Pin a deferred pool once every slot is populated. Returns false if it stays pageable. */
+    if(block == NULL)
+        return true;
+    return frame_memory::complete(block);
+}
+
+frame_pool::slot_t frame_pool::next()
+{
+    /*! \brief The first slot after the one handed out last which no leased frame pins. */
+    slot_t s;
+    if(slotCount == 0)
+        return s;
+    for(unsigned int tried = 0; tried < slotCount; tried++)
+    {
+        unsigned int index = head;
+        if(++head == slotCount)
+            head = 0;
+        uint64_t state = states[index].load(std::memory_order_acquire);
+        if((state & 0xffffffffu) != 0)
+            continue;
+        uint64_t taken = state + (1ull << 32);
+        if(states[index].compare_exchange_strong(state, taken, std::memory_order_acq_rel))
+        {
+            s.data = block + (size_t)index * stride;
+            s.state = &states[index];
+            s.generation = (uint32_t)(taken >> 32);
+            return s;
+        }
+    }
+    // Every slot is pinned: the oldest is overwritten under its reader. The
+    // generation moves on with the pins kept, so their unpin() still balances.
+    overruns.fetch_add(1, std::memory_order_relaxed);
+    unsigned int index = head;
+    if(++head == slotCount)
+        head = 0;
+    uint64_t taken = states[index].fetch_add(1ull << 32, std::memory_order_acq_rel) + (1ull << 32);
+    s.data = block + (size_t)index * stride;
+    s.state = &states[index];
+    s.generation = (uint32_t)(taken >> 32);
+    return s;
+}
+
+bool frame_pool::pin(const slot_t &s)
+{
+    /*! \brief Keeps next() off the slot, as long as it still holds the product it was handed out for. */
+    if(s.state == NULL)
+        return false;
+    uint64_t state = s.state->load(std::memory_order_acquire);
+    while((uint32_t)(state >> 32) == s.generation)
+    {
+        if(s.state->compare_exchange_weak(state, state + 1, std::memory_order_acq_rel))
+            return true;
+    }
+    return false;
+}
+
+void frame_pool::unpin(const slot_t &s)
+{
+    /*! \brief Undoes a pin() which succeeded. */
+    if(s.state != NULL)
+        s.state->fetch_sub(1, std::memory_order_release);
+}
+
+void *frame_pool::slot(unsigned int index) const
+{
+    if(index >= slotCount)
+        return NULL;
+    return block + (size_t)index * stride;
+}
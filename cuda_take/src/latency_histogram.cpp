@@ -0,0 +1,95 @@
+#include "latency_histogram.hpp"
+
+const char *latency_stage_name(latency_stage_t stage)
+{
+    switch(stage)
+    {
+    case LATENCY_CAMERA_WAIT: return "camera wait";
+    case LATENCY_CONDITION: return "condition";
+    case LATENCY_DARK_SUBTRACT: return "dark subtract";
+    case LATENCY_MEAN_FILTER: return "mean filter";
+    case LATENCY_SHM_PUBLISH: return "shm publish";
+    case LATENCY_SAVE_ENQUEUE: return "save enqueue";
+    case LATENCY_SAVE_WRITE: return "save write";
+    case LATENCY_STD_DEV: return "std dev";
+    case LATENCY_FRAME_GRAPH: return "frame graph";
+    default: return "unknown";
+    }
+}
+
+latency_histogram::latency_histogram()
+{
+    reset();
+}
+
+unsigned int latency_histogram::bucketIndex(uint64_t ns)
+{
+    /*! \brief Values below 2^subBucketBits have a bucket each. Above that, each power of two
+     * is split into 2^(subBucketBits-1) buckets of equal width. */
+    const uint64_t linear = 1ull << subBucketBits;
+    const uint64_t half = linear >> 1;
+    if(ns < linear)
+        return (unsigned int)ns;
+    if(ns >= (1ull << maxValueBits))
+        ns = (1ull << maxValueBits) - 1;
+    unsigned int msb = 63 - __builtin_clzll(ns);
+    unsigned int shift = msb - (subBucketBits - 1);
+    return (unsigned int)(shift * half + (ns >> shift));
+}
+
+uint64_t latency_histogram::bucketUpperBound(unsigned int index)
+{
+    const unsigned int half = 1u << (subBucketBits - 1);
+    if(index < 2 * half)
+        return index;
+    unsigned int shift = index / half - 1;
+    uint64_t sub = index % half + half;
+    return ((sub + 1) << shift) - 1;
+}
+
+void latency_histogram::record(uint64_t ns)
+{
+    buckets[bucketIndex(ns)].fetch_add(1, std::memory_order_relaxed);
+    uint64_t prior = maxValue.load(std::memory_order_relaxed);
+    while((ns > prior) && !maxValue.compare_exchange_weak(prior, ns, std::memory_order_relaxed))
+        ;
+}
+
+latency_summary latency_histogram::summary() const
+{
+    /*! \brief Percentiles are reported as the upper edge of the bucket they fall in, clipped to the maximum.
+     * The counts are read while recording may continue, so the result is approximate to within a few frames. */
+    uint64_t local[bucketCount];
+    latency_summary s;
+    for(unsigned int i = 0; i < bucketCount; i++)
+    {
+        local[i] = buckets[i].load(std::memory_order_relaxed);
+        s.count += local[i];
+    }
+    s.max_ns = maxValue.load(std::memory_order_relaxed);
+    if(s.count == 0)
+        return s;
+
+    const double quantiles[3] = {0.50, 0.99, 0.999};
+    uint64_t *results[3] = {&s.p50_ns, &s.p99_ns, &s.p999_ns};
+    uint64_t seen = 0;
+    unsigned int q = 0;
+    for(unsigned int i = 0; (i < bucketCount) && (q < 3); i++)
+    {
+        seen += local[i];
+        while((q < 3) && (seen >= (uint64_t)(quantiles[q] * s.count + 0.5)) && (seen > 0))
+        {
+            uint64_t v = bucketUpperBound(i);
+            *results[q] = (v < s.max_ns) ? v : s.max_ns;
+            q++;
+        }
+    }
+    return s;
+}
+
+void latency_histogram::reset()
+{
+    for(unsigned int i = 0; i < bucketCount; i++)
+        buckets[i].store(0, std::memory_order_relaxed);
+    maxValue.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,48 @@
+#include "log_histogram.hpp"
+
+namespace
+{
+    const size_t PARALLEL_PIXELS = 65536; // fewer pixels are counted on the calling thread
+
+    template <typename T>
+    void count_pixels(const log_histogram &bins, const T *data, size_t pixels, uint32_t *histogram)
+    {
+        memset(histogram, 0, NUMBER_OF_BINS*sizeof(uint32_t));
+
+        #pragma omp parallel if(pixels >= PARALLEL_PIXELS)
+        {
+            uint32_t thread_histogram[NUMBER_OF_BINS] = {0};
+
+            #pragma omp for schedule(static)
+            for(long p = 0; p < (long)pixels; p++)
+                thread_histogram[bins.bin(data[p])]++;
+
+            #pragma omp critical
+            {
+                for(unsigned int c = 0; c < NUMBER_OF_BINS; c++)
+                    histogram[c] += thread_histogram[c];
+            }
+        }
+    }
+}
+
+log_histogram::log_histogram()
+{
+    binValues = getHistogramBinValues();
+    binsPerOctave = NUMBER_OF_BINS / 16.0f;
+    rawBins.resize(1<<16);
+    for(unsigned int v = 0; v < (1<<16); v++)
+        rawBins[v] = (uint16_t)bin((double)v);
+}
+
+void log_histogram::count(const uint16_t *data, size_t pixels, uint32_t *histogram) const
+{
+    /*! \brief The histogram of pixels 16 bit values, by table. */
+    count_pixels(*this, data, pixels, histogram);
+}
+
+void log_histogram::count(const float *data, size_t pixels, uint32_t *histogram) const
+{
+    /*! \brief The histogram of pixels float values, such as the dark subtracted image or the standard deviations. */
+    count_pixels(*this, data, pixels, histogram);
+}
@@ -10,6 +10,7 @@
 #include "std_dev_filter.hpp"
 #include "fft.hpp"
 #include <fstream>
+#include <random>
 using namespace std;
 
 
@@ -70,6 +71,429 @@ void simple_pdv_test()
 
 
 }
+void conditioning_benchmark(unsigned int w, unsigned int h)
+{
+	// Times each raw-conditioning stage set on a w x h frame.
+	const unsigned int iterations = 2000;
+	uint16_t * src = new uint16_t[w*h];
+	uint16_t * dst = new uint16_t[w*h];
+	for(unsigned int i = 0; i < w*h; i++)
+		src[i] = (uint16_t)(i * 2654435761u >> 16);
+
+	for(int twos = 0; twos < 2; twos++)
+	{
+		for(int inv = 0; inv < 2; inv++)
+		{
+			frame_conditioner_t condition = select_frame_conditioner(twos, inv);
+			std::chrono::steady_clock::time_point begintp = std::chrono::steady_clock::now();
+			for(unsigned int n = 0; n < iterations; n++)
+				condition(dst, src, w*h, 0x3fff);
+			std::chrono::steady_clock::time_point endtp = std::chrono::steady_clock::now();
+			double micros = std::chrono::duration_cast<std::chrono::microseconds>(endtp-begintp).count();
+			printf("2s compliment: %d, invert: %d, %.2f us/frame\n", twos, inv, micros/iterations);
+		}
+	}
+	delete[] src;
+	delete[] dst;
+}
+void fused_conditioning_benchmark(unsigned int w, unsigned int h)
+{
+	// Compares the fused conditioning kernel to the copy, 2s compliment,
+	// inversion and dark subtraction passes it replaces.
+	const unsigned int iterations = 1000;
+	uint16_t * src = new uint16_t[w*h];
+	uint16_t * dst = new uint16_t[w*h];
+	float * dark = new float[w*h];
+	for(unsigned int i = 0; i < w*h; i++)
+		src[i] = (uint16_t)(i * 2654435761u >> 16);
+
+	dark_subtraction_filter * dsf = new dark_subtraction_filter(w,h);
+	chroma_translate_filter chroma;
+	chroma.setup_filter(h,w);
+
+	std::chrono::steady_clock::time_point begintp = std::chrono::steady_clock::now();
+	for(unsigned int n = 0; n < iterations; n++)
+	{
+		memcpy(dst,src,w*h*sizeof(uint16_t));
+		chroma.apply_chroma_translate_filter(dst);
+		for(unsigned int i = 0; i < w*h; i++)
+			dst[i] = 0x3fff - dst[i];
+		dsf->update_dark_subtraction(dst,dark);
+	}
+	std::chrono::steady_clock::time_point endtp = std::chrono::steady_clock::now();
+	double chain = std::chrono::duration_cast<std::chrono::microseconds>(endtp-begintp).count();
+
+	fused_conditioner_t condition = select_fused_conditioner(true, true);
+	begintp = std::chrono::steady_clock::now();
+	for(unsigned int n = 0; n < iterations; n++)
+		condition(dst,dark,src,dsf->get_mask(),w*h,0x3fff);
+	endtp = std::chrono::steady_clock::now();
+	double fused = std::chrono::duration_cast<std::chrono::microseconds>(endtp-begintp).count();
+
+	printf("%ux%u, separate passes: %.2f us/frame\n", w, h, chain/iterations);
+	printf("%ux%u, fused (%s): %.2f us/frame\n", w, h, fused_conditioner_isa(), fused/iterations);
+	delete dsf;
+	delete[] src;
+	delete[] dst;
+	delete[] dark;
+}
+void mean_filter_benchmark(unsigned int w, unsigned int h)
+{
+	// Times calculate_means on a w x h frame, raw and dark subtracted, over
+	// the whole frame and with the vertical overlay columns.
+	const unsigned int iterations = 2000;
+	frame_c frame;
+	frame.allocate(w, h);
+	void * products = malloc(frame_c::mean_products_bytes(w, h));
+	float * dark = new float[w*h];
+	frame.attach_mean_products(products);
+	frame.attach_dark(dark);
+	for(unsigned int i = 0; i < w*h; i++)
+	{
+		frame.raw_data_ptr[i] = (uint16_t)(i * 2654435761u >> 16);
+		dark[i] = frame.raw_data_ptr[i] - 32768.0f;
+	}
+
+	mean_filter mf(&frame, 0, 0, w, 0, h, w, false, PLANE_MEAN, 0, 0, 0, 0, 0, 0);
+	unsigned long count = 0;
+	for(int dsf = 0; dsf < 2; dsf++)
+	{
+		for(int overlay = 0; overlay < 2; overlay++)
+		{
+			std::chrono::steady_clock::time_point begintp = std::chrono::steady_clock::now();
+			for(unsigned int n = 0; n < iterations; n++)
+			{
+				if(overlay)
+					mf.update(&frame, count++, 0, w, 0, h, w, dsf, PLANE_MEAN, 100, 110, w/2-5, w/2+5, w-110, w-100);
+				else
+					mf.update(&frame, count++, 0, w, 0, h, w, dsf, PLANE_MEAN, 0, 0, 0, 0, 0, 0);
+				mf.calculate_means();
+			}
+			std::chrono::steady_clock::time_point endtp = std::chrono::steady_clock::now();
+			double micros = std::chrono::duration_cast<std::chrono::microseconds>(endtp-begintp).count();
+			printf("%ux%u, dark subtracted: %d, overlay: %d (%s): %.2f us/frame\n", w, h, dsf, overlay,
+			       mean_profiles_isa(), micros/iterations);
+		}
+	}
+	free(products);
+	delete[] dark;
+}
+void plane_mean_spectrum_test(unsigned int history, unsigned int segment, double hz)
+{
+	// Fills a mean filter's history with a tone of hz cycles per 1000 frames
+	// in noise, then times Welch's spectrum of it with each window and prints
+	// where the peak landed.
+	frame_c frame;
+	frame.allocate(64, 64);
+	void * products = malloc(frame_c::mean_products_bytes(64, 64));
+	frame.attach_mean_products(products);
+	std::vector<uint16_t> row(64*64);
+	mean_filter mf(&frame, 0, 0, 64, 0, 64, 64, false, PLANE_MEAN, 0, 0, 0, 0, 0, 0);
+	mf.setHistoryLength(history);
+	std::mt19937 generator(5489);
+	std::uniform_int_distribution<int> noise(0, 15);
+	for(unsigned long n = 0; n < history; n++)
+	{
+		uint16_t v = (uint16_t)(1000 + 5*sin(2*M_PI*hz*n/1000.0) + noise(generator));
+		std::fill(row.begin(), row.end(), v);
+		mf.ingest_mean(row.data(), NULL, n, 0, 64, 0, 64, 64, 64, 0, 0);
+	}
+	std::vector<float> magnitude;
+	for(int w = FFT_WINDOW_RECT; w <= FFT_WINDOW_BLACKMAN; w++)
+	{
+		mf.myFFT.setWindow((fft_window_t)w);
+		std::chrono::steady_clock::time_point begintp = std::chrono::steady_clock::now();
+		unsigned int segments = mf.planeMeanSpectrum(segment, magnitude);
+		std::chrono::steady_clock::time_point endtp = std::chrono::steady_clock::now();
+		unsigned int points = 2*magnitude.size();
+		unsigned int peak = 4; // past the windows' spread of the mean
+		for(unsigned int k = 4; k < magnitude.size(); k++)
+			if(magnitude[k] > magnitude[peak])
+				peak = k;
+		printf("%s: %u segments of %u in %.2f ms, peak at %.3f per 1000 frames (bin width %.3f)\n",
+		       fft_window_name((fft_window_t)w), segments, points,
+		       std::chrono::duration_cast<std::chrono::microseconds>(endtp-begintp).count()/1000.0,
+		       1000.0*peak/points, 1000.0/points);
+	}
+	free(products);
+}
+static uint16_t std_dev_test_pixel(uint64_t frame, unsigned int pixel)
+{
+	// 14 bit noise, the same for a frame and pixel however often it is asked for.
+	uint64_t x = frame*0x9E3779B97F4A7C15ull + pixel*0xBF58476D1CE4E5B9ull;
+	x ^= x >> 31;
+	x *= 0x94D049BB133111EBull;
+	x ^= x >> 29;
+	return (uint16_t)(x & 0x3fff);
+}
+void std_dev_equivalence_test(unsigned int w, unsigned int h, unsigned int frames)
+{
+	// Feeds the std. dev. filter frames of noise, changing N every 2000
+	// frames, and checks each result against the standard deviation worked
+	// out directly, in two passes, from the N frames up to and including the
+	// one it was calculated for, with zeros before the first frame. Each
+	// frame's result is marked done by the next update_GPU_buffer() after it.
+	const unsigned int lengths[] = {1, 2, 37, MAX_N, 100};
+	const unsigned int pixels = w*h;
+	std_dev_filter sdvf(w, h);
+	frame_c calc;
+	frame_c feed;
+	calc.allocate(w, h);
+	feed.allocate(w, h);
+	frame_c *inflight = NULL;
+	unsigned int N = 0;
+	uint64_t end = 0;
+	unsigned int checked = 0;
+	unsigned int badHistograms = 0;
+	double worst = 0;
+	std::vector<double> values(MAX_N);
+	for(uint64_t k = 0; k < frames; k++)
+	{
+		unsigned int n = lengths[(k / 2000) % (sizeof(lengths)/sizeof(lengths[0]))];
+		frame_c *frame = (inflight == NULL) ? &calc : &feed;
+		for(unsigned int p = 0; p < pixels; p++)
+			frame->image_data_ptr[p] = std_dev_test_pixel(k, p);
+		if(sdvf.update_GPU_buffer(frame, n, inflight == NULL))
+		{
+			inflight = frame;
+			N = n;
+			end = k + 1;
+		} else if((inflight != NULL) && (inflight->has_valid_std_dev == 2)) {
+			for(unsigned int p = 0; p < pixels; p++)
+			{
+				double mean = 0;
+				for(unsigned int j = 0; j < N; j++)
+				{
+					int64_t f = (int64_t)end - N + j;
+					values[j] = (f >= 0) ? std_dev_test_pixel(f, p) : 0;
+					mean += values[j];
+				}
+				mean /= N;
+				double variance = 0;
+				for(unsigned int j = 0; j < N; j++)
+					variance += (values[j] - mean)*(values[j] - mean);
+				double expected = sqrt(variance / N);
+				double error = fabs(inflight->std_dev_data[p] - expected) / (expected + 1.0);
+				if(error > worst)
+					worst = error;
+			}
+			uint64_t counted = 0;
+			for(unsigned int b = 0; b < NUMBER_OF_BINS; b++)
+				counted += inflight->std_dev_histogram[b];
+			if(counted != pixels)
+				badHistograms++;
+			checked++;
+			inflight = NULL;
+		}
+		usleep(100);
+	}
+	printf("std. dev. equivalence, %ux%u over %u frames: %u results checked, largest relative error %.3g, "
+	       "%u histograms miscounted: %s\n", w, h, frames, checked, worst, badHistograms,
+	       ((checked > 0) && (worst < 1e-5) && (badHistograms == 0)) ? "PASS" : "FAIL");
+}
+#ifdef PDV_SIMULATOR
+void simulated_pdv_load_test(unsigned int w, unsigned int h, double fps, unsigned int numbufs, unsigned int seconds)
+{
+	// Drives the simulated frame grabber the same way pdv_loop does and reports
+	// the achieved rate and any frames lost to the multibuf ring overrunning.
+	pdv_sim_configure(w, h, fps);
+	PdvDev * pdv_p = pdv_open_channel(EDT_INTERFACE,0,0);
+	pdv_multibuf(pdv_p,numbufs);
+	pdv_start_images(pdv_p,numbufs);
+	unsigned int size = pdv_get_width(pdv_p)*pdv_get_height(pdv_p);
+	uint16_t * frame = new uint16_t[size];
+	fused_conditioner_t condition = select_fused_conditioner(true, false);
+	float * dark = new float[size];
+	float * mask = new float[size]();
+
+	unsigned long frames = 0;
+	std::chrono::steady_clock::time_point begintp = std::chrono::steady_clock::now();
+	std::chrono::steady_clock::time_point endtp = begintp + std::chrono::seconds(seconds);
+	while(std::chrono::steady_clock::now() < endtp)
+	{
+		uint16_t * ptr = reinterpret_cast<uint16_t *>(pdv_wait_image(pdv_p));
+		condition(frame,dark,ptr,mask,size,0);
+		pdv_start_image(pdv_p);
+		frames++;
+	}
+	double elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now()-begintp).count()/1E6;
+	printf("requested %.1f FPS, achieved %.1f FPS with %u buffers, %lu overruns\n",
+	       fps, frames/elapsed, numbufs, (unsigned long)pdv_sim_overruns(pdv_p));
+	pdv_close(pdv_p);
+	delete[] frame;
+	delete[] dark;
+	delete[] mask;
+}
+#endif
+void frame_memory_benchmark(unsigned int w, unsigned int h, unsigned int depth)
+{
+	// Copies frames round-robin through a ring of depth frames, as the camera
+	// loops do, once with normal pages and once with each huge page size, and
+	// reports the copy throughput and the backing each ring actually received.
+	const unsigned int passes = 10;
+	size_t frameBytes = (size_t)w*h*sizeof(uint16_t);
+	uint16_t * src = new uint16_t[w*h];
+	for(unsigned int i = 0; i < w*h; i++)
+		src[i] = (uint16_t)(i * 2654435761u >> 16);
+
+	const frame_memory::page_size_t sizes[3] = {frame_memory::PAGES_NORMAL, frame_memory::PAGES_2M, frame_memory::PAGES_1G};
+	for(unsigned int p = 0; p < 3; p++)
+	{
+		frame_memory::setPolicy(sizes[p], -1);
+		frame_pool ring;
+		if(!ring.allocate(frameBytes, depth, frame_pool::HOST_MEMORY))
+		{
+			printf("could not allocate %u frames\n", depth);
+			continue;
+		}
+		std::chrono::steady_clock::time_point begintp = std::chrono::steady_clock::now();
+		for(unsigned int n = 0; n < passes*depth; n++)
+			memcpy(ring.next().data, src, frameBytes);
+		double elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now()-begintp).count()/1E6;
+		printf("%ux%u x %u frames on %s: %.2f GB/s\n", w, h, depth,
+		       frame_memory::backingName(frame_memory::backing(ring.base())), passes*depth*frameBytes/elapsed/1E9);
+	}
+	frame_memory::setPolicy(frame_memory::PAGES_NORMAL, -1);
+	delete[] src;
+}
+void synthetic_drop_accounting_test(double fps, unsigned int dropEvery, unsigned int consumerDelayUs, unsigned int seconds)
+{
+	// Consumes a SyntheticCamera directly, as rtpConsumeFrames does, and checks
+	// that the gaps frame_continuity finds are the frames the camera says it
+	// lost. A consumer delay makes the camera overrun.
+	takeOptionsType options;
+	options.syntheticFPS = fps;
+	options.syntheticDropEvery = dropEvery;
+	SyntheticCamera camera(options);
+	camControlType control;
+	camera.setCamControlPtr(&control);
+	boost::thread producer(&CameraModel::streamLoop, &camera);
+
+	frame_metadata_decoder decoder(FRAME_SOURCE_SYNTHETIC, CL_6604A);
+	frame_continuity continuity;
+	frame_metadata_t meta;
+	CameraModel::camStatusEnum status;
+	uint64_t frames = 0;
+	std::chrono::steady_clock::time_point endtp = std::chrono::steady_clock::now() + std::chrono::seconds(seconds);
+	while(std::chrono::steady_clock::now() < endtp)
+	{
+		uint16_t * frame = camera.getFrameWait(0, &status);
+		if(status != CameraModel::camPlaying)
+			break;
+		decoder.decode(frame, camera.getFrameWidth(), meta);
+		continuity.observe(meta, frames++);
+		if(consumerDelayUs)
+			usleep(consumerDelayUs);
+	}
+	camera.stop();
+	producer.join();
+
+	synthetic_stats_t s = camera.stats();
+	frame_continuity_summary c = continuity.summary();
+	uint64_t lost = s.injectedDrops + s.overruns;
+	uint64_t after = s.ticks - c.checked - c.dropped; // made after the last frame consumed
+	bool consistent = (c.dropped <= lost) && (lost - c.dropped <= after);
+	printf("%.0f FPS: %lu made in %.2f s, %lu consumed, %lu late; lost %lu injected, %lu overrun; "
+	       "continuity %lu dropped: %s\n", fps, (unsigned long)s.ticks, s.seconds, (unsigned long)c.checked,
+	       (unsigned long)s.lateTicks, (unsigned long)s.injectedDrops, (unsigned long)s.overruns,
+	       (unsigned long)c.dropped, consistent ? "consistent" : "MISMATCH");
+}
+void synthetic_capacity_test(unsigned int w, unsigned int h, unsigned int seconds)
+{
+	// Runs take_object on the synthetic camera at rising frame rates and
+	// reports the rate it kept up with and the frames it lost at each.
+	const double rates[] = {250, 500, 1000, 2000, 4000, 8000};
+	for(unsigned int r = 0; r < sizeof(rates)/sizeof(rates[0]); r++)
+	{
+		takeOptionsType options;
+		options.syntheticCam = true;
+		options.syntheticWidth = w;
+		options.syntheticHeight = h;
+		options.syntheticFPS = rates[r];
+		options.frameRingDepth = 200;
+		take_object * to = new take_object(options);
+		to->start();
+		unsigned long before = to->count;
+		std::chrono::steady_clock::time_point begintp = std::chrono::steady_clock::now();
+		usleep(seconds*1000000);
+		double elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now()-begintp).count()/1E6;
+		unsigned long frames = to->count - before;
+		frame_continuity_summary c = to->getContinuity();
+		printf("%ux%u at %.0f FPS: took %.1f FPS, %lu dropped\n", w, h, rates[r], frames/elapsed, (unsigned long)c.dropped);
+		delete to;
+	}
+}
+#ifdef PDV_SIMULATOR
+void dual_pipeline_test(unsigned int seconds)
+{
+	// Runs two simulated cameras side by side in one process, a VNIR sized one
+	// and a SWIR sized one, with their frame graphs on one shared executor.
+	frame_executor graph;
+	graph.start(4, "GRAPH");
+
+	takeOptionsType vnirOptions;
+	vnirOptions.instanceName = "VNIR";
+	vnirOptions.pdvChannel = 0;
+	vnirOptions.shmName = "/liveview_image_vnir";
+	vnirOptions.frameRingDepth = 200;
+	takeOptionsType swirOptions = vnirOptions;
+	swirOptions.instanceName = "SWIR";
+	swirOptions.pdvChannel = 1;
+	swirOptions.shmName = "/liveview_image_swir";
+
+	take_object * vnir = new take_object(vnirOptions);
+	vnir->shareFrameGraph(&graph);
+	pdv_sim_configure(1280, 481, 200.0);
+	vnir->start();
+	take_object * swir = new take_object(swirOptions);
+	swir->shareFrameGraph(&graph);
+	pdv_sim_configure(640, 481, 100.0);
+	swir->start();
+
+	unsigned long vnirCount = 0;
+	unsigned long swirCount = 0;
+	for(unsigned int s = 0; s < seconds; s++)
+	{
+		usleep(1000000);
+		printf("VNIR %lu FPS, %lu dropped; SWIR %lu FPS, %lu dropped\n",
+		       vnir->count - vnirCount, (unsigned long)vnir->getContinuity().dropped,
+		       swir->count - swirCount, (unsigned long)swir->getContinuity().dropped);
+		vnirCount = vnir->count;
+		swirCount = swir->count;
+	}
+	delete swir;
+	delete vnir;
+	graph.stop();
+}
+void reconfigure_test(unsigned int switches)
+{
+	// Switches a simulated camera back and forth between two geometries, with
+	// a ring of 1500 frames, and prints how long each switch takes.
+	takeOptionsType options;
+	options.frameRingDepth = 1500;
+	take_object * to = new take_object(options);
+	pdv_sim_configure(640, 481, 100.0);
+	to->start();
+	for(unsigned int s = 0; s < switches; s++)
+	{
+		usleep(500000);
+		if(s % 2 == 0)
+			pdv_sim_configure(1280, 481, 200.0);
+		else
+			pdv_sim_configure(640, 481, 100.0);
+		unsigned long before = to->count;
+		if(!to->reconfigure(options))
+		{
+			printf("switch %u failed\n", s);
+			break;
+		}
+		usleep(100000);
+		printf("switch %u to %ux%u: %.1f ms, %lu frames since\n", s, to->getFrameWidth(), to->getDataHeight(),
+		       to->getLastSwitchMicros()/1000.0, to->count - before);
+	}
+	delete to;
+}
+#endif
 int main()
 {		
 	//simple_pdv_test();
@@ -77,6 +501,20 @@ int main()
 	//sensor_grab_test();
     simple_sensor_grab();
     //std_dev_test();
+    //conditioning_benchmark(1280, 481);
+    //fused_conditioning_benchmark(1280, 481);
+    //mean_filter_benchmark(1280, 481);
+    //plane_mean_spectrum_test(60000, 8192, 123.4);
+    //std_dev_equivalence_test(64, 32, 12000);
+    //frame_memory_benchmark(1280, 481, 1500);
+    //synthetic_drop_accounting_test(2000.0, 100, 0, 5);
+    //synthetic_drop_accounting_test(2000.0, 0, 1000, 5);
+    //synthetic_capacity_test(1280, 481, 5);
+#ifdef PDV_SIMULATOR
+    //simulated_pdv_load_test(1280, 481, 300.0, PDV_MULTIBUF_DEFAULT, 10);
+    //dual_pipeline_test(10);
+    //reconfigure_test(6);
+#endif
 	return 0;
 }
 
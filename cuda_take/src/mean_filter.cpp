@@ -1,7 +1,192 @@
 #include "mean_filter.hpp"
 #include "fft.hpp"
 #include <atomic>
+#include <vector>
+#include <algorithm>
 #include <stdio.h>
+#include <stdlib.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MEAN_FILTER_X86
+#endif
+
+namespace
+{
+    // Adds count pixels of a row into columns, one partial sum per column, and
+    // returns their sum. Raw pixels are summed in integers, which are exact.
+    typedef uint32_t (*raw_row_sum_t)(const uint16_t *row, uint32_t *columns, int count);
+    typedef float (*dsf_row_sum_t)(const float *row, float *columns, int count);
+
+    template <typename T, typename Acc>
+    Acc row_sum_tail(const T *row, Acc *columns, int begin, int count)
+    {
+        Acc sum = 0;
+        for(int c = begin; c < count; c++)
+        {
+            sum += row[c];
+            columns[c] += row[c];
+        }
+        return sum;
+    }
+
+    uint32_t raw_row_sum_scalar(const uint16_t *row, uint32_t *columns, int count)
+    {
+        return row_sum_tail(row, columns, 0, count);
+    }
+
+    float dsf_row_sum_scalar(const float *row, float *columns, int count)
+    {
+        return row_sum_tail(row, columns, 0, count);
+    }
+
+#ifdef MEAN_FILTER_X86
+    __attribute__((target("avx2")))
+    uint32_t raw_row_sum_avx2(const uint16_t *row, uint32_t *columns, int count)
+    {
+        __m256i acc = _mm256_setzero_si256();
+        int c = 0;
+        for(; c + 16 <= count; c += 16)
+        {
+            __m256i v = _mm256_loadu_si256((const __m256i *)(row + c));
+            __m256i lo = _mm256_cvtepu16_epi32(_mm256_castsi256_si128(v));
+            __m256i hi = _mm256_cvtepu16_epi32(_mm256_extracti128_si256(v, 1));
+            __m256i *col = (__m256i *)(columns + c);
+            _mm256_storeu_si256(col, _mm256_add_epi32(_mm256_loadu_si256(col), lo));
+            _mm256_storeu_si256(col + 1, _mm256_add_epi32(_mm256_loadu_si256(col + 1), hi));
+            acc = _mm256_add_epi32(acc, _mm256_add_epi32(lo, hi));
+        }
+        uint32_t lanes[8];
+        _mm256_storeu_si256((__m256i *)lanes, acc);
+        uint32_t sum = 0;
+        for(int l = 0; l < 8; l++)
+            sum += lanes[l];
+        return sum + row_sum_tail(row, columns, c, count);
+    }
+
+    __attribute__((target("avx2")))
+    float dsf_row_sum_avx2(const float *row, float *columns, int count)
+    {
+        __m256 acc = _mm256_setzero_ps();
+        int c = 0;
+        for(; c + 8 <= count; c += 8)
+        {
+            __m256 v = _mm256_loadu_ps(row + c);
+            _mm256_storeu_ps(columns + c, _mm256_add_ps(_mm256_loadu_ps(columns + c), v));
+            acc = _mm256_add_ps(acc, v);
+        }
+        float lanes[8];
+        _mm256_storeu_ps(lanes, acc);
+        float sum = 0;
+        for(int l = 0; l < 8; l++)
+            sum += lanes[l];
+        return sum + row_sum_tail(row, columns, c, count);
+    }
+#endif
+
+    bool profiles_avx2()
+    {
+#ifdef MEAN_FILTER_X86
+        static const bool avx2 = __builtin_cpu_supports("avx2");
+        return avx2;
+#else
+        return false;
+#endif
+    }
+
+    const char *isa_name()
+    {
+        return profiles_avx2() ? "AVX2" : "scalar";
+    }
+
+    raw_row_sum_t select_row_sum(const uint16_t *)
+    {
+#ifdef MEAN_FILTER_X86
+        if(profiles_avx2())
+            return &raw_row_sum_avx2;
+#endif
+        return &raw_row_sum_scalar;
+    }
+
+    dsf_row_sum_t select_row_sum(const float *)
+    {
+#ifdef MEAN_FILTER_X86
+        if(profiles_avx2())
+            return &dsf_row_sum_avx2;
+#endif
+        return &dsf_row_sum_scalar;
+    }
+
+    template <typename T>
+    float overlay_sum(const T *row, int start, int end)
+    {
+        float sum = 0;
+        for(int c = start; c < end; c++)
+            sum += row[c];
+        return sum;
+    }
+
+    struct profile_region_t {
+        int beginRow; // rows [beginRow, endRow) and columns [beginCol, endCol) make the mean profiles
+        int endRow;
+        int beginCol;
+        int endCol;
+        int frWidth;
+        int lh_start; // the overlay profiles take rows [0, endRow)
+        int lh_end;
+        int rh_start;
+        int rh_end;
+    };
+
+    template <typename T, typename Acc>
+    void sum_profiles(const T *data, const profile_region_t &region, float *vertical, float *horizontal,
+                      float *lh, float *rh, float *tap_profile)
+    {
+        /* The sums behind every profile in one pass over the rows, which are
+         * split across threads. Each thread keeps its own column sums, added up
+         * once its rows are done. The overlay columns and the tap profile are
+         * taken from each row while it is in cache. Of the region's columns, only
+         * the last TAP_WIDTH are copied into the tap profile: each of them is the
+         * last in the row to land on its tap column.
+         */
+        Acc (*row_sum)(const T *, Acc *, int) = select_row_sum(data);
+        const int columns = std::max(0, region.endCol - region.beginCol);
+        const int tapBegin = std::max(region.beginCol, region.endCol - (int)TAP_WIDTH);
+        std::vector<Acc> totals(columns, 0);
+
+        #pragma omp parallel
+        {
+            std::vector<Acc> partial(columns, 0);
+
+            #pragma omp for schedule(static)
+            for(int r = 0; r < region.endRow; r++)
+            {
+                const T *row = data + (size_t)r*region.frWidth;
+                lh[r] = overlay_sum(row, region.lh_start, region.lh_end);
+                rh[r] = overlay_sum(row, region.rh_start, region.rh_end);
+                if(r < region.beginRow)
+                {
+                    vertical[r] = 0;
+                    continue;
+                }
+                vertical[r] = row_sum(row + region.beginCol, partial.data(), columns);
+                if(tap_profile != NULL)
+                {
+                    for(int c = tapBegin; c < region.endCol; c++)
+                        tap_profile[r * TAP_WIDTH + c % TAP_WIDTH] = row[c];
+                }
+            }
+
+            #pragma omp critical
+            {
+                for(int c = 0; c < columns; c++)
+                    totals[c] += partial[c];
+            }
+        }
+        for(int c = 0; c < columns; c++)
+            horizontal[region.beginCol + c] = totals[c];
+    }
+}
 
 mean_filter::mean_filter(frame_c * frame,unsigned long frame_count,int startCol,\
                          int endCol,int startRow,int endRow,int actualWidth, \
@@ -10,34 +195,18 @@ mean_filter::mean_filter(frame_c * frame,unsigned long frame_count,int startCol,
                          int cent_start, int cent_end,\
                          int rh_start, int rh_end)
 {
-    beginCol = startCol;
-    width = endCol;
-    beginRow = startRow;
-    height = endRow;
-    frWidth = actualWidth;
-
-    this->frame = frame;
-    this->frame_count = frame_count;
-    this->useDSF = useDSF;
-    this->FFTtype = FFTtype;
-
-    // copy the latest overlay parameters from the frame:
-    // new with every frame... bad idea
-    this->lh_start = lh_start;
-    this->lh_end = lh_end;
-    this->cent_start = cent_start;
-    this->cent_end = cent_end;
-    this->rh_start = rh_start;
-    this->rh_end = rh_end;
-    doThreadWork.store(false);
-    runningMF.store(true);
-    mean_thread = boost::thread(&mean_filter::threadEntry, this);
+    update(frame, frame_count, startCol, endCol, startRow, endRow, actualWidth, useDSF, FFTtype,
+           lh_start, lh_end, cent_start, cent_end, rh_start, rh_end);
+    setHistoryLength(FFT_MEAN_BUFFER_LENGTH);
+    seriesFrames.store(0);
+    seriesProfiled.store(0);
+    seriesMeanOnly.store(0);
+    seriesHoles.store(0);
 }
 
 mean_filter::~mean_filter()
 {
-    runningMF.store(false);
-    usleep(200);
+    free(tap_profile);
 }
 
 void mean_filter::update(frame_c * frame,unsigned long frame_count,int startCol,\
@@ -47,25 +216,9 @@ void mean_filter::update(frame_c * frame,unsigned long frame_count,int startCol,
                          int cent_start, int cent_end,\
                          int rh_start, int rh_end)
 {
-    beginCol = startCol;
-    width = endCol;
-    beginRow = startRow;
-    height = endRow;
-    frWidth = actualWidth;
-
-    this->frame = frame;
-    this->frame_count = frame_count;
-    this->useDSF = useDSF;
-    this->FFTtype = FFTtype;
-
-    // copy the latest overlay parameters from the frame:
-    // new with every frame... bad idea
-    this->lh_start = lh_start;
-    this->lh_end = lh_end;
-    this->cent_start = cent_start;
-    this->cent_end = cent_end;
-    this->rh_start = rh_start;
-    this->rh_end = rh_end;
+    next.frame = frame;
+    updateParameters(frame_count, startCol, endCol, startRow, endRow, actualWidth, useDSF, FFTtype,
+                     lh_start, lh_end, cent_start, cent_end, rh_start, rh_end);
 }
 
 void mean_filter::updateParameters(unsigned long frame_count,int startCol,\
@@ -75,47 +228,60 @@ void mean_filter::updateParameters(unsigned long frame_count,int startCol,\
                          int cent_start, int cent_end,\
                          int rh_start, int rh_end)
 {
-    beginCol = startCol;
-    width = endCol;
-    beginRow = startRow;
-    height = endRow;
-    frWidth = actualWidth;
-
-    this->frame_count = frame_count;
-    this->useDSF = useDSF;
-    this->FFTtype = FFTtype;
+    next.frame_count = frame_count;
+    next.beginCol = startCol;
+    next.width = endCol;
+    next.beginRow = startRow;
+    next.height = endRow;
+    next.frWidth = actualWidth;
+    next.useDSF = useDSF;
+    next.FFTtype = FFTtype;
 
     // copy the latest overlay parameters from the frame:
     // new with every frame... bad idea
-    this->lh_start = lh_start;
-    this->lh_end = lh_end;
-    this->cent_start = cent_start;
-    this->cent_end = cent_end;
-    this->rh_start = rh_start;
-    this->rh_end = rh_end;
+    next.lh_start = lh_start;
+    next.lh_end = lh_end;
+    next.cent_start = cent_start;
+    next.cent_end = cent_end;
+    next.rh_start = rh_start;
+    next.rh_end = rh_end;
 }
 
-void mean_filter::start_mean()
+void mean_filter::setNotifier(frame_notifier *notifier)
 {
-    doThreadWork.store(true);
+    /*! \brief Publish frame_count+1 on notifier each time the means for a frame are finished. */
+    this->notifier = notifier;
 }
 
-void mean_filter::threadEntry()
+const char *mean_profiles_isa()
 {
-    while(runningMF)
-    {
-        std::unique_lock<std::mutex> lock(locking_mutex);
-        while(!doThreadWork.load())
-        {
-            // wait here
-            usleep(100);
-        }
-        calculate_means();
-        lock.unlock();
-    }
+    /*! \brief The instruction set calculate_means sums the profiles with on this CPU. */
+    return isa_name();
 }
+
 void mean_filter::calculate_means()
 {
+    /*! \brief Calculate the profiles and FFT for the frame and parameters given to update(), on this thread. */
+    calculate(next);
+}
+void mean_filter::calculate(const mean_params_t &work)
+{
+    frame_c *frame = work.frame;
+    unsigned long frame_count = work.frame_count;
+    int beginCol = work.beginCol;
+    int width = work.width;
+    int beginRow = work.beginRow;
+    int height = work.height;
+    int frWidth = work.frWidth;
+    bool useDSF = work.useDSF;
+    FFT_t FFTtype = work.FFTtype;
+    int lh_start = work.lh_start;
+    int lh_end = work.lh_end;
+    int cent_start = work.cent_start;
+    int cent_end = work.cent_end;
+    int rh_start = work.rh_start;
+    int rh_end = work.rh_end;
+
     frame->async_filtering_done = 0;
     // bool is_overlay_plot = false;
     int horizDiff = width - beginCol;
@@ -130,11 +296,22 @@ void mean_filter::calculate_means()
         vertDiff = 1;
         height++;
     }
-    memset(tap_profile, 0, MAX_HEIGHT*TAP_WIDTH*sizeof(*tap_profile));
-    memset(frame->vertical_mean_profile, 0, MAX_HEIGHT*sizeof(*(frame->vertical_mean_profile)));
-    memset(frame->horizontal_mean_profile, 0, MAX_WIDTH*sizeof(*(frame->horizontal_mean_profile)));
-    memset(frame->vertical_mean_profile_lh, 0, MAX_HEIGHT*sizeof(*(frame->vertical_mean_profile_lh)));
-    memset(frame->vertical_mean_profile_rh, 0, MAX_HEIGHT*sizeof(*(frame->vertical_mean_profile_rh)));
+    // The tap profile follows the frame geometry. It is only reallocated if
+    // the geometry grows, and never shorter than the FFT input.
+    size_t tapLen = (size_t)TAP_WIDTH * frame->height;
+    if(tapLen < FFT_INPUT_LENGTH)
+        tapLen = FFT_INPUT_LENGTH;
+    if(tapLen > tap_profile_len)
+    {
+        free(tap_profile);
+        tap_profile = (float *)malloc(tapLen*sizeof(*tap_profile));
+        if(tap_profile == NULL)
+        {
+            fprintf(stderr, "mean_filter: ERROR: could not allocate the tap profile.\n");
+            abort();
+        }
+        tap_profile_len = tapLen;
+    }
 
     // Remove this later, debug code:
     /*
@@ -174,90 +351,216 @@ void mean_filter::calculate_means()
 
     }
 
-    for(int r = beginRow; r < height; r++)
+    // The profiles are read whole by the widgets, so everything outside the
+    // region is zeroed. The region itself is written by sum_profiles.
+    const int rows = frame->height;
+    const int cols = frame->width;
+    const int endRow = std::min(height, rows);
+    std::fill(frame->vertical_mean_profile + std::max(endRow, 0), frame->vertical_mean_profile + rows, 0.0f);
+    std::fill(frame->vertical_mean_profile_lh + std::max(endRow, 0), frame->vertical_mean_profile_lh + rows, 0.0f);
+    std::fill(frame->vertical_mean_profile_rh + std::max(endRow, 0), frame->vertical_mean_profile_rh + rows, 0.0f);
+    std::fill(frame->horizontal_mean_profile, frame->horizontal_mean_profile + std::min(std::max(beginCol, 0), cols), 0.0f);
+    std::fill(frame->horizontal_mean_profile + std::min(std::max(width, beginCol), cols), frame->horizontal_mean_profile + cols, 0.0f);
+    float *tap = NULL;
+    if(FFTtype == TAP_PROFIL)
     {
-        for(int c = beginCol; c < width; c++)
-        {
-            if(!useDSF)
-            {
-                frame->vertical_mean_profile[r] += frame->image_data_ptr[r*frWidth + c];
-                frame->horizontal_mean_profile[c] += frame->image_data_ptr[r*frWidth + c];
-                if(FFTtype == TAP_PROFIL)
-                    tap_profile[r * TAP_WIDTH + c % TAP_WIDTH] = frame->image_data_ptr[r * frWidth + c];
-            }
-            else if(useDSF)
-            {
-                frame->vertical_mean_profile[r] += frame->dark_subtracted_data[r*frWidth + c];
-                frame->horizontal_mean_profile[c] += frame->dark_subtracted_data[r*frWidth + c];
-                if(FFTtype == TAP_PROFIL)
-                    tap_profile[r * TAP_WIDTH + c % TAP_WIDTH] = frame->dark_subtracted_data[r*frWidth + c];
-            }
-        }
+        memset(tap_profile, 0, tap_profile_len*sizeof(*tap_profile));
+        tap = tap_profile;
     }
 
+    profile_region_t region;
+    region.beginRow = beginRow;
+    region.endRow = endRow;
+    region.beginCol = beginCol;
+    region.endCol = std::min(width, cols);
+    region.frWidth = frWidth;
+    region.lh_start = lh_start;
+    region.lh_end = lh_end;
+    region.rh_start = rh_start;
+    region.rh_end = rh_end;
+    if(useDSF)
+        sum_profiles<float, float>(frame->dark_subtracted_data, region, frame->vertical_mean_profile,
+                                   frame->horizontal_mean_profile, frame->vertical_mean_profile_lh,
+                                   frame->vertical_mean_profile_rh, tap);
+    else
+        sum_profiles<uint16_t, uint32_t>(frame->image_data_ptr, region, frame->vertical_mean_profile,
+                                         frame->horizontal_mean_profile, frame->vertical_mean_profile_lh,
+                                         frame->vertical_mean_profile_rh, tap);
 
-    // LH and RH profiles:
-    if(!useDSF)
-    {
-        for(int r = 0; r < height; r++)
-        {
-            // for each row, grab the data at UI-selected col=start and col=end
-            for(int c = lh_start; c < lh_end; c++)
-            {
-                frame->vertical_mean_profile_lh[r] += frame->image_data_ptr[r*frWidth + c];
-            }
-            for(int c = rh_start; c < rh_end; c++)
-            {
-                frame->vertical_mean_profile_rh[r] += frame->image_data_ptr[r*frWidth + c];
-            }
-        }
-    } else {
-        for(int r = 0; r < height; r++)
-        {
-            for(int c = lh_start; c < lh_end; c++)
-            {
-                frame->vertical_mean_profile_lh[r] += frame->dark_subtracted_data[r*frWidth + c];
-            }
-            for(int c = rh_start; c < rh_end; c++)
-            {
-                frame->vertical_mean_profile_rh[r] += frame->dark_subtracted_data[r*frWidth + c];
-            }
-        }
-    }
-
-    for(int r = beginRow; r < height; r++)
+    // A region larger than the frame is clamped to it, as in ingest_mean(),
+    // so the profiles are divided by the extent actually summed.
+    if(width > region.endCol)
+        horizDiff = std::max(horizDiff - (width - region.endCol), 1);
+    if(height > endRow)
+        vertDiff = std::max(endRow - beginRow, 1);
+    for(int r = 0; r < endRow; r++)
     {
-        frame->vertical_mean_profile[r] /= horizDiff;
+        if(r >= beginRow)
+            frame->vertical_mean_profile[r] /= horizDiff;
         frame->vertical_mean_profile_lh[r] /= (lh_end-lh_start+1);
         frame->vertical_mean_profile_rh[r] /= (rh_end-rh_start+1);
     }
 
     // begin determining frame mean for FFT
-    frame_mean = 0;
-    for(int c = beginCol; c < width; c++)
+    float frame_mean = 0;
+    for(int c = beginCol; c < region.endCol; c++)
     {
         frame->horizontal_mean_profile[c] /= (vertDiff);
         frame_mean += frame->horizontal_mean_profile[c];
     }
     frame_mean /= frWidth;
 
-    mean_ring_buffer_fft_head = mean_ring_buffer_head;
-
-    mean_ring_buffer[mean_ring_buffer_head++] = frame_mean;
-    if(mean_ring_buffer_head >= FFT_MEAN_BUFFER_LENGTH)
-        mean_ring_buffer_head = 0;
+    mean_ring_buffer_fft_head = commit_mean(frame_count, frame_mean, true);
     if(frame_count > FFT_INPUT_LENGTH && FFTtype == PLANE_MEAN)
-		myFFT.doRealFFT(mean_ring_buffer, mean_ring_buffer_fft_head, frame->fftMagnitude);
+    {
+        // The newest FFT_INPUT_LENGTH means, oldest first.
+        unsigned int oldest = (mean_ring_buffer_fft_head + historyLength + 1 - FFT_INPUT_LENGTH) % historyLength;
+		myFFT.doRealFFT(mean_ring_buffer.data(), oldest, frame->fftMagnitude, historyLength);
+    }
     else if( FFTtype == VERT_CROSS )
-        myFFT.doRealFFT(frame->vertical_mean_profile, 0, frame->fftMagnitude); // FOR THE VERTICAL CROSSHAIR FFT
+        myFFT.doRealFFT(frame->vertical_mean_profile, 0, frame->fftMagnitude, FFT_INPUT_LENGTH); // FOR THE VERTICAL CROSSHAIR FFT
     else if( FFTtype == TAP_PROFIL )
-        myFFT.doRealFFT(tap_profile, 0, frame->fftMagnitude);
+        myFFT.doRealFFT(tap_profile, 0, frame->fftMagnitude, FFT_INPUT_LENGTH);
 
     frame->async_filtering_done = 1;
     //delete this; //I can honestly say this is the ugliest line of C++ I've ever written.
-    doThreadWork.store(false);
+    if(notifier != NULL)
+        notifier->publish(frame_count + 1);
+}
+void mean_filter::ingest_mean(const uint16_t *raw, const float *mask, unsigned long frame_count,
+                              int startCol, int endCol, int startRow, int endRow, int actualWidth,
+                              int actualHeight, int cent_start, int cent_end)
+{
+    /*! \brief Add a frame's mean to the PLANE_MEAN history, without its profiles or FFT.
+     * The mean is the one calculate_means() would find, over the same rows and columns, of raw less mask
+     * when the dark subtracted data is in use and raw alone when mask is NULL. The region is clamped to the
+     * actualWidth x actualHeight frame as it is there. Calls must be in frame order with those of calculate_means().
+     */
+    if(endCol == startCol)
+        endCol++;
+    if(endRow == startRow)
+        endRow++;
+    if( (cent_start != 0) && (cent_end != 0) )
+    {
+        startCol = cent_start;
+        endCol = cent_end;
+    }
+    endCol = std::min(endCol, actualWidth);
+    endRow = std::min(endRow, actualHeight);
+
+    double sum = 0;
+    for(int r = startRow; r < endRow; r++)
+    {
+        const uint16_t *row = raw + (size_t)r*actualWidth;
+        if(mask == NULL)
+        {
+            for(int c = startCol; c < endCol; c++)
+                sum += row[c];
+        } else {
+            const float *maskRow = mask + (size_t)r*actualWidth;
+            for(int c = startCol; c < endCol; c++)
+                sum += row[c] - maskRow[c];
+        }
+    }
+    commit_mean(frame_count, (float)(sum / std::max(endRow - startRow, 1) / actualWidth), false);
+}
+
+unsigned int mean_filter::commit_mean(unsigned long frame_count, float mean, bool profiled)
+{
+    /* Appends one frame's mean to the PLANE_MEAN history and returns where it went.
+     * The history is read as one value per frame, so frames which never got here
+     * are filled with the last mean before them and counted as holes. A
+     * frame_count at or below the last one is appended as it is, and later
+     * frames are counted on from it.
+     */
+    std::lock_guard<std::mutex> lock(historyLock);
+    if(seriesStarted && (frame_count > lastSeriesCount + 1))
+    {
+        unsigned long missing = frame_count - lastSeriesCount - 1;
+        seriesHoles.fetch_add(missing, std::memory_order_relaxed);
+        if(missing > historyLength)
+            missing = historyLength;
+        unsigned int last = (mean_ring_buffer_head + historyLength - 1) % historyLength;
+        float held = mean_ring_buffer[last];
+        for(unsigned long m = 0; m < missing; m++)
+        {
+            mean_ring_buffer[mean_ring_buffer_head++] = held;
+            if(mean_ring_buffer_head >= historyLength)
+                mean_ring_buffer_head = 0;
+        }
+        historyFilled = std::min<unsigned long>(historyFilled + missing, historyLength);
+    }
+    seriesStarted = true;
+    lastSeriesCount = frame_count;
+
+    unsigned int position = mean_ring_buffer_head;
+    mean_ring_buffer[mean_ring_buffer_head++] = mean;
+    if(mean_ring_buffer_head >= historyLength)
+        mean_ring_buffer_head = 0;
+    if(historyFilled < historyLength)
+        historyFilled++;
+    seriesFrames.fetch_add(1, std::memory_order_relaxed);
+    if(profiled)
+        seriesProfiled.fetch_add(1, std::memory_order_relaxed);
+    else
+        seriesMeanOnly.fetch_add(1, std::memory_order_relaxed);
+    return position;
+}
+
+void mean_filter::setHistoryLength(unsigned int length)
+{
+    /*! \brief Sets how many frame means the PLANE_MEAN history keeps, and empties it.
+     * At least FFT_INPUT_LENGTH, which the spectrum of each frame is taken over. Call it
+     * before the first frame; planeMeanSpectrum() can then resolve frequencies down to
+     * the frame rate divided by length.
+     */
+    if(length < FFT_INPUT_LENGTH)
+        length = FFT_INPUT_LENGTH;
+    std::lock_guard<std::mutex> lock(historyLock);
+    historyLength = length;
+    mean_ring_buffer.assign(length, 0);
+    mean_ring_buffer_head = 0;
+    mean_ring_buffer_fft_head = 0;
+    historyFilled = 0;
+}
+
+unsigned int mean_filter::getHistoryLength()
+{
+    return historyLength;
+}
+
+unsigned int mean_filter::planeMeanSpectrum(unsigned int segment, std::vector<float> &magnitude)
+{
+    /*! \brief Welch's average spectrum of the PLANE_MEAN history, see fft::welch().
+     * \param segment Points in each transform, even; 0 for the whole history in one.
+     * \param magnitude Resized to segment/2 values, the frequency of value k being k/segment of the frame rate.
+     * \return The number of segments averaged, 0 if the history is shorter than one segment.
+     * It copies the history under a lock and transforms it on the calling thread, with the window of myFFT,
+     * so the frames' own spectra are not held up.
+     */
+    std::vector<float> series;
+    {
+        std::lock_guard<std::mutex> lock(historyLock);
+        series.resize(historyFilled);
+        unsigned int first = (mean_ring_buffer_head + historyLength - historyFilled) % historyLength;
+        for(unsigned int i = 0; i < historyFilled; i++)
+            series[i] = mean_ring_buffer[(first + i) % historyLength];
+    }
+    if(segment == 0)
+        segment = series.size() & ~1u;
+    magnitude.assign(segment/2, 0);
+    fft engine;
+    engine.setWindow(myFFT.getWindow());
+    return engine.welch(series.data(), series.size(), segment, magnitude.data());
 }
-void mean_filter::wait_mean()
+
+mean_series_summary mean_filter::seriesSummary() const
 {
-	mean_thread.join();
+    /*! \brief How the frames of the PLANE_MEAN history came in, see commit_mean(). */
+    mean_series_summary summary;
+    summary.frames = seriesFrames.load(std::memory_order_relaxed);
+    summary.profiled = seriesProfiled.load(std::memory_order_relaxed);
+    summary.meanOnly = seriesMeanOnly.load(std::memory_order_relaxed);
+    summary.holes = seriesHoles.load(std::memory_order_relaxed);
+    return summary;
 }
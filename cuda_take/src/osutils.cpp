@@ -1,5 +1,16 @@
 #include "osutils.h"
 
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
 void os::listdir(std::vector<std::string> &out, const std::string &directory)
 {
     DIR *dir;
@@ -44,3 +55,197 @@ std::string os::trim(const std::string &value)
 {
     return std::regex_replace(value, std::regex("^ +| +$|( ) +"), "$1");
 }
+
+std::map<std::string, std::string> os::parseThreadMap(const char *spec)
+{
+    // Parses "NAME=value;NAME=value", for example "PDVCAM=2,3;SAVING=4".
+    // Thread names may contain spaces, such as "RTPNG Stream".
+    std::map<std::string, std::string> out;
+    if(spec == NULL)
+        return out;
+
+    std::stringstream ss(spec);
+    std::string entry;
+    while(std::getline(ss, entry, ';'))
+    {
+        size_t eq = entry.find('=');
+        if(eq == std::string::npos)
+            continue;
+        std::string name = trim(entry.substr(0, eq));
+        std::string value = trim(entry.substr(eq + 1));
+        if(!name.empty() && !value.empty())
+            out[name] = value;
+    }
+    return out;
+}
+
+bool os::parseCpuList(const std::string &list, std::vector<int> &cpus)
+{
+    // Accepts "2", "2,3" and "2-5" forms.
+    cpus.clear();
+    std::stringstream ss(list);
+    std::string item;
+    while(std::getline(ss, item, ','))
+    {
+        int first = 0;
+        int last = 0;
+        if(sscanf(item.c_str(), "%d-%d", &first, &last) == 2)
+        {
+            if((first < 0) || (last < first))
+                return false;
+            for(int c = first; c <= last; c++)
+                cpus.push_back(c);
+        } else if(sscanf(item.c_str(), "%d", &first) == 1) {
+            if(first < 0)
+                return false;
+            cpus.push_back(first);
+        } else {
+            return false;
+        }
+    }
+    return !cpus.empty();
+}
+
+bool os::setThreadAffinity(pthread_t thread, const std::vector<int> &cpus, std::string &error)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for(size_t i = 0; i < cpus.size(); i++)
+    {
+        if(cpus[i] >= CPU_SETSIZE)
+        {
+            error = "CPU " + std::to_string(cpus[i]) + " out of range";
+            return false;
+        }
+        CPU_SET(cpus[i], &set);
+    }
+    int rtn = pthread_setaffinity_np(thread, sizeof(set), &set);
+    if(rtn != 0)
+    {
+        error = strerror(rtn);
+        return false;
+    }
+    return true;
+}
+
+bool os::setThreadRealtime(pthread_t thread, int priority, std::string &error)
+{
+    int minPri = sched_get_priority_min(SCHED_FIFO);
+    int maxPri = sched_get_priority_max(SCHED_FIFO);
+    if((priority < minPri) || (priority > maxPri))
+    {
+        error = "SCHED_FIFO priority must be between " + std::to_string(minPri) + " and " + std::to_string(maxPri);
+        return false;
+    }
+    struct sched_param param;
+    memset(&param, 0, sizeof(param));
+    param.sched_priority = priority;
+    int rtn = pthread_setschedparam(thread, SCHED_FIFO, &param);
+    if(rtn != 0)
+    {
+        error = strerror(rtn);
+        if(rtn == EPERM)
+        {
+            struct rlimit lim;
+            getrlimit(RLIMIT_RTPRIO, &lim);
+            error += " (needs CAP_SYS_NICE or an RLIMIT_RTPRIO of at least " + std::to_string(priority) +
+                    ", current limit is " + std::to_string((long long)lim.rlim_cur) + ")";
+        }
+        return false;
+    }
+    return true;
+}
+
+bool os::lockMemory(const void *addr, size_t len, std::string &error)
+{
+    if(mlock(addr, len) != 0)
+    {
+        int err = errno;
+        error = strerror(err);
+        if((err == EPERM) || (err == ENOMEM))
+        {
+            struct rlimit lim;
+            getrlimit(RLIMIT_MEMLOCK, &lim);
+            if(lim.rlim_cur == RLIM_INFINITY)
+                error += " (RLIMIT_MEMLOCK is unlimited)";
+            else
+                error += " (needs CAP_IPC_LOCK or an RLIMIT_MEMLOCK of at least " + std::to_string(len) +
+                        " bytes, current limit is " + std::to_string((long long)lim.rlim_cur) + ")";
+        }
+        return false;
+    }
+    return true;
+}
+
+std::string os::describeThreadPolicy(pthread_t thread)
+{
+    std::ostringstream out;
+    int policy = 0;
+    struct sched_param param;
+    if(pthread_getschedparam(thread, &policy, &param) == 0)
+    {
+        switch(policy)
+        {
+        case SCHED_FIFO: out << "SCHED_FIFO priority " << param.sched_priority; break;
+        case SCHED_RR: out << "SCHED_RR priority " << param.sched_priority; break;
+        default: out << "SCHED_OTHER"; break;
+        }
+    }
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if(pthread_getaffinity_np(thread, sizeof(set), &set) == 0)
+    {
+        int count = CPU_COUNT(&set);
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        if(count >= online)
+        {
+            out << ", any CPU";
+        } else {
+            out << ", CPUs";
+            for(int c = 0; c < CPU_SETSIZE; c++)
+            {
+                if(CPU_ISSET(c, &set))
+                    out << " " << c;
+            }
+        }
+    }
+    return out.str();
+}
+
+size_t os::residentSetBytes()
+{
+    // Current resident set size of this process, or 0 if it cannot be read.
+    unsigned long pages = 0;
+    unsigned long resident = 0;
+    FILE *statm = fopen("/proc/self/statm", "r");
+    if(statm == NULL)
+        return 0;
+    int found = fscanf(statm, "%lu %lu", &pages, &resident);
+    fclose(statm);
+    if(found != 2)
+        return 0;
+    return (size_t)resident * (size_t)sysconf(_SC_PAGESIZE);
+}
+
+int os::cpuNumaNode(int cpu)
+{
+    // NUMA node holding the given CPU, from the nodeN link in its sysfs
+    // directory, or -1 if the machine does not report one.
+    std::string path = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+    DIR *dir = opendir(path.c_str());
+    if(dir == NULL)
+        return -1;
+    int node = -1;
+    struct dirent *ent;
+    while((ent = readdir(dir)) != NULL)
+    {
+        if((strncmp(ent->d_name, "node", 4) == 0) && isdigit((unsigned char)ent->d_name[4]))
+        {
+            node = atoi(ent->d_name + 4);
+            break;
+        }
+    }
+    closedir(dir);
+    return node;
+}
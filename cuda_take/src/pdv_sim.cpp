@@ -0,0 +1,220 @@
+#ifdef PDV_SIMULATOR
+
+#include "pdv_sim.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <thread>
+#include <mutex>
+
+struct PdvDev
+{
+    unsigned int width;
+    unsigned int height;
+    std::chrono::nanoseconds period;
+
+    unsigned int numbufs;
+    uint16_t *buffers;
+    unsigned int lastBuffer;
+
+    uint64_t started; // images requested by pdv_start_image(s)
+    uint64_t delivered; // images returned by pdv_wait_image
+    uint64_t frameNumber; // frames emitted by the "camera", including overruns
+    uint64_t overruns;
+    int timeouts;
+    std::chrono::steady_clock::time_point nextFrame;
+    bool acquiring;
+};
+
+static std::mutex simConfigMutex;
+static unsigned int simWidth = 0;
+static unsigned int simHeight = 0;
+static double simFPS = -1;
+
+static unsigned int envOrDefault(const char *name, unsigned int configured, unsigned int fallback)
+{
+    if(configured != 0)
+        return configured;
+    const char *value = getenv(name);
+    if(value != NULL && atoi(value) > 0)
+        return (unsigned int)atoi(value);
+    return fallback;
+}
+
+void pdv_sim_configure(unsigned int width, unsigned int height, double fps)
+{
+    /*! \brief Set the geometry and frame rate used by the next pdv_open_channel(). */
+    std::lock_guard<std::mutex> lock(simConfigMutex);
+    simWidth = width;
+    simHeight = height;
+    simFPS = fps;
+}
+
+uint64_t pdv_sim_overruns(PdvDev *pdv_p)
+{
+    /*! \brief Number of frames the simulated camera emitted with no started image to receive them. */
+    return pdv_p ? pdv_p->overruns : 0;
+}
+
+PdvDev *pdv_open_channel(const char *dev_name, int unit, int channel)
+{
+    (void)dev_name; (void)unit; (void)channel;
+    PdvDev *pdv_p = new PdvDev();
+
+    std::lock_guard<std::mutex> lock(simConfigMutex);
+    pdv_p->width = envOrDefault("PDV_SIM_WIDTH", simWidth, 640);
+    pdv_p->height = envOrDefault("PDV_SIM_HEIGHT", simHeight, 481);
+    double fps = simFPS;
+    if(fps < 0)
+    {
+        const char *value = getenv("PDV_SIM_FPS");
+        fps = (value != NULL) ? atof(value) : 100.0;
+    }
+    if(fps > 0)
+        pdv_p->period = std::chrono::nanoseconds((long long)(1E9 / fps));
+    else
+        pdv_p->period = std::chrono::nanoseconds(0);
+
+    pdv_p->numbufs = 0;
+    pdv_p->buffers = NULL;
+    pdv_p->lastBuffer = 0;
+    pdv_p->started = 0;
+    pdv_p->delivered = 0;
+    pdv_p->frameNumber = 0;
+    pdv_p->overruns = 0;
+    pdv_p->timeouts = 0;
+    pdv_p->acquiring = false;
+    pdv_multibuf(pdv_p, 1);
+    return pdv_p;
+}
+
+int pdv_close(PdvDev *pdv_p)
+{
+    if(pdv_p == NULL)
+        return -1;
+    free(pdv_p->buffers);
+    delete pdv_p;
+    return 0;
+}
+
+int pdv_get_width(PdvDev *pdv_p)
+{
+    return pdv_p->width;
+}
+
+int pdv_get_height(PdvDev *pdv_p)
+{
+    return pdv_p->height;
+}
+
+int pdv_get_dmasize(PdvDev *pdv_p)
+{
+    return pdv_p->width * pdv_p->height * sizeof(uint16_t);
+}
+
+int pdv_multibuf(PdvDev *pdv_p, int numbufs)
+{
+    if((pdv_p == NULL) || (numbufs < 1))
+        return -1;
+    size_t bytes = (size_t)numbufs * pdv_get_dmasize(pdv_p);
+    uint16_t *buffers = (uint16_t *)calloc(1, bytes);
+    if(buffers == NULL)
+        return -1;
+    free(pdv_p->buffers);
+    pdv_p->buffers = buffers;
+    pdv_p->numbufs = numbufs;
+    return 0;
+}
+
+void pdv_start_images(PdvDev *pdv_p, int count)
+{
+    if(!pdv_p->acquiring)
+    {
+        pdv_p->acquiring = true;
+        pdv_p->nextFrame = std::chrono::steady_clock::now() + pdv_p->period;
+    }
+    pdv_p->started += count;
+}
+
+void pdv_start_image(PdvDev *pdv_p)
+{
+    pdv_start_images(pdv_p, 1);
+}
+
+static void fillFrame(PdvDev *pdv_p, uint16_t *frame)
+{
+    unsigned int offset = (unsigned int)pdv_p->frameNumber;
+    for(unsigned int r = 0; r < pdv_p->height; r++)
+    {
+        for(unsigned int c = 0; c < pdv_p->width; c++)
+        {
+            frame[r*pdv_p->width + c] = (uint16_t)((r + c + offset) * 64);
+        }
+    }
+    if(pdv_p->width * pdv_p->height > 160)
+        frame[160] = (uint16_t)pdv_p->frameNumber;
+}
+
+u_char *pdv_wait_image(PdvDev *pdv_p)
+{
+    /*! \brief Wait for the next started image and return its buffer.
+     * Like the hardware, a wait with no image started times out and returns the last buffer. */
+    uint16_t *last = pdv_p->buffers + (size_t)pdv_p->lastBuffer * pdv_p->width * pdv_p->height;
+    if(pdv_p->started <= pdv_p->delivered)
+    {
+        pdv_p->timeouts++;
+        std::this_thread::sleep_for(pdv_p->period);
+        return (u_char *)last;
+    }
+
+    if(pdv_p->period.count() > 0)
+    {
+        std::this_thread::sleep_until(pdv_p->nextFrame);
+
+        // Frames emitted while every started buffer was already full are lost.
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        uint64_t behind = 0;
+        if(now > pdv_p->nextFrame)
+            behind = (now - pdv_p->nextFrame) / pdv_p->period;
+        uint64_t inFlight = pdv_p->started - pdv_p->delivered;
+        if(behind >= inFlight)
+        {
+            uint64_t lost = behind - inFlight + 1;
+            pdv_p->frameNumber += lost;
+            pdv_p->overruns += lost;
+            pdv_p->nextFrame += pdv_p->period * lost;
+        }
+        pdv_p->nextFrame += pdv_p->period;
+    }
+
+    pdv_p->lastBuffer = pdv_p->delivered % pdv_p->numbufs;
+    uint16_t *frame = pdv_p->buffers + (size_t)pdv_p->lastBuffer * pdv_p->width * pdv_p->height;
+    fillFrame(pdv_p, frame);
+    pdv_p->frameNumber++;
+    pdv_p->delivered++;
+    return (u_char *)frame;
+}
+
+u_char *pdv_wait_last_image(PdvDev *pdv_p, int *nSkipped)
+{
+    // Drain everything which has been started, returning only the last one.
+    int skipped = 0;
+    u_char *image = NULL;
+    while(pdv_p->started > pdv_p->delivered + 1)
+    {
+        pdv_p->delivered++;
+        skipped++;
+    }
+    image = pdv_wait_image(pdv_p);
+    if(nSkipped != NULL)
+        *nSkipped = skipped;
+    return image;
+}
+
+int pdv_timeouts(PdvDev *pdv_p)
+{
+    return pdv_p->timeouts;
+}
+
+#endif // PDV_SIMULATOR
@@ -0,0 +1,65 @@
+#include "product_schedule.hpp"
+#include "constants.h"
+
+namespace
+{
+    int64_t steadyNs(std::chrono::steady_clock::time_point t)
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+    }
+}
+
+product_schedule::product_schedule()
+{
+    policyValue.store(PRODUCT_EVERY_FRAME);
+    everyValue.store(1);
+    producedCount.store(0);
+    reset();
+}
+
+void product_schedule::setPolicy(product_policy_t policy, unsigned int every)
+{
+    /*! \brief Use policy from the next frame on. every is the n of PRODUCT_EVERY_NTH, at least 1. */
+    everyValue.store((every == 0) ? 1 : every, std::memory_order_relaxed);
+    policyValue.store(policy, std::memory_order_relaxed);
+}
+
+void product_schedule::reset()
+{
+    /*! \brief Make the next frame due, e.g. when the source starts. */
+    havePrior.store(false);
+    lastFrame.store(0);
+    lastNs.store(0);
+}
+
+bool product_schedule::due(uint64_t frameCount, std::chrono::steady_clock::time_point now,
+                           std::chrono::steady_clock::time_point lastDemand) const
+{
+    /*! \brief Whether the product should be computed for frame frameCount, arriving at now.
+     * lastDemand is when a reader last leased a frame, for PRODUCT_DISPLAY_RATE. */
+    if(!havePrior.load(std::memory_order_acquire))
+        return true;
+    switch(policy())
+    {
+    case PRODUCT_EVERY_FRAME:
+        return true;
+    case PRODUCT_EVERY_NTH:
+        return frameCount - lastFrame.load(std::memory_order_relaxed) >= every();
+    case PRODUCT_DISPLAY_RATE:
+    {
+        int64_t last = lastNs.load(std::memory_order_relaxed);
+        return (steadyNs(now) - last >= (int64_t)PRODUCT_DISPLAY_PERIOD_MS*1000000LL) &&
+                (steadyNs(lastDemand) > last);
+    }
+    }
+    return true;
+}
+
+void product_schedule::produced(uint64_t frameCount, std::chrono::steady_clock::time_point now)
+{
+    /*! \brief Record that the product was computed, or started, for frame frameCount. */
+    lastFrame.store(frameCount, std::memory_order_relaxed);
+    lastNs.store(steadyNs(now), std::memory_order_relaxed);
+    havePrior.store(true, std::memory_order_release);
+    producedCount.fetch_add(1, std::memory_order_relaxed);
+}
@@ -188,6 +188,7 @@ bool RTPCamera::initialize()
     currentFrameNumber = &data->currentFrameNumber;
     doneFrameNumber = &data->doneFrameNumber;
     frameCounter = &data->frameCounter;
+    data->notifier = &frameNotifier;
 
     g_object_set(appSink, "emit-signals", TRUE, "sync", FALSE, NULL);
 
@@ -366,6 +367,8 @@ static void siphonDataRGB (GstMapInfo* map, ProgramData *data)
 
     data->currentFrameNumber = (data->currentFrameNumber+1) % (guaranteedBufferFramesCount_rtp);
     data->frameCounter++;
+    if(data->notifier != NULL)
+        data->notifier->publish(data->frameCounter);
 
     // Frame timing metric
 #ifdef FPS_MEAS_ACQ
@@ -409,6 +412,8 @@ static void siphonDataGray (GstMapInfo* map, ProgramData *data)
 
     data->currentFrameNumber = (data->currentFrameNumber+1) % (guaranteedBufferFramesCount_rtp);
     data->frameCounter++;
+    if(data->notifier != NULL)
+        data->notifier->publish(data->frameCounter);
 
     // Frame timing metric
 #ifdef FPS_MEAS_ACQ
@@ -504,6 +509,14 @@ showerror:
     return true;
 }
 
+void RTPCamera::stop()
+{
+    // Ends streamLoop(). getFrameWait() returns once camcontrol->exit is set.
+    RLOG << "Stopping RTP stream";
+    if(loopRunning)
+        g_main_loop_quit (data->loop);
+}
+
 uint16_t* RTPCamera::getFrameWait(unsigned int lastFrameNumber, CameraModel::camStatusEnum *stat)
 {
     // This function pauses until a new frame is received,
@@ -529,10 +542,18 @@ uint16_t* RTPCamera::getFrameWait(unsigned int lastFrameNumber, CameraModel::cam
     }
     // TODO: There are states where these numbers do not update
     // and that too should be a timeout.
+    uint64_t seenSeq = frameNotifier.sequence();
+    pos = *doneFrameNumber;
     while(lastFrameDelivered==(unsigned int)pos)
     {
         *stat = camWaiting;
-        usleep(FRAME_WAIT_MIN_DELAY_US);
+        // Sleep until the appsink callback announces another frame:
+        seenSeq = frameNotifier.wait(seenSeq, TIMEOUT_DURATION);
+        if(camcontrol->exit)
+        {
+            *stat = CameraModel::camDone;
+            return timeoutFrame;
+        }
 //        if(tap++ > MAX_FRAME_WAIT_TAPS)
 //        {
 //            *stat = camTimeout;
@@ -82,11 +82,10 @@ rtpnextgen::~rtpnextgen() {
     LL(3) << "Done freeing RTP Frame buffer";
 
     LL(3) << "Freeing RTP LargePacketBuffer:";
+    frame_memory::release(largePacketBlock);
+    largePacketBlock = NULL;
     for(int b =0; b < networkPacketBufferFrames; b++) {
-        if(largePacketBuffer[b] != NULL) {
-            // EHL TODO: CAREFUL
-            free(largePacketBuffer[b]);
-        }
+        largePacketBuffer[b] = NULL;
     }
     LL(3) << "Done freeing RTP LPB.";
 
@@ -147,15 +146,20 @@ bool rtpnextgen::initialize() {
     // We are going to allocate 2x the frame size for the packets.
     // Generally we are using 12 bytes for the packet header, and perhaps 500 packets per frame
     // worst case, so perhaps 600kbyte of overhead is actually needed. Oh well, memory is cheap
+    // The frames are slices of one block, which follows take_object's huge page and
+    // NUMA policy (see frame_memory.hpp), since every packet is written into it.
     LL(5) << "Allocating LargePacketBuffer";
+    size_t lpbFrameBytes = frameBufferSizeBytes*2; // 2x overhead allowed
+    largePacketBlock = (uint8_t*)frame_memory::allocate(lpbFrameBytes*networkPacketBufferFrames);
+    if(largePacketBlock == NULL) {
+        LOG << "ERROR, cannot allocate memory for RTP NextGen Large Packet Buffer. Asked for " << lpbFrameBytes*networkPacketBufferFrames << " bytes.";
+        LOG << "ERROR, calling abort(). Program will crash.";
+        abort();
+    }
+    LOG << "Large Packet Buffer backed by " << frame_memory::backingName(frame_memory::backing(largePacketBlock));
     for(int f = 0; f < networkPacketBufferFrames; f++)
     {
-        largePacketBuffer[f] = (uint8_t*)calloc(frameBufferSizeBytes*2, 1); // 2x overhead allowed
-        if(largePacketBuffer[f] == NULL) {
-            LOG << "ERROR, cannot allocate memory for RTP NextGen Large Packet Buffer. Asked for " << frameBufferSizeBytes*2 << " bytes.";
-            LOG << "ERROR, calling abort(). Program will crash.";
-            abort();
-        }
+        largePacketBuffer[f] = largePacketBlock + lpbFrameBytes*f;
     }
 
     // Here we prepare the secondary buffer which stores only the size of each packet:
@@ -310,6 +314,7 @@ void rtpnextgen::RTPGetNextOutputBuffer( SRTPData& rtp, bool bLastBufferReady )
     currentFrameNumber = (currentFrameNumber+1) % (networkPacketBufferFrames);
     frameCounterNetworkSocket++;
     waitingForFirstFrame = false;
+    frameNotifier.publish(frameCounterNetworkSocket);
 }
 
 bool rtpnextgen::RTPExtract( uint8_t* pBuffer, size_t uSize, bool& bMarker,
@@ -613,6 +618,18 @@ void rtpnextgen::streamLoop() {
     LL(3) << "Finished RTPPump() with pumpCount = " << pumpCount;
 }
 
+void rtpnextgen::stop() {
+    // Ends streamLoop() and any getFrameWait(). recvfrom() is woken by shutting
+    // the socket down, which is closed later by the destructor.
+    LL(3) << "Stopping RTP NextGen stream";
+    g_bRunning = false;
+    if(camcontrol != NULL)
+        camcontrol->exit = true;
+    if((rtp.m_nHostSocket != -1 ) && (rtp.m_nHostSocket != 0) ) {
+        shutdown(rtp.m_nHostSocket, SHUT_RDWR);
+    }
+}
+
 uint16_t* rtpnextgen::getFrameWait(unsigned int lastFrameNumber, camStatusEnum *stat) {
     // This is a new function that attempts to mitigate situations of extreme buffer lag.
 
@@ -655,7 +672,7 @@ uint16_t* rtpnextgen::getFrameWait(unsigned int lastFrameNumber, camStatusEnum *
         // A little delay keeps the processor happy
         // Frames are available on the order of tens of microseconds.
         *stat = camWaiting;
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        frameNotifier.wait(0, RTPNG_TIMEOUT_DURATION);
         if(camcontrol->exit) {
             *stat = CameraModel::camDone;
             LL(4) << "Returning timeout frame due to camcontrol->exit flag.";
@@ -703,11 +720,16 @@ uint16_t* rtpnextgen::getFrameWait(unsigned int lastFrameNumber, camStatusEnum *
             // and thus should not end up inside here.
             waitingForFreshFrame = true;
             *stat = camWaiting;
-            // Idea, wait only if less than 10ns have passed.
 //            if((waitTaps%1000) == 0) {
 //                LOG << "TAP " << waitTaps << ", " << "writeFrame: " << writeFrame << ", lastFrame: " << lastFrameDelivered << ", lag: " << lagLevel << ", priorLag: " << lagLevelPrior << ", frames delivered: " << framesDeliveredCounter;
 //            }
-            std::this_thread::sleep_for(std::chrono::nanoseconds(10));
+            // Sample the sequence before re-reading doneFrameNumber, so that a frame
+            // finished in between is not missed, then sleep until the next one.
+            uint64_t seenSeq = frameNotifier.sequence();
+            writeFrame = doneFrameNumber;
+            if((int)lastFrameDelivered != writeFrame)
+                break;
+            frameNotifier.wait(seenSeq, RTPNG_TIMEOUT_DURATION);
             waitTaps++;
             writeFrame = doneFrameNumber; // update
             if(camcontrol->exit) {
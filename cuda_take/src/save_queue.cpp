@@ -0,0 +1,163 @@
+#include "save_queue.hpp"
+#include "frame_memory.hpp"
+
+#include <cstring>
+#include <chrono>
+
+save_queue::save_queue()
+{
+    head.store(0);
+    tail.store(0);
+    highWater.store(0);
+    dropped.store(0);
+    consumerWaiting.store(false);
+}
+
+save_queue::~save_queue()
+{
+    deallocate();
+}
+
+bool save_queue::allocate(size_t frameElements, unsigned int capacity)
+{
+    /*! \brief Allocate every frame slot up front.
+     * \param frameElements The number of uint16_t pixels in each frame, including any line header.
+     * \param capacity The number of frames which may be waiting to be written at once.
+     *
+     * The slots are zeroed so that the pages are resident before any frame is pushed.
+     * Must not be called while a producer or consumer is active.
+     */
+    deallocate();
+    if((frameElements == 0) || (capacity == 0))
+        return false;
+
+    size_t bytes = frameElements * capacity * sizeof(uint16_t);
+    void *mem = frame_memory::allocate(bytes);
+    if(mem == NULL)
+        return false;
+
+    slots = (uint16_t *)mem;
+    this->frameElements = frameElements;
+    this->slotCount = capacity;
+    allocatedElements = frameElements * capacity;
+    head.store(0);
+    tail.store(0);
+    resetStats();
+    return true;
+}
+
+bool save_queue::reuse(size_t frameElements, unsigned int capacity)
+{
+    /*! \brief Re-slice the current allocation for frames of frameElements pixels, if it is large enough.
+     * Returns false, leaving the queue untouched, if allocate() is needed instead. Any queued frames are discarded.
+     * Must not be called while a producer or consumer is active.
+     */
+    if((slots == NULL) || (frameElements == 0) || (capacity == 0) || (frameElements * capacity > allocatedElements))
+        return false;
+    this->frameElements = frameElements;
+    this->slotCount = capacity;
+    head.store(0);
+    tail.store(0);
+    resetStats();
+    return true;
+}
+
+void save_queue::deallocate()
+{
+    frame_memory::release(slots);
+    slots = NULL;
+    slotCount = 0;
+    frameElements = 0;
+    allocatedElements = 0;
+}
+
+bool save_queue::push(const uint16_t *frame)
+{
+    /*! \brief Copy a frame into the next free slot.
+     * Returns false, and counts the frame as dropped, if every slot is occupied. Producer thread only. */
+    if(slots == NULL)
+        return false;
+
+    uint64_t t = tail.load(std::memory_order_relaxed);
+    uint64_t h = head.load(std::memory_order_acquire);
+    if(t - h >= slotCount)
+    {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    memcpy(slots + (t % slotCount) * frameElements, frame, frameElements * sizeof(uint16_t));
+    tail.store(t + 1, std::memory_order_seq_cst);
+
+    unsigned int d = (unsigned int)(t + 1 - h);
+    if(d > highWater.load(std::memory_order_relaxed))
+        highWater.store(d, std::memory_order_relaxed);
+
+    if(consumerWaiting.load(std::memory_order_seq_cst))
+    {
+        std::lock_guard<std::mutex> lock(waitMutex);
+        frameReady.notify_one();
+    }
+    return true;
+}
+
+uint16_t *save_queue::front(unsigned int timeout_ms)
+{
+    /*! \brief Returns the oldest frame in the queue without removing it.
+     * Blocks for up to timeout_ms if the queue is empty, and returns NULL if nothing arrived. Consumer thread only. */
+    if(slots == NULL)
+        return NULL;
+
+    uint64_t h = head.load(std::memory_order_relaxed);
+    if(tail.load(std::memory_order_acquire) == h)
+    {
+        std::unique_lock<std::mutex> lock(waitMutex);
+        consumerWaiting.store(true, std::memory_order_seq_cst);
+        frameReady.wait_for(lock, std::chrono::milliseconds(timeout_ms), [this, h] {
+            return tail.load(std::memory_order_seq_cst) != h;
+        });
+        consumerWaiting.store(false, std::memory_order_relaxed);
+        if(tail.load(std::memory_order_acquire) == h)
+            return NULL;
+    }
+    return slots + (h % slotCount) * frameElements;
+}
+
+void save_queue::pop()
+{
+    /*! \brief Release the slot returned by front() back to the producer. Consumer thread only. */
+    uint64_t h = head.load(std::memory_order_relaxed);
+    if(tail.load(std::memory_order_acquire) != h)
+        head.store(h + 1, std::memory_order_release);
+}
+
+void save_queue::discardAll()
+{
+    /*! \brief Drop every frame currently in the queue. Consumer thread only, or any thread while there is no consumer. */
+    head.store(tail.load(std::memory_order_acquire), std::memory_order_release);
+}
+
+void save_queue::wake()
+{
+    /*! \brief Wake the consumer early, for example when recording has been stopped. */
+    std::lock_guard<std::mutex> lock(waitMutex);
+    frameReady.notify_all();
+}
+
+bool save_queue::empty() const
+{
+    return tail.load(std::memory_order_acquire) == head.load(std::memory_order_acquire);
+}
+
+unsigned int save_queue::depth() const
+{
+    uint64_t h = head.load(std::memory_order_acquire);
+    return (unsigned int)(tail.load(std::memory_order_acquire) - h);
+}
+
+void save_queue::resetStats()
+{
+    /*! \brief Zero the high-water mark and dropped count. Safe from any thread while the producer is not pushing. */
+    highWater.store(0);
+    dropped.store(0);
+}
@@ -4,6 +4,7 @@
 #include <cuda_profiler_api.h>
 #include <math.h>
 #include <iostream>
+#include <cstdlib>
 
 #define HANDLE_ERROR(err) (HandleError( err, __FILE__, __LINE__ ))
 
@@ -56,6 +57,14 @@ std_dev_filter::std_dev_filter(int nWidth, int nHeight)
     memcpy(histogram_bins,getHistogramBinValues().data(),NUMBER_OF_BINS*sizeof(float));
 
     HANDLE_ERROR(cudaMemcpyAsync(histogram_bins_device,histogram_bins,NUMBER_OF_BINS*sizeof(float),cudaMemcpyHostToDevice,std_dev_stream)); // Incrementally copies data to device (as each frame comes in it gets copied)
+
+    // Only the frames the kernel actually runs for receive a result, from STD_DEV_RESULT_SLOTS
+    // slots. Those of leased frames are skipped until released, see frame_pool::next().
+    if(!resultPool.allocate(frame_c::std_dev_bytes(width, height), STD_DEV_RESULT_SLOTS, frame_pool::PINNED_MEMORY))
+    {
+        std::cerr << "[std_dev_filter]: Could not allocate the result pool." << std::endl;
+        abort();
+    }
 }
 std_dev_filter::~std_dev_filter()
 {
@@ -68,13 +77,15 @@ std_dev_filter::~std_dev_filter()
     HANDLE_ERROR(cudaStreamDestroy(std_dev_stream));
 }
 
-void std_dev_filter::update_GPU_buffer(frame_c * frame, unsigned int N)
+bool std_dev_filter::update_GPU_buffer(frame_c * frame, unsigned int N, bool calculate)
 {
     /*! \brief CPU code for launching the kernel and copying over the result of the standard deviation calculation.
      * \param frame The current frame to be worked on.
      * \param N The number of frames to use in the buffer, or the integration length of the calculation.
+     * \param calculate Launch the kernel for this frame if the stream is idle, rather than only adding it to the ring
+     * \return Whether the kernel was launched for this frame
      */
-    static int count = 0;
+    bool launched = false;
 
     // Synchronous
     /* Step 1: Set the device, get the status, and create a pointer to the current position on the device ring buffer. */
@@ -91,14 +102,19 @@ void std_dev_filter::update_GPU_buffer(frame_c * frame, unsigned int N)
         printf("really weird\n"); // Noah wrote this debug line. I'm not sure when or why it triggers...
     }
 
-    if(cudaSuccess == std_dev_stream_status)
+    /* Step 3: If there are no errors, check that there are std. dev. frames ready to be displayed. This is done
+     * whenever the stream is idle, as the next launch may be some frames away. */
+    if((cudaSuccess == std_dev_stream_status) && (prevFrame != NULL))
     {
-        /* Step 3: If there are no errors, check that there are std. dev. frames ready to be displayed */
-        if(prevFrame != NULL)
-        {
-            prevFrame->has_valid_std_dev = 2; // Ready to display
-        }
+        prevFrame->has_valid_std_dev = 2; // Ready to display
+        prevFrame = NULL;
+    }
+
+    if(calculate && (cudaSuccess == std_dev_stream_status))
+    {
+        launched = true;
 
+        frame->attach_std_dev(resultPool.next());
         frame->has_valid_std_dev = 1; // is processing
         prevFrame = frame;
 
@@ -130,7 +146,8 @@ void std_dev_filter::update_GPU_buffer(frame_c * frame, unsigned int N)
     {
         currentN++; //Increment how much history is available
     }
-    count++;
+    framesAdded++;
+    return launched;
 }
 uint16_t * std_dev_filter::getEntireRingBuffer() //For testing only
 {
@@ -0,0 +1,326 @@
+#ifdef CPU_ONLY
+#include "std_dev_filter.hpp"
+#include "constants.h"
+#include <math.h>
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <pthread.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define STD_DEV_WINDOW_X86
+#endif
+
+// The host side of std_dev_filter for CPU_ONLY builds, in place of std_dev_filter.cpp
+// and the kernel. The results are those of std_dev_filter_kernel.
+//
+// Rather than summing all N frames for every result, as the kernel does, the
+// worker keeps the sum and the sum of squares of each pixel over the window of
+// N frames, and slides it along by adding each new frame and taking away the
+// one which drops out. The sums are integers, so they stay exact however long
+// the window slides, and are the very values the kernel adds up in double.
+// The window is summed afresh from the ring when N changes, when the worker has
+// fallen so far behind that the frames it would take away may be overwritten,
+// and every STD_DEV_RESYNC_FRAMES frames: the ring is written while the worker
+// reads it, as the device ring is while the kernel runs, and a frame which
+// changed between being added and taken away would otherwise stay in the sums.
+
+namespace
+{
+    typedef void (*window_row_t)(uint32_t *sum, uint64_t *sq_sum, const uint16_t *added, const uint16_t *expired,
+                                 unsigned int width);
+
+    void slide_row_tail(uint32_t *sum, uint64_t *sq_sum, const uint16_t *added, const uint16_t *expired,
+                        unsigned int begin, unsigned int width)
+    {
+        for(unsigned int col = begin; col < width; col++)
+        {
+            uint32_t a = added[col];
+            uint32_t e = (expired != NULL) ? expired[col] : 0;
+            sum[col] += a - e; // modulo 2^32, the sum itself is never negative
+            sq_sum[col] += (uint64_t)(a*a) - (uint64_t)(e*e);
+        }
+    }
+
+    void slide_row_scalar(uint32_t *sum, uint64_t *sq_sum, const uint16_t *added, const uint16_t *expired,
+                          unsigned int width)
+    {
+        slide_row_tail(sum, sq_sum, added, expired, 0, width);
+    }
+
+#ifdef STD_DEV_WINDOW_X86
+    __attribute__((target("avx2")))
+    void slide_row_avx2(uint32_t *sum, uint64_t *sq_sum, const uint16_t *added, const uint16_t *expired,
+                        unsigned int width)
+    {
+        // 8 pixels at a time. A 16 bit value squared fits in 32 bits, so the
+        // squares are made with mullo and only widened to add them.
+        const __m128i zero = _mm_setzero_si128();
+        unsigned int col = 0;
+        for(; col + 8 <= width; col += 8)
+        {
+            __m256i a = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)(added + col)));
+            __m256i e = _mm256_cvtepu16_epi32((expired != NULL) ? _mm_loadu_si128((const __m128i *)(expired + col)) : zero);
+            __m256i s = _mm256_loadu_si256((const __m256i *)(sum + col));
+            _mm256_storeu_si256((__m256i *)(sum + col), _mm256_add_epi32(s, _mm256_sub_epi32(a, e)));
+
+            __m256i aa = _mm256_mullo_epi32(a, a);
+            __m256i ee = _mm256_mullo_epi32(e, e);
+            __m256i lo = _mm256_sub_epi64(_mm256_cvtepu32_epi64(_mm256_castsi256_si128(aa)),
+                                          _mm256_cvtepu32_epi64(_mm256_castsi256_si128(ee)));
+            __m256i hi = _mm256_sub_epi64(_mm256_cvtepu32_epi64(_mm256_extracti128_si256(aa, 1)),
+                                          _mm256_cvtepu32_epi64(_mm256_extracti128_si256(ee, 1)));
+            __m256i *sq = (__m256i *)(sq_sum + col);
+            _mm256_storeu_si256(sq, _mm256_add_epi64(_mm256_loadu_si256(sq), lo));
+            _mm256_storeu_si256(sq + 1, _mm256_add_epi64(_mm256_loadu_si256(sq + 1), hi));
+        }
+        slide_row_tail(sum, sq_sum, added, expired, col, width);
+    }
+#endif
+
+    bool window_avx2()
+    {
+#ifdef STD_DEV_WINDOW_X86
+        static const bool avx2 = __builtin_cpu_supports("avx2");
+        return avx2;
+#else
+        return false;
+#endif
+    }
+
+    window_row_t select_slide_row()
+    {
+#ifdef STD_DEV_WINDOW_X86
+        if(window_avx2())
+            return &slide_row_avx2;
+#endif
+        return &slide_row_scalar;
+    }
+}
+
+std_dev_filter::std_dev_filter(int nWidth, int nHeight)
+{
+    /*! \brief Allocate the ring of frames in host memory and start the worker thread.
+     * \param nWidth The frame width. This is specified initially and cannot be changed during operation.
+     * \param nHeight The frame height. This is speccified initially and cannot be changed during operation.
+     */
+    printf("[std_dev_filter]: CPU only build, calculating on the host with a sliding window (%s).\n",
+           window_avx2() ? "AVX2" : "scalar");
+
+    width = nWidth;
+    height = nHeight;
+    gpu_buffer_head = 0;
+    currentN = 0;
+    lastN = 0;
+
+    pictures_host = (uint16_t *)frame_memory::allocate((size_t)width*height*sizeof(uint16_t)*GPU_FRAME_BUFFER_SIZE);
+    window_sum = (uint32_t *)frame_memory::allocate((size_t)width*height*sizeof(uint32_t));
+    window_sq_sum = (uint64_t *)frame_memory::allocate((size_t)width*height*sizeof(uint64_t));
+    if((pictures_host == NULL) || (window_sum == NULL) || (window_sq_sum == NULL))
+    {
+        std::cerr << "[std_dev_filter]: Could not allocate the frame ring." << std::endl;
+        abort();
+    }
+    memcpy(histogram_bins,getHistogramBinValues().data(),NUMBER_OF_BINS*sizeof(float));
+
+    // Only the frames a calculation is started for receive a result, from STD_DEV_RESULT_SLOTS
+    // slots. Those of leased frames are skipped until released, see frame_pool::next().
+    if(!resultPool.allocate(frame_c::std_dev_bytes(width, height), STD_DEV_RESULT_SLOTS, frame_pool::PINNED_MEMORY))
+    {
+        std::cerr << "[std_dev_filter]: Could not allocate the result pool." << std::endl;
+        abort();
+    }
+
+    worker = std::thread(&std_dev_filter::workerLoop, this);
+    pthread_setname_np(worker.native_handle(), "STDDEV");
+}
+std_dev_filter::~std_dev_filter()
+{
+    /*! Let the worker finish its calculation, then free the ring. */
+    {
+        std::lock_guard<std::mutex> lock(workLock);
+        workerExit = true;
+    }
+    workReady.notify_one();
+    worker.join();
+    frame_memory::release(pictures_host);
+    frame_memory::release(window_sum);
+    frame_memory::release(window_sq_sum);
+}
+
+bool std_dev_filter::update_GPU_buffer(frame_c * frame, unsigned int N, bool calculate)
+{
+    /*! \brief Add the frame to the ring, and start a calculation for it if the worker is idle.
+     * \param frame The current frame to be worked on.
+     * \param N The number of frames to use in the buffer, or the integration length of the calculation.
+     * \param calculate Start a calculation for this frame if the worker is idle, rather than only adding it to the ring
+     * \return Whether a calculation was started for this frame
+     */
+    bool started = false;
+    if(N > MAX_N)
+        N = MAX_N;
+    if(N == 0)
+        N = 1;
+    memcpy(pictures_host + (size_t)gpu_buffer_head*width*height, frame->image_data_ptr, (size_t)width*height*sizeof(uint16_t));
+
+    {
+        std::lock_guard<std::mutex> lock(workLock);
+        if(!workPending && !workBusy)
+        {
+            // The calculation for prevFrame is complete. It is marked as soon as
+            // that is seen, as the next calculation may be some frames away.
+            if(prevFrame != NULL)
+            {
+                prevFrame->has_valid_std_dev = 2; // Ready to display
+                prevFrame = NULL;
+            }
+        }
+        if(calculate && !workPending && !workBusy)
+        {
+            started = true;
+            frame->attach_std_dev(resultPool.next());
+            frame->has_valid_std_dev = 1; // is processing
+            prevFrame = frame;
+
+            workFrame = frame;
+            workEnd = framesAdded + 1;
+            workN = N;
+            workPending = true;
+            workReady.notify_one();
+        }
+    }
+
+    if(++gpu_buffer_head == GPU_FRAME_BUFFER_SIZE) //Increment and test for ring buffer overflow
+        gpu_buffer_head = 0; // If overflow, than start overwriting the front
+    framesAdded++;
+    if(currentN < MAX_N) // If the frame buffer has not been fully populated
+    {
+        currentN++; //Increment how much history is available
+    }
+    return started;
+}
+
+void std_dev_filter::workerLoop()
+{
+    // Stands in for the CUDA stream, one calculation at a time.
+    std::unique_lock<std::mutex> lock(workLock);
+    while(true)
+    {
+        workReady.wait(lock, [this] { return workPending || workerExit; });
+        if(workerExit)
+            return;
+        frame_c *frame = workFrame;
+        uint64_t end = workEnd;
+        unsigned int N = workN;
+        workPending = false;
+        workBusy = true;
+        lock.unlock();
+        calculate(frame, end, N);
+        lock.lock();
+        workBusy = false;
+    }
+}
+
+const uint16_t *std_dev_filter::ringFrame(uint64_t index) const
+{
+    // Frame number index, counted from the first frame added, as the ring holds it.
+    return pictures_host + (size_t)(index % GPU_FRAME_BUFFER_SIZE)*width*height;
+}
+
+void std_dev_filter::moveWindow(uint64_t end, unsigned int N)
+{
+    /*! \brief Bring the window sums to the N frames before frame number end.
+     * Sliding reads back to windowEnd - N, so it is only done while that is well clear of the frames the
+     * producer may be overwriting meanwhile: it runs at most GPU_FRAME_BUFFER_SIZE - N frames ahead of end,
+     * and half of that is left to it. Otherwise, and every STD_DEV_RESYNC_FRAMES frames, the sums are
+     * made afresh from the N frames alone, as the kernel reads them. Frames before the first one added
+     * are zero, as the ring starts out.
+     */
+    const size_t pixels = (size_t)width*height;
+    const window_row_t slide_row = select_slide_row();
+    bool slide = (N == windowN) && (end >= windowEnd) && (end - windowEnd <= (GPU_FRAME_BUFFER_SIZE - N) / 2)
+            && (end - windowSummedAt < STD_DEV_RESYNC_FRAMES);
+    uint64_t first = windowEnd;
+    if(!slide)
+    {
+        memset(window_sum, 0, pixels*sizeof(uint32_t));
+        memset(window_sq_sum, 0, pixels*sizeof(uint64_t));
+        first = (end > N) ? end - N : 0;
+        windowSummedAt = end;
+    }
+
+    #pragma omp parallel for schedule(static)
+    for(int row = 0; row < (int)height; row++)
+    {
+        const size_t offset = (size_t)row*width;
+        for(uint64_t k = first; k < end; k++)
+        {
+            const uint16_t *expired = (slide && (k >= N)) ? ringFrame(k - N) + offset : NULL;
+            slide_row(window_sum + offset, window_sq_sum + offset, ringFrame(k) + offset, expired, width);
+        }
+    }
+    windowEnd = end;
+    windowN = N;
+}
+
+void std_dev_filter::calculate(frame_c *frame, uint64_t end, unsigned int N)
+{
+    /*! \brief The standard deviation of each pixel over the N frames before frame number end, and its histogram.
+     * The window is moved along first, see moveWindow(), so that only the frames added since the last
+     * calculation are read. The rows are split across threads.
+     */
+    moveWindow(end, N);
+
+    float *out = frame->std_dev_data;
+    uint32_t *histogram = frame->std_dev_histogram;
+    memset(histogram, 0, NUMBER_OF_BINS*sizeof(uint32_t));
+
+    #pragma omp parallel
+    {
+        std::vector<uint32_t> thread_histogram(NUMBER_OF_BINS, 0);
+
+        #pragma omp for schedule(static)
+        for(int row = 0; row < (int)height; row++)
+        {
+            const size_t offset = (size_t)row*width;
+            for(unsigned int col = 0; col < width; col++)
+            {
+                double sum = window_sum[offset + col];
+                double sq_sum = (double)window_sq_sum[offset + col];
+                double mean = sum / (double)N;
+                double variance = ((sq_sum - 2.0*mean*sum) / (double)N) + mean*mean;
+                double std_dev = (variance > 0.0) ? sqrt(variance) : 0.0;
+                out[offset + col] = std_dev;
+                thread_histogram[log_bins.bin(std_dev)]++;
+            }
+        }
+
+        #pragma omp critical
+        {
+            for(unsigned int c = 0; c < NUMBER_OF_BINS; c++)
+                histogram[c] += thread_histogram[c];
+        }
+    }
+}
+
+uint16_t * std_dev_filter::getEntireRingBuffer() //For testing only
+{
+    /*! Captures the ring buffer of standard deviation frames. */
+    uint16_t * out = new uint16_t[width*height*MAX_N];
+    memcpy(out,pictures_host,width*height*sizeof(uint16_t)*MAX_N);
+    return out;
+}
+std::vector <float> * std_dev_filter::getHistogramBins()
+{
+    /*! Captures all current histogram bins. */
+    shb.assign(histogram_bins,histogram_bins+NUMBER_OF_BINS);
+    return &shb;
+}
+bool std_dev_filter::outputReady()
+{
+    /*! Returns true if std. dev. frames are ready to be plotted. */
+    return !(currentN < lastN);
+}
+
+#endif // CPU_ONLY
@@ -72,6 +72,17 @@ __global__ void std_dev_filter_kernel(uint16_t * pic_d, float * picture_out_devi
 		printf("\n");
 
 	}
+	// The first bin not below std_dev. The bins are exp(c*ln(2^16)/NUMBER_OF_BINS)-1, so the search
+	// starts from the inverse of that and moves a step or two at most, see log_histogram.hpp.
+	if(std_dev > histogram_bins[0])
+	{
+		double guess = ceil(log1p(std_dev) * (NUMBER_OF_BINS / 11.090354888959125)); // ln(2^16)
+		c = (guess < 1) ? 1 : (guess > NUMBER_OF_BINS-1) ? NUMBER_OF_BINS-1 : (int)guess;
+		while(c > 0 && std_dev <= histogram_bins[c-1])
+		{
+			c--;
+		}
+	}
 	while(std_dev > histogram_bins[c] && c < (NUMBER_OF_BINS-1))
 	{
 		c++;
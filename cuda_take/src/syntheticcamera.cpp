@@ -0,0 +1,272 @@
+#include "syntheticcamera.hpp"
+#include "frame_memory.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <random>
+#include <chrono>
+
+namespace
+{
+    const uint32_t NOISE_SEED = 5489; // the default seed of std::mt19937
+    const double NOISE_MEAN = 8192;
+    const size_t PATTERN_OFFSETS = 65536; // where each frame may start in the ramp row or the noise pool
+
+    int64_t monotonicNs()
+    {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (int64_t)ts.tv_sec*1000000000LL + ts.tv_nsec;
+    }
+
+    void sleepUntilNs(int64_t ns)
+    {
+        timespec ts;
+        ts.tv_sec = ns / 1000000000LL;
+        ts.tv_nsec = ns % 1000000000LL;
+        while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR);
+    }
+
+    uint64_t mix(uint64_t x)
+    {
+        // splitmix64, so that consecutive frames start far apart in the noise pool
+        x += 0x9e3779b97f4a7c15ULL;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+}
+
+SyntheticCamera::SyntheticCamera(const takeOptionsType &options)
+{
+    frame_width = options.syntheticWidth;
+    frame_height = options.syntheticHeight;
+    data_height = options.syntheticHeight;
+    camera_name = NULL;
+    camera_type = CL_6604A;
+    source_type = CAMERA_LINK;
+
+    pattern = options.syntheticPattern;
+    fps = (options.syntheticFPS > 0) ? options.syntheticFPS : 100;
+    sigma = options.syntheticSigma;
+    dropEvery = options.syntheticDropEvery;
+
+    ticks.store(0);
+    delivered.store(0);
+    injectedDrops.store(0);
+    overruns.store(0);
+    lateTicks.store(0);
+    startNs.store(0);
+    lastNs.store(0);
+
+    framePixels = (size_t)frame_width * data_height;
+    ringBlock = (uint16_t*)frame_memory::allocate(framePixels*sizeof(uint16_t)*SYNTHETIC_RING_FRAMES);
+    doneFrame = (uint16_t*)calloc(framePixels, sizeof(uint16_t));
+    if((ringBlock == NULL) || (doneFrame == NULL))
+    {
+        LOG << "ERROR, cannot allocate memory for the synthetic camera. Asked for "
+            << framePixels*sizeof(uint16_t)*(SYNTHETIC_RING_FRAMES+1) << " bytes.";
+        LOG << "ERROR, calling abort(). Program will crash.";
+        abort();
+    }
+    for(unsigned int f = 0; f < SYNTHETIC_RING_FRAMES; f++)
+        ring[f] = ringBlock + framePixels*f;
+
+    if(pattern == SYNTHETIC_NOISE)
+    {
+        // Drawn once, so each run and each frame sees the same statistics. The
+        // sigma reported is that of the stored integers, which is what the
+        // standard deviation filter should find.
+        std::mt19937 generator(NOISE_SEED);
+        std::normal_distribution<double> normal(NOISE_MEAN, sigma);
+        noisePool.resize(framePixels + PATTERN_OFFSETS);
+        double sum = 0;
+        double sumSquares = 0;
+        for(size_t p = 0; p < noisePool.size(); p++)
+        {
+            double v = std::round(normal(generator));
+            v = std::min(65535.0, std::max(0.0, v));
+            noisePool[p] = (uint16_t)v;
+            sum += v;
+            sumSquares += v*v;
+        }
+        double mean = sum / noisePool.size();
+        poolSigma = std::sqrt(std::max(0.0, sumSquares / noisePool.size() - mean*mean));
+        LOG << "Synthetic noise pattern, mean " << mean << ", sigma " << poolSigma;
+    } else {
+        pattern = SYNTHETIC_RAMP;
+        rampRow.resize(frame_width + PATTERN_OFFSETS);
+        for(size_t p = 0; p < rampRow.size(); p++)
+            rampRow[p] = (uint16_t)(p & 0xffff);
+        LOG << "Synthetic ramp pattern";
+    }
+
+    LOG << "Synthetic camera with width: " << frame_width << ", height: " << frame_height << ", " << fps << " frames per second"
+        << ", ring backed by " << frame_memory::backingName(frame_memory::backing(ringBlock));
+    if(dropEvery > 0)
+        LOG << "Dropping one frame in every " << dropEvery;
+    running.store(true);
+}
+
+SyntheticCamera::~SyntheticCamera()
+{
+    stop();
+    frame_memory::release(ringBlock);
+    ringBlock = NULL;
+    free(doneFrame);
+    doneFrame = NULL;
+}
+
+void SyntheticCamera::makeFrame(uint16_t *frame, uint64_t tick)
+{
+    if(pattern == SYNTHETIC_NOISE)
+    {
+        size_t offset = mix(tick) % PATTERN_OFFSETS;
+        memcpy(frame, noisePool.data() + offset, framePixels*sizeof(uint16_t));
+    } else {
+        for(int y = 0; y < data_height; y++)
+            memcpy(frame + (size_t)y*frame_width, rampRow.data() + ((y + tick) & 0xffff), frame_width*sizeof(uint16_t));
+    }
+    if(frame_width > 160)
+    {
+        frame[160] = (uint16_t)(tick & 0xffff);
+        frame[159] = headerStatus;
+    }
+}
+
+void SyntheticCamera::streamLoop()
+{
+    // Tick t is due at start + t*period. Long waits are cut into slices so that
+    // stop() is noticed at low frame rates too.
+    const int64_t period = (int64_t)std::llround(1E9 / fps);
+    const int64_t spin = SYNTHETIC_SPIN_US * 1000LL;
+    const int64_t slice = 100000000LL;
+    const int64_t start = monotonicNs();
+    startNs.store(start);
+
+    for(uint64_t t = 0; running.load(); t++)
+    {
+        const int64_t deadline = start + (int64_t)t*period;
+        int64_t now = monotonicNs();
+        while((now < deadline - spin) && running.load())
+        {
+            sleepUntilNs(std::min(deadline - spin, now + slice));
+            now = monotonicNs();
+        }
+        while(now < deadline)
+            now = monotonicNs();
+        if(!running.load())
+            break;
+        if(now - deadline > spin)
+            lateTicks.fetch_add(1, std::memory_order_relaxed);
+        ticks.fetch_add(1, std::memory_order_relaxed);
+        lastNs.store(now, std::memory_order_relaxed);
+
+        if((dropEvery > 0) && ((t % dropEvery) == dropEvery - 1))
+        {
+            injectedDrops.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        uint64_t d;
+        {
+            std::lock_guard<std::mutex> lock(handoffLock);
+            d = published + 1;
+            if((d % SYNTHETIC_RING_FRAMES) == (held % SYNTHETIC_RING_FRAMES))
+            {
+                overruns.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+        }
+        // Written outside the lock: the consumer only takes frames up to
+        // published, and the slot after the one it holds is the oldest.
+        makeFrame(ring[d % SYNTHETIC_RING_FRAMES], t);
+        {
+            std::lock_guard<std::mutex> lock(handoffLock);
+            published = d;
+        }
+        frameReady.notify_one();
+    }
+}
+
+uint16_t* SyntheticCamera::getFrameWait(unsigned int lastFrameNumber, CameraModel::camStatusEnum *stat)
+{
+    // The next frame, which stays untouched until the following call.
+    (void)lastFrameNumber;
+    std::unique_lock<std::mutex> lock(handoffLock);
+    while(true)
+    {
+        if(!running.load() || ((camcontrol != NULL) && camcontrol->exit))
+        {
+            *stat = CameraModel::camDone;
+            return doneFrame;
+        }
+        if(published > held)
+            break;
+        frameReady.wait_for(lock, std::chrono::milliseconds(100));
+    }
+
+    held++;
+    delivered.fetch_add(1, std::memory_order_relaxed);
+    *stat = CameraModel::camPlaying;
+    return ring[held % SYNTHETIC_RING_FRAMES];
+}
+
+uint16_t* SyntheticCamera::getFrame(CameraModel::camStatusEnum *stat)
+{
+    return getFrameWait(0, stat);
+}
+
+void SyntheticCamera::stop()
+{
+    // Ends streamLoop() and any getFrameWait().
+    running.store(false);
+    frameReady.notify_all();
+    report();
+}
+
+synthetic_stats_t SyntheticCamera::stats()
+{
+    synthetic_stats_t s;
+    s.ticks = ticks.load(std::memory_order_relaxed);
+    s.delivered = delivered.load(std::memory_order_relaxed);
+    s.injectedDrops = injectedDrops.load(std::memory_order_relaxed);
+    s.overruns = overruns.load(std::memory_order_relaxed);
+    s.lateTicks = lateTicks.load(std::memory_order_relaxed);
+    int64_t start = startNs.load();
+    if(start != 0)
+        s.seconds = (lastNs.load(std::memory_order_relaxed) - start) / 1E9;
+    return s;
+}
+
+void SyntheticCamera::report()
+{
+    {
+        std::lock_guard<std::mutex> lock(handoffLock);
+        if(reported)
+            return;
+        reported = true;
+    }
+    synthetic_stats_t s = stats();
+    LOG << "Synthetic camera final report:";
+    LOG << "Frames made:     " << s.ticks << " in " << s.seconds << " s, "
+        << ((s.seconds > 0) ? (s.ticks - 1) / s.seconds : 0) << " per second (target " << fps << ")";
+    LOG << "Delivered:       " << s.delivered;
+    LOG << "Injected drops:  " << s.injectedDrops;
+    LOG << "Overruns:        " << s.overruns;
+    LOG << "Late ticks:      " << s.lateTicks;
+}
+
+camControlType* SyntheticCamera::getCamControlPtr()
+{
+    return this->camcontrol;
+}
+
+void SyntheticCamera::setCamControlPtr(camControlType* p)
+{
+    this->camcontrol = p;
+}
@@ -0,0 +1,157 @@
+#include "take_object.hpp"
+#include "daemon_config.hpp"
+#include "command_server.hpp"
+
+#include <csignal>
+#include <memory>
+#include <vector>
+#include <cstring>
+#include <pthread.h>
+#include <unistd.h>
+
+/*! \file
+ * \brief take_daemon, an unattended recorder built on take_object without any of LiveView's GUI.
+ * \paragraph
+ *
+ * It runs one take_object with the options of a daemon_config_t, publishes frames to shared memory if the
+ * configuration asks for it, and answers the saveServer commands through a command_server, so an operator or a
+ * flight computer starts and stops recordings exactly as it does with LiveView. There is no event loop: after
+ * startup the main thread sleeps in sigwait(). SIGINT and SIGTERM stop any recording, let the saving thread close
+ * its file, and shut take_object down. SIGHUP reads the configuration file again and switches to its source with
+ * take_object::reconfigure(), unless a recording is running; the server address and port are kept.
+ * \paragraph
+ *
+ * Usage: take_daemon [-c take_daemon.conf]. Without a configuration file the defaults of takeOptionsType are used,
+ * which open the first camera link channel. See daemon_config.hpp for the keys.
+ */
+
+static const unsigned int SAVE_CLOSE_TIMEOUT_MS = 10000;
+
+static void daemonMessage(const std::string &message)
+{
+    std::cout << "[take_daemon]: " << message << std::endl;
+}
+
+static bool loadConfig(const char *path, std::unique_ptr<daemon_config_t> &config)
+{
+    config.reset(new daemon_config_t);
+    if(path == NULL)
+        return true;
+    std::string error;
+    if(!load_daemon_config(path, *config, error))
+    {
+        std::cerr << "[take_daemon]: ERROR: " << error << std::endl;
+        return false;
+    }
+    return true;
+}
+
+static void applyDarkFile(take_object *to, const daemon_config_t &config)
+{
+    if(config.darkFile.empty())
+        return;
+    to->loadDSFMask(config.darkFile);
+    to->useDSF = true;
+    daemonMessage("Dark mask loaded from " + config.darkFile);
+}
+
+static void stopRecording(take_object *to)
+{
+    if(!to->isSaving())
+        return;
+    daemonMessage("Stopping the recording in progress.");
+    to->stopSavingRaws();
+    for(unsigned int ms = 0; to->isSaving() && (ms < SAVE_CLOSE_TIMEOUT_MS); ms += 10)
+        usleep(10000);
+    if(to->isSaving())
+        daemonMessage("The saving thread did not finish, the file may be incomplete.");
+}
+
+int main(int argc, char *argv[])
+{
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    const char *configPath = NULL;
+    for(int c = 1; c < argc; c++)
+    {
+        std::string arg = argv[c];
+        if(((arg == "-c") || (arg == "--config")) && (c + 1 < argc))
+        {
+            configPath = argv[++c];
+        } else {
+            std::cout << "Usage: " << argv[0] << " [-c take_daemon.conf]" << std::endl;
+            return (arg == "-h") || (arg == "--help") ? 0 : 1;
+        }
+    }
+
+    // Every thread started from here on inherits the mask, so the signals are only
+    // ever taken by the sigwait() below.
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    sigaddset(&signals, SIGHUP);
+    pthread_sigmask(SIG_BLOCK, &signals, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    std::unique_ptr<daemon_config_t> config;
+    if(!loadConfig(configPath, config))
+        return 1;
+
+    take_object *to = new take_object(config->options);
+    to->start();
+    if(config->options.xioCam)
+        to->setReadDirectory(config->xioDirectory.c_str());
+    applyDarkFile(to, *config);
+
+    command_server server(to);
+    server.setFlightNaming(config->dataLocation, config->namePrefix);
+    if(!server.start(config->serverAddress.c_str(), config->serverPort))
+    {
+        delete to;
+        return 1;
+    }
+
+    std::ostringstream ready;
+    ready << "Ready in " << std::chrono::duration_cast<std::chrono::milliseconds>(
+                 std::chrono::steady_clock::now() - begin).count() << " ms, "
+          << to->getFrameWidth() << "x" << to->getDataHeight() << " frames.";
+    daemonMessage(ready.str());
+
+    std::vector<std::unique_ptr<daemon_config_t>> retired; // failed reloads, which take_object may point into
+    while(true)
+    {
+        int sig = 0;
+        if(sigwait(&signals, &sig) != 0)
+            continue;
+        if(sig != SIGHUP)
+        {
+            daemonMessage(std::string("Received ") + strsignal(sig) + ", shutting down.");
+            break;
+        }
+        if(configPath == NULL)
+        {
+            daemonMessage("Received SIGHUP without a configuration file, nothing to reload.");
+            continue;
+        }
+        daemonMessage(std::string("Received SIGHUP, reloading ") + configPath);
+        std::unique_ptr<daemon_config_t> next;
+        if(!loadConfig(configPath, next))
+            continue;
+        if(!to->reconfigure(next->options))
+        {
+            // If it failed opening the new source, take_object has its options already.
+            retired.push_back(std::move(next));
+            daemonMessage("Reload failed, see the messages above.");
+            continue;
+        }
+        applyDarkFile(to, *next);
+        server.setFlightNaming(next->dataLocation, next->namePrefix);
+        config.swap(next); // take_object now points into the new configuration's strings
+    }
+
+    server.stop();
+    stopRecording(to);
+    delete to;
+    daemonMessage("Goodbye.");
+    return 0;
+}
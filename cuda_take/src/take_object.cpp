@@ -33,7 +33,12 @@ void take_object::initialSetup(int channel_num, int number_of_buffers,
     this->numbufs = number_of_buffers;
     this->filter_refresh_rate = filter_refresh_rate;
 
-    frame_ring_buffer = new frame_c[CPU_FRAME_BUFFER_SIZE];
+    frame_ring_buffer = NULL; // allocated in start() once the geometry is known
+    leaseSkips = 0;
+    leaseOverruns = 0;
+    productsInFlight = 0;
+    productSkips = 0;
+    graphStalls = 0;
 
     //For the filters
     dsfMaskCollected = false;
@@ -57,7 +62,6 @@ void take_object::initialSetup(int channel_num, int number_of_buffers,
     save_framenum = 0;
     save_count=0;
     save_num_avgs=1;
-    saving_list.clear();
 
     camStatus = CameraModel::camUnknown;
 }
@@ -66,12 +70,15 @@ take_object::~take_object()
 {
     closing = true;
     rtpConsumerRun = false;
+    frameNotifier.wakeAll();
 
     while(grabbing)
     {
         // wait here for last frame to complete
         usleep(1000);
     }
+    drainFrameGraph(); // finishes the graphs of the frames already acquired
+    stopRingFill();
     if(pdv_thread_run != 0) {
         pdv_thread_run = 0;
 
@@ -99,8 +106,9 @@ take_object::~take_object()
     }
 
     delete[] frame_ring_buffer;
+    delete[] sequenceSlot;
 
-#ifdef RESET_GPUS
+#if defined(RESET_GPUS) && !defined(CPU_ONLY)
     printf("reseting GPUs!\n");
     int count;
     cudaGetDeviceCount(&count);
@@ -151,7 +159,10 @@ void take_object::changeOptions(takeOptionsType optionsIn)
         if(options.rtpNextGen) {
             statusMessage("RTP Camera is NextGen model");
         }
-        if((!options.rtpCam) && (!options.xioCam)) {
+        if(options.syntheticCam) {
+            statusMessage(std::string("Synthetic camera enabled, ") + std::to_string(options.syntheticWidth) + "x" +
+                          std::to_string(options.syntheticHeight) + " at " + std::to_string(options.syntheticFPS) + " FPS.");
+        } else if((!options.rtpCam) && (!options.xioCam)) {
             statusMessage("CameraLink enabled.");
         }
     }
@@ -170,15 +181,17 @@ void take_object::shmSetup()
         return;
     }
 
+    // Each pipeline in the process needs a segment of its own, see takeOptionsType::shmName.
+    std::string shmName = (options.shmName != NULL) ? options.shmName : "/liveview_image";
     size_t shmLen = sizeof(struct shmSharedDataStruct);
-    shmFd = shm_open("/liveview_image", O_RDWR | O_CREAT ,S_IRUSR | S_IWUSR);
+    shmFd = shm_open(shmName.c_str(), O_RDWR | O_CREAT ,S_IRUSR | S_IWUSR);
 
     if(shmFd == -1) {
         errorMessage("Could not open shared memory segment.");
         shmValid = false;
         return;
     } else {
-        statusMessage("Created shared memory segment /liveview_image");
+        statusMessage("Created shared memory segment " + shmName);
     }
 
     char trunmessage[128];
@@ -233,18 +246,135 @@ void take_object::shmSetup()
     }
 }
 
+void take_object::updateShmGeometry()
+{
+    // The segment has a fixed frame size (see shm_image.h), so frames which
+    // do not fit are not published. A segment which is already mapped is
+    // kept, marked as waiting, for a later geometry which fits again.
+#ifdef USE_SHM
+    bool mapped = (shm != NULL) && (shm != MAP_FAILED);
+    if(!options.useSHM)
+    {
+        if(shmValid)
+            shm->statusByte = SHM_STATUS_CLOSED;
+        shmValid = false;
+        return;
+    }
+    if((size_t)frWidth*frHeight > (size_t)shmWidth*shmHeight)
+    {
+        warningMessage(std::string("Frames of ") + std::to_string(frWidth) + "x" + std::to_string(frHeight) +
+                       " do not fit the shared memory segment, not publishing images to shared memory.");
+        if(shmValid)
+            shm->statusByte = SHM_STATUS_WAITING;
+        shmValid = false;
+        return;
+    }
+    if(!mapped)
+    {
+        shmSetup();
+        return;
+    }
+    shm->frameHeight = this->frHeight;
+    shm->frameWidth = this->frWidth;
+    shm->statusByte = SHM_STATUS_WAITING;
+    shmValid = true;
+#else
+    statusMessage("Not initializing shared memory segment.");
+#endif
+}
+
 void take_object::start()
 {
     pdv_thread_run = 1;
+    startBegin = std::chrono::steady_clock::now();
+    firstFramePending = true;
 
     std::cout << "This version of cuda_take was compiled on " << __DATE__ << " at " << __TIME__ << " using gcc " << __GNUC__ << std::endl;
     std::cout << "The compilation was perfromed by " << UNAME << " @ " << HOST << std::endl;
 
     pthread_setname_np(pthread_self(), "TAKE");
+    threadCpuMap = os::parseThreadMap(options.threadCpus);
+    threadPriorityMap = os::parseThreadMap(options.threadPriorities);
+    policyThreadNames.clear();
+    applyThreadPolicy(pthread_self(), "TAKE");
+
+    if(!openSource())
+        return;
+    std::chrono::steady_clock::time_point sourcetp = std::chrono::steady_clock::now();
+
+#ifdef VERBOSE
+    std::cout << "Camera Type: " << cam_type << ". Frame Width: " << frWidth << \
+                 " Data Height: " << dataHeight << " Frame Height: " << frHeight << std::endl;
+    std::cout << "About to start threads..." << std::endl;
+#endif
+
+    allocateFrameMemory();
+    std::chrono::steady_clock::time_point memorytp = std::chrono::steady_clock::now();
 
+    // Frame counter continuity, from the line header of each frame:
+    setupContinuity();
+
+    // Initialize the filters
+    dsf = new dark_subtraction_filter(frWidth,frHeight);
+    sdvf = new std_dev_filter(frWidth,frHeight);
+    applyStdDevThreadPolicy();
+    startFrameGraph();
+    applyProductPolicies();
+    std::chrono::steady_clock::time_point filterstp = std::chrono::steady_clock::now();
+
+    // The saving queue is allocated by the first startSavingRaws(), see prepareSavingQueue().
+    statusMessage(std::string("Raw conditioning instruction set: ") + fused_conditioner_isa());
+    reportMemoryUsage();
+
+    // Initial dimensions for calculating the mean that can be updated later
+    meanStartRow = 0;
+    meanStartCol = 0;
+    meanHeight = frHeight;
+    meanWidth = frWidth;
+
+    // Get the shared memory segment for images ready.
+    std::chrono::steady_clock::time_point shmBegintp = std::chrono::steady_clock::now();
+    updateShmGeometry();
+    std::chrono::steady_clock::time_point shmtp = std::chrono::steady_clock::now();
+
+    startAcquisition();
+    std::chrono::steady_clock::time_point camtp = std::chrono::steady_clock::now();
+
+    if(options.lockMemory)
+        lockFrameMemory();
+    reportThreadPolicy();
+
+    // Where the time before the first frame went. The frame ring is still
+    // being populated in the background, see allocateFrameMemory().
+    auto ms = [](std::chrono::steady_clock::time_point a, std::chrono::steady_clock::time_point b) {
+        return std::chrono::duration_cast<std::chrono::microseconds>(b - a).count() / 1000.0;
+    };
+    std::ostringstream info;
+    info.precision(1);
+    info << std::fixed;
+    info << "Started in " << ms(startBegin, std::chrono::steady_clock::now()) << " ms: "
+         << "source " << ms(startBegin, sourcetp) << " ms, "
+         << "frame memory " << ms(sourcetp, memorytp) << " ms, "
+         << "filters " << ms(memorytp, filterstp) << " ms, "
+         << "shared memory " << ms(shmBegintp, shmtp) << " ms, "
+         << "camera start " << ms(shmtp, camtp) << " ms.";
+    statusMessage(info);
+}
+
+bool take_object::openSource()
+{
+    // The geometry of the source in options, and for camera link, the open
+    // device. Returns false if the device could not be opened.
     this->pdv_p = NULL;
 
-    if(options.xioCam)
+    if(options.syntheticCam)
+    {
+        frWidth = options.syntheticWidth;
+        frHeight = options.syntheticHeight;
+        dataHeight = options.syntheticHeight;
+        size = frWidth * frHeight * sizeof(uint16_t);
+        statusMessage("start() running with synthetic camera settings.");
+    } else if(options.xioCam)
     {
         if(!options.heightWidthSet)
         {
@@ -280,10 +410,12 @@ void take_object::start()
             std::cout << "rtpInterface: " << options.rtpInterface << std::endl;
         }
     } else {
-        this->pdv_p = pdv_open_channel(EDT_INTERFACE,0,this->channel);
+        if(options.pdvChannel >= 0)
+            this->channel = options.pdvChannel;
+        this->pdv_p = pdv_open_channel(EDT_INTERFACE,options.pdvUnit,this->channel);
         if(pdv_p == NULL) {
-            std::cerr << "Could not open device channel. Is one connected?" << std::endl;
-            return;
+            std::cerr << "Could not open device unit " << options.pdvUnit << " channel " << this->channel << ". Is one connected?" << std::endl;
+            return false;
         }
         size = pdv_get_dmasize(pdv_p); // this size is only used to determine the camera type
         // actual grabbing of the dimensions
@@ -292,14 +424,18 @@ void take_object::start()
         frHeight = dataHeight;
     }
 
+    pixRemap = false;
     switch(size) {
     case 481*640*sizeof(uint16_t): cam_type = CL_6604A; break;
     case 285*640*sizeof(uint16_t): cam_type = CL_6604A; break;
     case 480*640*sizeof(uint16_t): cam_type = CL_6604B; pixRemap = true; break;
     default: cam_type = CL_6604B; pixRemap = true; break;
     }
-	setup_filter(cam_type);
-    setup_filter(frHeight, frWidth);
+    if(options.syntheticCam) {
+        pixRemap = false; // the patterns are made as they should be seen
+    }
+	chromaFilter.setup_filter(cam_type);
+    chromaFilter.setup_filter(frHeight, frWidth);
 	if(pixRemap) {
 		std::cout << "2s compliment filter ENABLED" << std::endl;
 	} else {
@@ -309,36 +445,39 @@ void take_object::start()
 
     //frHeight = cam_type == CL_6604A ? dataHeight - 1 : dataHeight;
     frHeight = dataHeight;
+    return true;
+}
 
-#ifdef VERBOSE
-    std::cout << "Camera Type: " << cam_type << ". Frame Width: " << frWidth << \
-                 " Data Height: " << dataHeight << " Frame Height: " << frHeight << std::endl;
-    std::cout << "About to start threads..." << std::endl;
-#endif
-
-    // Initialize the filters
-    dsf = new dark_subtraction_filter(frWidth,frHeight);
-    sdvf = new std_dev_filter(frWidth,frHeight);
-
-    // Initial dimensions for calculating the mean that can be updated later
-    meanStartRow = 0;
-    meanStartCol = 0;
-    meanHeight = frHeight;
-    meanWidth = frWidth;
-
-#ifdef USE_SHM
-    // Get the shared memory segment for images ready:
-    if(options.useSHM) {
-        shmSetup();
+void take_object::startAcquisition()
+{
+    // Makes the camera for the source in options and starts the camera loop
+    // and its helper threads. The ring, pools and filters must be ready.
+    numbufs = options.pdvMultibufs;
+    if((numbufs == 0) || (numbufs > MAX_PDV_MULTIBUFS))
+    {
+        warningMessage(std::string("Camera link multibuf count out of range, using ") + std::to_string(PDV_MULTIBUF_DEFAULT));
+        numbufs = PDV_MULTIBUF_DEFAULT;
     }
-#else
-    statusMessage("Not initializing shared memory segment.");
-#endif
+    int rtnval = 0;
+    if(options.syntheticCam)
+    {
+        statusMessage("Starting synthetic camera in take object.");
+        cam_thread_start_complete = false;
+        prepareSyntheticCamera();
 
+        rtpAcquireThread = boost::thread(&take_object::rtpNGStreamLoop, this);
+        rtpAcquireThreadHandler = rtpAcquireThread.native_handle();
+        pthread_setname_np(rtpAcquireThreadHandler, "SYNTH Stream");
+        applyThreadPolicy(rtpAcquireThreadHandler, "SYNTH Stream");
 
-    numbufs = 16;
-    int rtnval = 0;
-    if(options.xioCam)
+        // Consumed as RTP NextGen frames are:
+        rtpConsumerRun = true;
+        rtpCopyThread = boost::thread(&take_object::rtpConsumeFrames, this);
+        rtpCopyThreadHandler = rtpCopyThread.native_handle();
+        pthread_setname_np(rtpCopyThreadHandler, "SYNTH Consume");
+        applyThreadPolicy(rtpCopyThreadHandler, "SYNTH Consume");
+        statusMessage("Created synthetic camera stream and consumer threads.");
+    } else if(options.xioCam)
     {
         cam_thread_start_complete = false;
         statusMessage("Creating an XIO camera take_object.");
@@ -347,6 +486,7 @@ void take_object::start()
         cam_thread = boost::thread(&take_object::fileImageCopyLoop, this);
         cam_thread_handler = cam_thread.native_handle();
         pthread_setname_np(cam_thread_handler, "XIOCAM");
+        applyThreadPolicy(cam_thread_handler, "XIOCAM");
         statusMessage("Created thread.");
         while(!cam_thread_start_complete)
             usleep(100);
@@ -356,6 +496,7 @@ void take_object::start()
         reading_thread = boost::thread(&take_object::fileImageReadingLoop, this);
         reading_thread_handler = reading_thread.native_handle();
         pthread_setname_np(reading_thread_handler, "READING");
+        applyThreadPolicy(reading_thread_handler, "READING");
         statusMessage("Done creating XIO File reading thread reading_thread.");
 
         char threadinfo[16];
@@ -391,6 +532,7 @@ void take_object::start()
         rtpAcquireThread = boost::thread(&take_object::rtpNGStreamLoop, this);
         rtpAcquireThreadHandler = rtpAcquireThread.native_handle();
         pthread_setname_np(rtpAcquireThreadHandler, "RTPNG Stream");
+        applyThreadPolicy(rtpAcquireThreadHandler, "RTPNG Stream");
         statusMessage("Created RTP NextGen streamLoop() thread.");
 
         // At this point, the RTP camera is initialized and now it is running.
@@ -403,6 +545,7 @@ void take_object::start()
         rtpCopyThread = boost::thread(&take_object::rtpConsumeFrames, this);
         rtpCopyThreadHandler = rtpCopyThread.native_handle();
         pthread_setname_np(rtpCopyThreadHandler, "RTPNG Consume");
+        applyThreadPolicy(rtpCopyThreadHandler, "RTPNG Consume");
         statusMessage("Created RTP NextGen consumer thread.");
 
     } else if (options.rtpCam) {
@@ -415,6 +558,7 @@ void take_object::start()
         rtpAcquireThread = boost::thread(&take_object::rtpStreamLoop, this);
         rtpAcquireThreadHandler = rtpAcquireThread.native_handle();
         pthread_setname_np(rtpAcquireThreadHandler, "RTP Stream");
+        applyThreadPolicy(rtpAcquireThreadHandler, "RTP Stream");
         statusMessage("Created RTP streamLoop() thread.");
         // At this point, the RTP camera is initialized and now it is running.
         // Data is being acquired if the stream source is emitting data,
@@ -425,10 +569,11 @@ void take_object::start()
         rtpCopyThread = boost::thread(&take_object::rtpConsumeFrames, this);
         rtpCopyThreadHandler = rtpCopyThread.native_handle();
         pthread_setname_np(rtpCopyThreadHandler, "RTP Consume");
+        applyThreadPolicy(rtpCopyThreadHandler, "RTP Consume");
         statusMessage("Created RTP consumer thread.");
 
     } else {
-        statusMessage("Creating CameraLink multibuf.");
+        statusMessage(std::string("Creating CameraLink multibuf with ") + std::to_string(numbufs) + " buffers.");
         if(pdv_p != NULL)
             rtnval = pdv_multibuf(pdv_p,this->numbufs);
         if(rtnval != 0)
@@ -444,11 +589,511 @@ void take_object::start()
         cam_thread = boost::thread(&take_object::pdv_loop, this);
         cam_thread_handler = cam_thread.native_handle();
         pthread_setname_np(cam_thread_handler, "PDVCAM");
+        applyThreadPolicy(cam_thread_handler, "PDVCAM");
         //usleep(350000);
         while(!cam_thread_start_complete) usleep(1); // Added by Michael Bernas 2016. Used to prevent thread error when starting without a camera
     }
     statusMessage("Finished creating threads.");
 }
+
+bool take_object::reconfigure(takeOptionsType newOptions)
+{
+    /*! \brief Switch to the source and geometry of newOptions, e.g. from XIO replay to RTP, without a restart.
+     * \return false if nothing was changed, because a recording is in progress or readers held on to their frames,
+     * or if the new source could not be opened, which leaves acquisition stopped.
+     * \paragraph
+     *
+     * The camera loop is stopped, the frame graph finishes the frames already acquired, and the camera is deleted.
+     * The frame ring, the product pools, the save queue and the shared memory segment are kept when they are large
+     * enough for the new geometry, and the filters and the dark mask when the geometry is unchanged, so that only
+     * what no longer fits is allocated again. The new source is then opened and started as by start().
+     * \paragraph
+     *
+     * Readers must release the frames they hold from acquireLatest(), which returns NULL while the switch is in
+     * progress, and until the new source delivers its first frame. The time taken is reported, and warned about
+     * beyond RECONFIGURE_TARGET_MS, see getLastSwitchMicros().
+     */
+    std::lock_guard<std::mutex> lock(reconfigureMutex);
+    if(!frameGraphStarted)
+    {
+        warningMessage("Cannot reconfigure before start() has completed.");
+        return false;
+    }
+    // startSavingRaws() holds reconfigureMutex too, so a recording is either
+    // not started yet or is seen here.
+    if(isSaving())
+    {
+        warningMessage("Cannot reconfigure while recording, stop recording first.");
+        return false;
+    }
+
+    std::chrono::steady_clock::time_point begintp = std::chrono::steady_clock::now();
+    startBegin = begintp;
+    reconfiguring = true;
+    if(!waitForReaders(RECONFIGURE_READER_TIMEOUT_MS))
+    {
+        reconfiguring = false;
+        warningMessage("Frames are still leased by a reader, not reconfiguring.");
+        return false;
+    }
+    unsigned int priorWidth = frWidth;
+    unsigned int priorHeight = dataHeight;
+    statusMessage(std::string("Reconfiguring, stopping the ") + frame_source_name(frameSource()) + " source.");
+    stopAcquisition();
+
+    changeOptions(newOptions);
+    if(!openSource())
+    {
+        reconfiguring = false;
+        errorMessage("Could not open the new source, acquisition is stopped.");
+        return false;
+    }
+    bool geometryChanged = (frWidth != priorWidth) || (dataHeight != priorHeight);
+
+    allocateFrameMemory();
+    setupContinuity();
+    if(geometryChanged)
+    {
+        // The filters are sized for one geometry, and so is the dark mask.
+        delete dsf;
+        delete sdvf;
+        dsf = new dark_subtraction_filter(frWidth,frHeight);
+        sdvf = new std_dev_filter(frWidth,frHeight);
+        applyStdDevThreadPolicy();
+        dsfMaskCollected = false;
+        useDSF = false;
+        meanStartRow = 0;
+        meanStartCol = 0;
+        meanHeight = frHeight;
+        meanWidth = frWidth;
+    }
+    setProductLimit();
+    applyProductPolicies();
+    // Kept if it is large enough for the new geometry, otherwise released
+    // until the next recording asks for it.
+    if(!saving_queue.reuse(frWidth*dataHeight, SAVE_QUEUE_DEPTH))
+        saving_queue.deallocate();
+    updateShmGeometry();
+
+    pdv_thread_run = 1;
+    firstFramePending = true;
+    startAcquisition();
+    reconfiguring = false;
+    if(options.lockMemory)
+        lockFrameMemory();
+    if(options.xioCam && options.xioDirSet && (options.xioDirectory != NULL))
+        setReadDirectory(options.xioDirectory->c_str());
+
+    uint64_t micros = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - begintp).count();
+    lastSwitchMicros = micros;
+    std::ostringstream info;
+    info.precision(1);
+    info << std::fixed;
+    info << "Switched to the " << frame_source_name(frameSource()) << " source with " << frWidth << "x" << dataHeight
+         << " frames in " << micros/1000.0 << " ms, " << (geometryChanged ? "new" : "same") << " geometry.";
+    statusMessage(info);
+    if(micros > RECONFIGURE_TARGET_MS*1000ULL)
+        warningMessage(std::string("Switching sources took longer than ") + std::to_string(RECONFIGURE_TARGET_MS) + " ms.");
+    return true;
+}
+
+uint64_t take_object::getLastSwitchMicros()
+{
+    /*! \brief Duration of the last successful reconfigure(), or 0 if there has been none. */
+    return lastSwitchMicros.load(std::memory_order_relaxed);
+}
+
+uint64_t take_object::getFirstFrameMicros()
+{
+    /*! \brief Time from start(), or the last reconfigure(), to the end of processing its first frame.
+     * 0 until that frame has been processed. */
+    return firstFrameMicros.load(std::memory_order_relaxed);
+}
+
+void take_object::reportFirstFrame()
+{
+    // Called by the camera loop for the first frame after start() or
+    // reconfigure(). startBegin was set before the loop was started.
+    firstFramePending = false;
+    uint64_t micros = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - startBegin).count();
+    firstFrameMicros = micros;
+    std::ostringstream info;
+    info.precision(1);
+    info << std::fixed;
+    info << "First frame processed " << micros/1000.0 << " ms after start, with "
+         << ringReady.load(std::memory_order_relaxed) << " of " << ringDepth << " ring frames populated.";
+    statusMessage(info);
+}
+
+bool take_object::waitForReaders(unsigned int timeout_ms)
+{
+    // Wait until no reader holds a frame of the ring. The frame graph's own
+    // leases are short, so they are waited out here as well.
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() +
+            std::chrono::milliseconds(timeout_ms);
+    while(true)
+    {
+        bool leased = false;
+        for(unsigned int f = 0; (f < ringDepth) && !leased; f++)
+            leased = frame_ring_buffer[f].leases.load(std::memory_order_acquire) > 0;
+        if(!leased)
+            return true;
+        if(std::chrono::steady_clock::now() > deadline)
+            return false;
+        usleep(1000);
+    }
+}
+
+void take_object::stopAcquisition()
+{
+    // Stops the camera loop and the threads feeding it, lets the frame graph
+    // finish what they acquired, then closes the device or deletes the camera.
+    closing = true;
+    pdv_thread_run = 0;
+    fileReadingLoopRun = false;
+    rtpConsumerRun = false;
+    cameraController.exit = true;
+    if(Camera != NULL)
+        Camera->stop();
+
+    if(cam_thread.joinable())
+        cam_thread.join();
+    if(reading_thread.joinable())
+        reading_thread.join();
+    if(rtpCopyThread.joinable())
+        rtpCopyThread.join();
+    if(rtpAcquireThread.joinable())
+        rtpAcquireThread.join();
+    // Any loop which stopped between claiming a slot and conditioning it has
+    // ended the claim itself; this catches one that did not.
+    endFrameClaim();
+    waitFrameGraphIdle();
+
+    std::shared_ptr<mean_filter> stoppedFilter;
+    {
+        // A reader still holding the filter deletes it when done.
+        std::lock_guard<std::mutex> lock(loopMeanFilterLock);
+        stoppedFilter.swap(loopMeanFilter);
+        if(stoppedFilter)
+            lastMeanSeries = stoppedFilter->seriesSummary();
+    }
+    if(stoppedFilter)
+    {
+        statusMessage(std::string("Frame mean series: ") + std::to_string(lastMeanSeries.frames) + " frames, " +
+                      std::to_string(lastMeanSeries.profiled) + " with profiles, " +
+                      std::to_string(lastMeanSeries.meanOnly) + " mean only, " +
+                      std::to_string(lastMeanSeries.holes) + " holes filled, " +
+                      std::to_string(productSkips.load(std::memory_order_relaxed)) + " product skips.");
+    }
+    stoppedFilter.reset();
+    if(pdv_p != NULL)
+    {
+        int dummy;
+        pdv_wait_last_image(pdv_p,&dummy);
+        pdv_close(pdv_p);
+        pdv_p = NULL;
+    }
+    delete Camera;
+    Camera = NULL;
+
+    cameraController.exit = false;
+    closing = false;
+    grabbing = false;
+    cam_thread_start_complete = false;
+}
+
+const char *take_object::acquisitionThreadName()
+{
+    // The thread which fills the frame ring, by its pthread name.
+    if(options.syntheticCam)
+        return "SYNTH Consume";
+    if(options.xioCam)
+        return "XIOCAM";
+    if(options.rtpCam && options.rtpNextGen)
+        return "RTPNG Consume";
+    if(options.rtpCam)
+        return "RTP Consume";
+    return "PDVCAM";
+}
+
+void take_object::setFrameMemoryPolicy()
+{
+    // Huge pages and NUMA placement for every frame region, see frame_memory.hpp.
+    // Without an explicit node, the regions follow the acquisition thread if it
+    // has been pinned with --thread-cpus.
+    frame_memory::page_size_t pages = frame_memory::PAGES_NORMAL;
+    if(options.hugePageSize == 2)
+        pages = frame_memory::PAGES_2M;
+    else if(options.hugePageSize == 1024)
+        pages = frame_memory::PAGES_1G;
+    else if(options.hugePageSize != 0)
+        warningMessage(std::string("Huge page size of ") + std::to_string(options.hugePageSize) +
+                       " MiB not supported, using normal pages.");
+
+    int node = options.numaNode;
+    std::map<std::string, std::string>::const_iterator it = threadCpuMap.find(acquisitionThreadName());
+    if((node < 0) && (it != threadCpuMap.end()))
+    {
+        std::vector<int> cpus;
+        if(os::parseCpuList(it->second, cpus) && !cpus.empty())
+            node = os::cpuNumaNode(cpus[0]);
+    }
+    frame_memory::setPolicy(pages, node);
+}
+
+void take_object::allocateFrameMemory()
+{
+    // Every frame in the ring is sized for this geometry, and holds only its raw
+    // data, a slot of rawPool. The derived products are kept in much smaller
+    // pools, see frame_pool.hpp. When called again by reconfigure(), pools
+    // whose slots are large enough for the new geometry are kept.
+    //
+    // Faulting in a deep ring takes seconds, so only its first RING_EAGER_FRAMES
+    // slots are populated here. ringFillLoop() does the rest in the background,
+    // and claimNextFrame() cycles through the slots which are ready so far.
+    stopRingFill();
+    endFrameClaim(); // a slot the last camera loop stopped in, before the ring may be replaced
+    unsigned int priorDepth = (frame_ring_buffer != NULL) ? ringDepth : 0;
+    ringDepth = options.frameRingDepth;
+    if(ringDepth < MIN_FRAME_RING_DEPTH)
+    {
+        warningMessage(std::string("Frame ring depth too small, using ") + std::to_string(MIN_FRAME_RING_DEPTH));
+        ringDepth = MIN_FRAME_RING_DEPTH;
+    }
+    unsigned int poolDepth = options.productPoolDepth;
+    if((poolDepth == 0) || (poolDepth > ringDepth))
+    {
+        poolDepth = (PRODUCT_POOL_DEPTH_DEFAULT < ringDepth) ? PRODUCT_POOL_DEPTH_DEFAULT : ringDepth;
+        warningMessage(std::string("Product pool depth out of range, using ") + std::to_string(poolDepth));
+    }
+
+    setFrameMemoryPolicy();
+    if(priorDepth != ringDepth)
+    {
+        delete[] frame_ring_buffer;
+        frame_ring_buffer = new frame_c[ringDepth];
+        delete[] sequenceSlot;
+        sequenceSlot = new std::atomic<unsigned int>[ringDepth];
+    }
+    for(unsigned int f = 0; f < ringDepth; f++)
+    {
+        sequenceSlot[f] = 0;
+        frame_ring_buffer[f].sequence = 0;
+        frame_ring_buffer[f].detach_products();
+    }
+    ringCursor = 0;
+#ifdef USE_PINNED_MEMORY
+    frame_pool::memory_t rawKind = frame_pool::PINNED_MEMORY;
+#else
+    frame_pool::memory_t rawKind = frame_pool::HOST_MEMORY;
+#endif
+    size_t rawBytes = (size_t)frWidth * dataHeight * sizeof(uint16_t);
+    bool rawReused = rawPool.reuse(rawBytes, ringDepth, rawKind);
+    if(!rawReused)
+    {
+        if(!rawPool.allocate(rawBytes, ringDepth, rawKind, true))
+        {
+            errorMessage("Could not allocate the frame ring buffer.");
+            abort();
+        }
+        ringPopulated = 0;
+    }
+    unsigned int eager = (RING_EAGER_FRAMES < ringDepth) ? RING_EAGER_FRAMES : ringDepth;
+    if(ringPopulated < eager)
+    {
+        rawPool.populate(ringPopulated, eager - ringPopulated);
+        ringPopulated = eager;
+    }
+    ringReady.store(ringPopulated, std::memory_order_release);
+    for(unsigned int f = 0; f < ringDepth; f++)
+        frame_ring_buffer[f].attach_raw(rawPool.slot(f), frWidth, dataHeight);
+    size_t darkBytes = frame_c::dark_bytes(frWidth, dataHeight);
+    size_t meanBytes = frame_c::mean_products_bytes(frWidth, dataHeight);
+    if((!darkPool.reuse(darkBytes, poolDepth, frame_pool::HOST_MEMORY) &&
+        !darkPool.allocate(darkBytes, poolDepth, frame_pool::HOST_MEMORY)) ||
+       (!meanPool.reuse(meanBytes, poolDepth, frame_pool::HOST_MEMORY) &&
+        !meanPool.allocate(meanBytes, poolDepth, frame_pool::HOST_MEMORY)))
+    {
+        errorMessage("Could not allocate the frame product pools.");
+        abort();
+    }
+    if(rawReused)
+        statusMessage(std::string("Reusing the frame ring of ") + std::to_string(ringDepth) + " frames for " +
+                      std::to_string(frWidth) + "x" + std::to_string(dataHeight) + " frames.");
+    curFrame = &frame_ring_buffer[0];
+
+    if(ringPopulated < ringDepth)
+    {
+        ringFillRun = true;
+        ringFillThread = boost::thread(&take_object::ringFillLoop, this);
+        pthread_setname_np(ringFillThread.native_handle(), "RINGFILL");
+        applyThreadPolicy(ringFillThread.native_handle(), "RINGFILL");
+    } else if(!rawReused && !rawPool.complete()) {
+        warningMessage("Could not pin the frame ring, device copies from it will be slower.");
+    }
+}
+
+void take_object::ringFillLoop()
+{
+    // Populates the rest of the ring a chunk at a time, handing each chunk to
+    // claimNextFrame() as soon as it is in, and pins the ring at the end.
+    std::chrono::steady_clock::time_point begintp = std::chrono::steady_clock::now();
+    unsigned int first = ringPopulated;
+    while((ringPopulated < ringDepth) && ringFillRun.load(std::memory_order_relaxed))
+    {
+        unsigned int n = ringDepth - ringPopulated;
+        if(n > RING_FILL_CHUNK_FRAMES)
+            n = RING_FILL_CHUNK_FRAMES;
+        rawPool.populate(ringPopulated, n);
+        ringPopulated += n;
+        ringReady.store(ringPopulated, std::memory_order_release);
+    }
+    if(ringPopulated < ringDepth)
+        return; // stopped, allocateFrameMemory() carries on from here
+
+    if(!rawPool.complete())
+        warningMessage("Could not pin the frame ring, device copies from it will be slower.");
+    std::ostringstream info;
+    info.precision(1);
+    info << std::fixed;
+    info << "Frame ring of " << ringDepth << " frames ready, " << ringDepth - first << " populated in the background in "
+         << std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begintp).count()/1000.0
+         << " ms.";
+    statusMessage(info);
+}
+
+void take_object::stopRingFill()
+{
+    // Before the ring is reallocated or deleted. ringPopulated is left at the
+    // last complete chunk.
+    ringFillRun = false;
+    if(ringFillThread.joinable())
+        ringFillThread.join();
+}
+
+void take_object::reportMemoryUsage()
+{
+    // Startup report of the memory held for frames, once the filters
+    // exist. The save queue is 0 MiB until the first recording.
+    const double MiB = 1024.0*1024.0;
+    size_t rawBytes = rawPool.bytes();
+    size_t stdDevBytes = (sdvf != NULL) ? sdvf->resultPoolBytes() : 0;
+    size_t total = rawBytes + darkPool.bytes() + meanPool.bytes() + stdDevBytes + saving_queue.storageBytes();
+    std::ostringstream info;
+    info.precision(1);
+    info << std::fixed;
+    info << "Frame memory for " << frWidth << "x" << dataHeight << " frames: "
+         << "raw ring " << ringDepth << " frames " << rawBytes/MiB << " MiB (" << ringReady.load() << " populated), "
+         << "dark pool " << darkPool.depth() << " slots " << darkPool.bytes()/MiB << " MiB, "
+         << "mean pool " << meanPool.depth() << " slots " << meanPool.bytes()/MiB << " MiB, "
+         << "std. dev. pool " << stdDevBytes/MiB << " MiB, "
+         << "save queue " << saving_queue.storageBytes()/MiB << " MiB, "
+         << "total " << total/MiB << " MiB.";
+    statusMessage(info);
+    statusMessage(frame_memory::describe());
+
+    size_t rss = os::residentSetBytes();
+    if(rss != 0)
+    {
+        info.str("");
+        info << "Resident set size: " << rss/MiB << " MiB.";
+        statusMessage(info);
+    }
+}
+
+void take_object::applyThreadPolicy(pthread_t thread, const char *name)
+{
+    // Pins the named thread to its configured CPUs and sets its SCHED_FIFO
+    // priority, if either was requested. Failures are warnings, the thread
+    // simply keeps running with the default policy.
+    std::string error;
+    std::map<std::string, std::string>::const_iterator it = threadCpuMap.find(name);
+    if(it != threadCpuMap.end())
+    {
+        std::vector<int> cpus;
+        if(!os::parseCpuList(it->second, cpus))
+        {
+            warningMessage(std::string("Could not parse CPU list \"") + it->second + "\" for thread " + name);
+        } else if(!os::setThreadAffinity(thread, cpus, error)) {
+            warningMessage(std::string("Could not pin thread ") + name + " to CPUs " + it->second + ": " + error);
+        }
+    }
+
+    it = threadPriorityMap.find(name);
+    if(it != threadPriorityMap.end())
+    {
+        int priority = atoi(it->second.c_str());
+        if(!os::setThreadRealtime(thread, priority, error))
+            warningMessage(std::string("Could not set SCHED_FIFO priority for thread ") + name + ": " + error);
+    }
+
+    policyThreadNames.insert(name);
+    statusMessage(std::string("Thread ") + name + ": " + os::describeThreadPolicy(thread));
+}
+
+void take_object::applyStdDevThreadPolicy()
+{
+    // The CPU std. dev. filter calculates on a thread of its own, started
+    // with each filter.
+    pthread_t thread;
+    if(sdvf->workerThread(thread))
+        applyThreadPolicy(thread, "STDDEV");
+}
+
+void take_object::reportThreadPolicy()
+{
+    // Mention any configured thread which was not started, most likely a
+    // typo or a thread belonging to a different camera type.
+    std::map<std::string, std::string>::const_iterator it;
+    for(it = threadCpuMap.begin(); it != threadCpuMap.end(); ++it)
+    {
+        if(!policyThreadNames.count(it->first) && (it->first != "SAVING"))
+            warningMessage(std::string("CPU list given for unknown thread ") + it->first);
+    }
+    for(it = threadPriorityMap.begin(); it != threadPriorityMap.end(); ++it)
+    {
+        if(!policyThreadNames.count(it->first) && (it->first != "SAVING"))
+            warningMessage(std::string("Priority given for unknown thread ") + it->first);
+    }
+}
+
+void take_object::lockFrameMemory()
+{
+    // The standard deviation pool, and the raw pool in pinned builds, are
+    // already page-locked by cudaHostRegister. This locks the rest of the
+    // ring, the dark and mean product pools and the save queue slots, so that
+    // a page fault cannot stall the acquisition or saving threads.
+    std::string error;
+    size_t ringBytes = sizeof(frame_c) * ringDepth + darkPool.bytes() + meanPool.bytes();
+#ifndef USE_PINNED_MEMORY
+    ringBytes += rawPool.bytes();
+    if(!os::lockMemory(rawPool.base(), rawPool.bytes(), error))
+        warningMessage(std::string("Could not lock raw frame memory: ") + error);
+#endif
+    bool locked = os::lockMemory(frame_ring_buffer, sizeof(frame_c) * ringDepth, error) &&
+            os::lockMemory(darkPool.base(), darkPool.bytes(), error) &&
+            os::lockMemory(meanPool.base(), meanPool.bytes(), error);
+    if(locked)
+    {
+        statusMessage(std::string("Locked ") + std::to_string(ringBytes/(1024*1024)) + " MiB of frame ring memory.");
+    } else {
+        warningMessage(std::string("Could not lock frame ring memory: ") + error);
+    }
+
+    if(saving_queue.storage() != NULL)
+    {
+        size_t queueBytes = saving_queue.storageBytes();
+        if(os::lockMemory(saving_queue.storage(), queueBytes, error))
+        {
+            statusMessage(std::string("Locked ") + std::to_string(queueBytes/(1024*1024)) + " MiB of save queue memory.");
+        } else {
+            warningMessage(std::string("Could not lock save queue memory: ") + error);
+        }
+    }
+}
+
 void take_object::setInversion(bool checked, unsigned int factor)
 {
     inverted = checked;
@@ -668,26 +1313,67 @@ void take_object::changeFFTtype(FFT_t t)
 {
     whichFFT = t;
 }
-void take_object::startSavingRaws(std::string raw_file_name, unsigned int frames_to_save, unsigned int num_avgs_save)
+bool take_object::prepareSavingQueue()
 {
-    if(frames_to_save==0)
+    // The saving queue is only allocated once something is recorded, as at
+    // SAVE_QUEUE_DEPTH frames it is the largest block of frame memory. Later
+    // recordings reuse it, emptied. Only while nothing is pushing or popping.
+    if(saving_queue.reuse(frWidth*dataHeight, SAVE_QUEUE_DEPTH))
+        return true;
+    std::chrono::steady_clock::time_point begintp = std::chrono::steady_clock::now();
+    if(!saving_queue.allocate(frWidth*dataHeight, SAVE_QUEUE_DEPTH))
+        return false;
+    std::ostringstream info;
+    info.precision(1);
+    info << std::fixed;
+    info << "Allocated the save queue, " << SAVE_QUEUE_DEPTH << " frames "
+         << saving_queue.storageBytes()/(1024.0*1024.0) << " MiB, in "
+         << std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begintp).count() / 1000.0
+         << " ms.";
+    statusMessage(info);
+    if(options.lockMemory)
     {
-        continuousRecording = true;
-    } else {
-        continuousRecording = false;
+        std::string error;
+        if(os::lockMemory(saving_queue.storage(), saving_queue.storageBytes(), error))
+        {
+            statusMessage(std::string("Locked ") + std::to_string(saving_queue.storageBytes()/(1024*1024)) + " MiB of save queue memory.");
+        } else {
+            warningMessage(std::string("Could not lock save queue memory: ") + error);
+        }
     }
-    
+    return true;
+}
+void take_object::startSavingRaws(std::string raw_file_name, unsigned int frames_to_save, unsigned int num_avgs_save)
+{
+    // Not while reconfigure() is replacing the source and the save queue.
+    std::lock_guard<std::mutex> lock(reconfigureMutex);
+    // The producer stops queueing before the queue is touched below.
+    continuousRecording = false;
     save_framenum.store(0, std::memory_order_seq_cst);
     save_count.store(0, std::memory_order_seq_cst);
 #ifdef VERBOSE
     printf("ssr called\n");
 #endif
-    while(!saving_list.empty())
+    while(savingData)
     {
 #ifdef VERBOSE
-        printf("Waiting for empty saving list...\n");
+        printf("Waiting for prior save to finish...\n");
 #endif
+        usleep(250);
+    }
+    // A saving loop started just before may not have set savingData yet.
+    if(saving_thread.joinable())
+        saving_thread.join();
+    // Neither the producer nor a consumer is inside the queue now, so it
+    // may be allocated, or emptied of anything left over.
+    while(producerQueueing.load(std::memory_order_seq_cst))
+        usleep(50);
+    if(!prepareSavingQueue())
+    {
+        errorMessage("Could not allocate the frame saving queue, not recording.");
+        return;
     }
+    continuousRecording = (frames_to_save == 0);
     save_framenum.store(frames_to_save,std::memory_order_seq_cst);
     save_count.store(0, std::memory_order_seq_cst);
     save_num_avgs=num_avgs_save;
@@ -699,6 +1385,9 @@ void take_object::startSavingRaws(std::string raw_file_name, unsigned int frames
         shm->recordingDataToFile = true;
     }
     saving_thread = boost::thread(&take_object::savingLoop,this,raw_file_name,num_avgs_save,frames_to_save);
+    pthread_setname_np(saving_thread.native_handle(), "SAVING");
+    if(threadCpuMap.count("SAVING") || threadPriorityMap.count("SAVING"))
+        applyThreadPolicy(saving_thread.native_handle(), "SAVING");
 }
 void take_object::stopSavingRaws()
 {
@@ -706,6 +1395,7 @@ void take_object::stopSavingRaws()
     save_framenum.store(0,std::memory_order_relaxed);
     save_count.store(0,std::memory_order_relaxed);
     save_num_avgs=1;
+    saving_queue.wake();
     if(shmValid) {
         shm->recordingDataToFile = false;
     }
@@ -714,6 +1404,11 @@ void take_object::stopSavingRaws()
     printf("Stop Saving Raws!");
 #endif
 }
+bool take_object::isSaving()
+{
+    /*! \brief True from startSavingRaws() until the saving loop has finished, or while recording continuously. */
+    return savingData || continuousRecording || (save_framenum.load(std::memory_order_relaxed) > 0);
+}
 unsigned int take_object::getDataHeight()
 {
     return dataHeight;
@@ -738,19 +1433,95 @@ FFT_t take_object::getFFTtype()
 {
     return whichFFT;
 }
+unsigned int take_object::getSaveQueueDepth()
+{
+    return saving_queue.depth();
+}
+unsigned int take_object::getSaveQueueHighWater()
+{
+    return saving_queue.highWaterMark();
+}
+uint64_t take_object::getSaveQueueDropped()
+{
+    return saving_queue.droppedFrames();
+}
 
-// private functions
-
-void take_object::prepareFileReading()
+uint64_t take_object::waitForFrame(uint64_t lastSeq, unsigned int timeout_ms)
 {
-    // Makes an XIO file reading camera
+    /*! \brief Block until a frame newer than lastSeq is ready for display, or timeout_ms passes.
+     * \return The sequence number of the newest ready frame, equal to lastSeq on timeout.
+     * Use acquireLatest() to get at the frame itself. */
+    return frameNotifier.wait(lastSeq, timeout_ms);
+}
+uint64_t take_object::frameSequence()
+{
+    return frameNotifier.sequence();
+}
+int take_object::getFrameEventFd()
+{
+    /*! \brief An eventfd which becomes readable whenever waitForFrame would return, for use with QSocketNotifier. */
+    return frameNotifier.eventFd();
+}
 
-    if(Camera == NULL)
+frame_c *take_object::acquireLatest()
+{
+    /*! \brief Lease the most recent frame announced by waitForFrame.
+     * \return The frame, which must be handed back with release(), or NULL if no frame has been announced yet.
+     *
+     * The camera loops skip leased slots, and the filters the pool slots of its products, so the frame's raw data and
+     * products stay put until it is released. Should the announced frame be overwritten between looking it up and
+     * leasing it, the newer announcement is tried instead.
+     */
+    if((frame_ring_buffer == NULL) || (sequenceSlot == NULL) || reconfiguring.load(std::memory_order_acquire))
+        return NULL;
+    for(int attempt = 0; attempt < 4; attempt++)
     {
-        Camera = new XIOCamera(frWidth,
-                               frHeight,
-                               frHeight);
-        this->Camera->setCamControlPtr(&this->cameraController);
+        uint64_t seq = frameNotifier.sequence();
+        if(seq == 0)
+            return NULL;
+        frame_c *frame = &frame_ring_buffer[sequenceSlot[seq % ringDepth].load(std::memory_order_acquire)];
+        if(frame->lease())
+        {
+            if(frame->sequence.load(std::memory_order_relaxed) == seq)
+            {
+                lastDemand.store(std::chrono::steady_clock::now(), std::memory_order_relaxed);
+                return frame;
+            }
+            frame->unlease();
+        }
+    }
+    return NULL;
+}
+
+void take_object::release(frame_c *frame)
+{
+    /*! \brief Hand back a lease from acquireLatest(), or one added with frame_c::lease(). NULL is ignored. */
+    if(frame != NULL)
+        frame->unlease();
+}
+
+uint64_t take_object::getLeaseSkips()
+{
+    return leaseSkips.load(std::memory_order_relaxed);
+}
+
+uint64_t take_object::getLeaseOverruns()
+{
+    return leaseOverruns.load(std::memory_order_relaxed);
+}
+
+// private functions
+
+void take_object::prepareFileReading()
+{
+    // Makes an XIO file reading camera
+
+    if(Camera == NULL)
+    {
+        Camera = new XIOCamera(frWidth,
+                               frHeight,
+                               frHeight);
+        this->Camera->setCamControlPtr(&this->cameraController);
         if(Camera == NULL)
         {
             errorMessage("XIO Camera could not be created, was NULL.");
@@ -808,6 +1579,17 @@ void take_object::prepareRTPNGCamera() {
     }
 }
 
+void take_object::prepareSyntheticCamera()
+{
+    if(Camera == NULL) {
+        Camera = new SyntheticCamera(options);
+        this->Camera->setCamControlPtr(&this->cameraController);
+        statusMessage("Synthetic camera created.");
+    } else {
+        errorMessage("Synthetic camera was expected to be NULL but was not!");
+    }
+}
+
 void take_object::fileImageReadingLoop()
 {
     // This thread makes the camera keep reading files
@@ -919,6 +1701,53 @@ bool take_object::checkFrame(uint16_t* Frame)
     return ok;
 }
 
+frame_c *take_object::claimNextFrame()
+{
+    // The next ring slot for the camera loop to fill with frame count+1.
+    // Slots leased by readers are skipped. If every slot is leased, the next
+    // one is overwritten anyway rather than stalling the camera, and counted.
+    // Only the first ringReady slots are used while the ring is still being
+    // populated, see allocateFrameMemory().
+    endFrameClaim();
+    unsigned int ready = ringReady.load(std::memory_order_acquire);
+    if(ringCursor >= ready)
+        ringCursor = 0;
+    unsigned int slot = ringCursor;
+    bool claimed = false;
+    for(unsigned int n = 0; n < ready; n++)
+    {
+        slot = (ringCursor + n) % ready;
+        if(frame_ring_buffer[slot].claim())
+        {
+            claimed = true;
+            break;
+        }
+        leaseSkips.fetch_add(1, std::memory_order_relaxed);
+    }
+    if(!claimed)
+    {
+        slot = ringCursor;
+        if(leaseOverruns.fetch_add(1, std::memory_order_relaxed) == 0)
+            warningMessage("Every frame in the ring is leased, overwriting a leased frame.");
+    }
+    ringCursor = (slot + 1) % ready;
+    curFrameClaimed = claimed;
+
+    frame_c *frame = &frame_ring_buffer[slot];
+    frame->reset();
+    frame->sequence.store(count + 1, std::memory_order_relaxed);
+    sequenceSlot[(count + 1) % ringDepth].store(slot, std::memory_order_release);
+    return frame;
+}
+
+void take_object::endFrameClaim()
+{
+    // Once the frame is conditioned, readers may lease it.
+    if(curFrameClaimed)
+        curFrame->end_claim();
+    curFrameClaimed = false;
+}
+
 void take_object::clearAllRingBuffer()
 {
     frame_c *curFrame = NULL;
@@ -930,11 +1759,14 @@ void take_object::clearAllRingBuffer()
         abort();
     }
 
-    for(size_t f=0; f < CPU_FRAME_BUFFER_SIZE; f++)
+    for(size_t f=0; f < ringDepth; f++)
     {
         curFrame = &frame_ring_buffer[f];
+        if(!curFrame->claim())
+            continue; // leased, left for its reader
         curFrame->reset();
         memcpy(curFrame->raw_data_ptr,zeroFrame,frWidth*dataHeight*2);
+        curFrame->end_claim();
     }
     statusMessage("Done zero-setting memory in frame_ring_buffer");
 }
@@ -971,17 +1803,13 @@ void take_object::fileImageCopyLoop()
     (void)hasBeenNull;
     if(Camera)
     {
-        count = 0;
-        uint16_t framecount = 1;
-        uint16_t last_framecount = 0;
-        (void)last_framecount; // use count
-
         mean_filter * mf = new mean_filter(curFrame,count,meanStartCol,meanWidth,\
                                            meanStartRow,meanHeight,frWidth,useDSF,\
                                            whichFFT, lh_start, lh_end,\
                                            cent_start, cent_end,\
                                            rh_start, rh_end);
-        setup_filter(frHeight, frWidth);
+        setupMeanFilter(mf);
+        chromaFilter.setup_filter(frHeight, frWidth);
 
         if(options.targetFPS == 0.0)
             options.targetFPS = 100.0;
@@ -1005,11 +1833,11 @@ void take_object::fileImageCopyLoop()
             begintp = std::chrono::steady_clock::now();
 
             grabbing = true;
-            curFrame = &frame_ring_buffer[count % CPU_FRAME_BUFFER_SIZE];
-            curFrame->reset();
+            curFrame = claimNextFrame();
 
             if(closing)
             {
+                endFrameClaim();
                 fileReadingLoopRun = false;
                 break;
             } else {
@@ -1018,7 +1846,9 @@ void take_object::fileImageCopyLoop()
             }
             cam_thread_start_complete=true;
 
+            std::chrono::steady_clock::time_point waittp = std::chrono::steady_clock::now();
             uint16_t* temp_frame = Camera->getFrame(&this->camStatus);
+            stageLatency[LATENCY_CAMERA_WAIT].record(waittp, std::chrono::steady_clock::now());
 
             if(camStatus==CameraModel::camPlaying)
             {
@@ -1057,70 +1887,19 @@ void take_object::fileImageCopyLoop()
 
             prior_temp_frame = temp_frame; // store the old address for comparison
 
-            if(temp_frame)
+            if(temp_frame == NULL)
             {
-                memcpy(curFrame->raw_data_ptr,temp_frame,frWidth*dataHeight*2);
-            } else {
                 hasBeenNull = true;
                 errorMessage("Frame was NULL!");
-                memcpy(curFrame->raw_data_ptr,zeroFrame,frWidth*dataHeight*2);
-            }
-
-            // From here on out, the code should be
-            // very similar to the EDT frame grabber code.
-
-
-            if(pixRemap)
-            {
-                apply_chroma_translate_filter(curFrame->raw_data_ptr);
-                curFrame->image_data_ptr = curFrame->raw_data_ptr;
-            }
-
-//            if(cam_type == CL_6604A)
-//                curFrame->image_data_ptr = curFrame->raw_data_ptr + frWidth;
-//            else
-            curFrame->image_data_ptr = curFrame->raw_data_ptr;
-            if(inverted)
-            { // record the data from high to low. Store the pixel buffer in INVERTED order from the camera link
-                for(uint i = 0; i < frHeight*frWidth; i++ )
-                    curFrame->image_data_ptr[i] = invFactor - curFrame->image_data_ptr[i];
-            }
-
-
-            // Calculating the filters for this frame
-            if(runStdDev)
-            {
-                sdvf->update_GPU_buffer(curFrame,std_dev_filter_N);
+                temp_frame = zeroFrame;
             }
-            dsf->update(curFrame->raw_data_ptr,curFrame->dark_subtracted_data);
-            mf->update(curFrame,count,meanStartCol,meanWidth,\
-                       meanStartRow,meanHeight,frWidth,useDSF,\
-                       whichFFT, lh_start, lh_end,\
-                                               cent_start, cent_end,\
-                                               rh_start, rh_end);
 
-            mf->start_mean();
-
-            if((save_framenum > 0) || continuousRecording)
-            {
-                uint16_t * raw_copy = new uint16_t[frWidth*dataHeight];
-                memcpy(raw_copy,curFrame->raw_data_ptr,frWidth*dataHeight*sizeof(uint16_t));
-                saving_list.push_front(raw_copy);
-                save_framenum--;
-            }
+            // From here on out, the code is shared
+            // with the EDT frame grabber code. Only frames read from
+            // the files carry a line header.
+            processFrame(temp_frame, mf, false,
+                         (camStatus == CameraModel::camPlaying) && (temp_frame != zeroFrame));
 
-            framecount = *(curFrame->raw_data_ptr + 160); // The framecount is stored 160 bytes offset from the beginning of the data
-            /*
-            if(CHECK_FOR_MISSED_FRAMES_6604A && cam_type == CL_6604A)
-            {
-                if( (framecount - 1 != last_framecount) && (last_framecount != UINT16_MAX) )
-                {
-                    std::cerr << "WARNING: MISSED FRAME " << framecount << std::endl;
-                }
-            }
-            */
-
-            last_framecount = framecount;
             count++;
             grabbing = false;
             if(closing)
@@ -1225,15 +2004,13 @@ void take_object::rtpConsumeFrames()
                                        whichFFT, lh_start, lh_end,\
                                        cent_start, cent_end,\
                                        rh_start, rh_end);
+    setupMeanFilter(mf);
 
     std::chrono::steady_clock::time_point begintp;
     std::chrono::steady_clock::time_point finaltp;
 
-    int framecount = 0;
-    int last_framecount __attribute__((unused)) = 0;
     uint16_t *temp_frame = NULL;
     int lastFrameNumber = 0;
-    count = 0;
 
     if(shmValid) {
         shm->statusByte = SHM_STATUS_READY;
@@ -1245,86 +2022,31 @@ void take_object::rtpConsumeFrames()
     {
         begintp = std::chrono::steady_clock::now();
         grabbing = true;
-        curFrame = &frame_ring_buffer[count % CPU_FRAME_BUFFER_SIZE];
-        curFrame->reset();
+        curFrame = claimNextFrame();
+        std::chrono::steady_clock::time_point waittp = std::chrono::steady_clock::now();
         temp_frame = Camera->getFrameWait(lastFrameNumber, &this->camStatus);
-        memcpy(curFrame->raw_data_ptr,temp_frame,frWidth*dataHeight*2);
-
-
-        if(pixRemap)
-        {
-            apply_chroma_translate_filter(curFrame->raw_data_ptr);
-            //curFrame->image_data_ptr = curFrame->raw_data_ptr;
-        }
-
-
-        curFrame->image_data_ptr = curFrame->raw_data_ptr;
-        if(inverted)
-        { // record the data from high to low. Store the pixel buffer in INVERTED order from the camera link
-            for(uint i = 0; i < frHeight*frWidth; i++ )
-                curFrame->image_data_ptr[i] = invFactor - curFrame->image_data_ptr[i];
-        }
-
-        if(setDarkStatusInFrame) {
-            curFrame->image_data_ptr[obcStatusPixel] = darkStatusPixelVal;
-        }
-
-        shmBufferPosition = (shmBufferPositionPrior + 1)%shmFrameBufferSize;
-        if(shmValid) {
-            shm->writingFrameNum = shmBufferPosition;
-            memcpy(shm->frameBuffer[shmBufferPosition],curFrame->raw_data_ptr, frHeight*frWidth*2);
-        }
-
-
-        // Calculating the filters for this frame
-        if(!options.noGPU) {
-            if(runStdDev)
-            {
-                sdvf->update_GPU_buffer(curFrame,std_dev_filter_N);
-            }
-            dsf->update(curFrame->raw_data_ptr,curFrame->dark_subtracted_data);
-            mf->update(curFrame,count,meanStartCol,meanWidth,\
-                       meanStartRow,meanHeight,frWidth,useDSF,\
-                       whichFFT, lh_start, lh_end,\
-                       cent_start, cent_end,\
-                       rh_start, rh_end);
-
-            mf->start_mean();
-        }
-
-        if((save_framenum > 0) || continuousRecording)
+        stageLatency[LATENCY_CAMERA_WAIT].record(waittp, std::chrono::steady_clock::now());
+        if(!rtpConsumerRun)
         {
-            uint16_t * raw_copy = new uint16_t[frWidth*dataHeight];
-            memcpy(raw_copy,curFrame->raw_data_ptr,frWidth*dataHeight*sizeof(uint16_t));
-            saving_list.push_front(raw_copy);
-            save_framenum--;
+            // Stopping, the camera handed back a placeholder rather than a frame.
+            endFrameClaim();
+            grabbing = false;
+            break;
         }
 
-        framecount = *(curFrame->raw_data_ptr + 160); // The framecount is stored 160 bytes offset from the beginning of the data
-        /*
-        if(CHECK_FOR_MISSED_FRAMES_6604A && cam_type == CL_6604A)
-        {
-            if( (framecount - 1 != last_framecount) && (last_framecount != UINT16_MAX) )
-            {
-                std::cerr << "WARNING: MISSED FRAME " << framecount << std::endl;
-            }
-        }
-        */
+        processFrame(temp_frame, mf, true);
 
         finaltp = std::chrono::steady_clock::now();
         measuredDelta_micros_final = std::chrono::duration_cast<std::chrono::microseconds>(finaltp-begintp).count();
         meanDeltaArray[(++meanDeltaArrayPos)%meanDeltaSize] = measuredDelta_micros_final;
 
         if(shmValid) {
+            // The frame itself, its time and the counter are written by the frame graph.
             if(measuredDelta_micros_final != 0)
                 shm->fps = 1E6/measuredDelta_micros_final;
-            shm->frameTime[shmBufferPosition] = finaltp.time_since_epoch() / std::chrono::milliseconds(1);
-            shm->counter = count;
         }
-        shmBufferPositionPrior = shmBufferPosition;
 
 
-        last_framecount = framecount;
         count++;
         grabbing = false;
     }
@@ -1333,10 +2055,6 @@ void take_object::rtpConsumeFrames()
 
 void take_object::pdv_loop() //Producer Thread (pdv_thread)
 {
-	count = 0;
-
-    uint16_t framecount = 1;
-    uint16_t last_framecount = 0;
     unsigned char* wait_ptr = NULL;
 
 
@@ -1345,6 +2063,7 @@ void take_object::pdv_loop() //Producer Thread (pdv_thread)
                                        whichFFT, lh_start, lh_end,\
                                        cent_start, cent_end,\
                                        rh_start, rh_end);
+    setupMeanFilter(mf);
 
     std::chrono::steady_clock::time_point finaltp;
     std::chrono::steady_clock::time_point begintp;
@@ -1356,87 +2075,32 @@ void take_object::pdv_loop() //Producer Thread (pdv_thread)
     {	
         grabbing = true;
         begintp = std::chrono::steady_clock::now();
-        curFrame = &frame_ring_buffer[count % CPU_FRAME_BUFFER_SIZE];
-        curFrame->reset();
+        curFrame = claimNextFrame();
         if(closing)
         {
+            endFrameClaim();
             pdv_thread_run = 0;
             break;
 
         } else {
-            pdv_start_image(pdv_p); //Start another
             // Have seen Segmentation faults here on closing liveview:
-            if(!closing) wait_ptr = pdv_wait_image(pdv_p);
+            std::chrono::steady_clock::time_point waittp = std::chrono::steady_clock::now();
+            wait_ptr = pdv_wait_image(pdv_p);
+            stageLatency[LATENCY_CAMERA_WAIT].record(waittp, std::chrono::steady_clock::now());
         }
         cam_thread_start_complete=true;
-
-        /* In this section of the code, after we have copied the memory from the camera link
-         * buffer into the raw_data_ptr, we will check various parameters to see if we need to
-         * modify the data based on our hardware.
-         *
-         * First, the data is stored differently depending on the type of camera, 6604A or B.
-         *
-         * Second, we may have to apply a filter to pixels which remaps the image based on the
-         * way information is sent by some detectors.
-         *
-         * Third, we may need to invert the data range if a cable is inverting the magnitudes
-         * that arrive from the ADC. This feature is also modified from the preference window.
-         */
-        memcpy(curFrame->raw_data_ptr,wait_ptr,frWidth*dataHeight*sizeof(uint16_t));
-        if(pixRemap)
-            apply_chroma_translate_filter(curFrame->raw_data_ptr);
-
-        curFrame->image_data_ptr = curFrame->raw_data_ptr;
-        if(inverted)
-        { // record the data from high to low. Store the pixel buffer in INVERTED order from the camera link
-            for(uint i = 0; i < frHeight*frWidth; i++ )
-                curFrame->image_data_ptr[i] = invFactor - curFrame->image_data_ptr[i];
-        }
-
-        if(setDarkStatusInFrame) {
-            curFrame->image_data_ptr[obcStatusPixel] = darkStatusPixelVal;
-        }
-
-        shmBufferPosition = (shmBufferPositionPrior + 1)%shmFrameBufferSize;
-        if(shmValid) {
-            shm->writingFrameNum = shmBufferPosition;
-            memcpy(shm->frameBuffer[shmBufferPosition],curFrame->raw_data_ptr, frHeight*frWidth*2);
-        }
-
-        // Calculating the filters for this frame
-        if(!options.noGPU) {
-
-            if(runStdDev)
-            {
-                sdvf->update_GPU_buffer(curFrame,std_dev_filter_N);
-            }
-            dsf->update(curFrame->raw_data_ptr,curFrame->dark_subtracted_data);
-            mf->update(curFrame,count,meanStartCol,meanWidth,\
-                       meanStartRow,meanHeight,frWidth,useDSF,\
-                       whichFFT, lh_start, lh_end,\
-                       cent_start, cent_end,\
-                       rh_start, rh_end);
-
-            mf->start_mean();
-        }
-
-        if((save_framenum > 0) || continuousRecording)
+        if(closing || (wait_ptr == NULL))
         {
-            uint16_t * raw_copy = new uint16_t[frWidth*dataHeight];
-            memcpy(raw_copy,curFrame->raw_data_ptr,frWidth*dataHeight*sizeof(uint16_t));
-            saving_list.push_front(raw_copy);
-            save_framenum--;
+            endFrameClaim();
+            pdv_thread_run = 0;
+            break;
         }
 
-        framecount = *(curFrame->raw_data_ptr + 160); // The framecount is stored 160 bytes offset from the beginning of the data
-        if(CHECK_FOR_MISSED_FRAMES_6604A && cam_type == CL_6604A)
-        {
-            if( (framecount - 1 != last_framecount) && (last_framecount != UINT16_MAX) )
-            {
-                std::cerr << "WARNING: MISSED FRAME " << framecount << std::endl;
-            }
-        }
-        last_framecount = framecount;
+        // The frame is conditioned straight out of the DMA buffer into curFrame,
+        // there is no intermediate copy. The buffer is held until that is done,
+        // and only then handed back to the driver by starting another image.
+        processFrame((uint16_t *)wait_ptr, mf, true);
+        pdv_start_image(pdv_p); //Start another
         count++;
 
         finaltp = std::chrono::steady_clock::now();
@@ -1444,12 +2108,10 @@ void take_object::pdv_loop() //Producer Thread (pdv_thread)
         meanDeltaArray[(++meanDeltaArrayPos)%meanDeltaSize] = measuredDelta_micros_final;
 
         if(shmValid) {
+            // The frame itself, its time and the counter are written by the frame graph.
             if(measuredDelta_micros_final != 0)
                 shm->fps = 1E6/measuredDelta_micros_final;
-            shm->frameTime[shmBufferPosition] = finaltp.time_since_epoch() / std::chrono::milliseconds(1);
-            shm->counter = count;
         }
-        shmBufferPositionPrior = shmBufferPosition;
 
 
         grabbing = false;
@@ -1460,13 +2122,510 @@ void take_object::pdv_loop() //Producer Thread (pdv_thread)
         }
     }
 }
+void take_object::processFrame(const uint16_t *source, mean_filter *mf, bool liveSource, bool hasLineHeader)
+{
+    /* In this section of the code, we copy the memory from the camera
+     * buffer into the raw_data_ptr of curFrame, and check various parameters
+     * to see if we need to modify the data based on our hardware.
+     *
+     * First, we may have to apply a filter to pixels which remaps the image based on the
+     * way information is sent by some detectors (2s compliment).
+     *
+     * Second, we may need to invert the data range if a cable is inverting the magnitudes
+     * that arrive from the ADC. This feature is also modified from the preference window.
+     *
+     * Both are applied in the same pass as the copy, see frame_conditioning.hpp.
+     * Once a dark mask is available, the dark subtraction is done in that pass as well.
+     *
+     * Live sources (camera link and RTP) additionally get the dark status pixel,
+     * the shared memory copy, and honor the noGPU option.
+     *
+     * The line header is decoded from the camera buffer before any of that,
+     * into curFrame->metadata, and the frame counter checked for continuity.
+     *
+     * Everything after the conditioning is handed to the frame graph, see
+     * submitFrameGraph. The camera buffer is no longer needed once this returns.
+     */
+    if(hasLineHeader)
+        metadataDecoder.decode(source, frWidth, curFrame->metadata);
+    else
+        curFrame->metadata.valid = false;
+    if(continuity.observe(curFrame->metadata, count))
+        reportFrameGap();
+
+    bool runFilters = !liveSource || !options.noGPU;
+
+    // The derived products are computed for the frames their schedules pick,
+    // see product_schedule.hpp; the other frames only feed the histories which
+    // need every frame. A frame which is due is skipped as well if too many
+    // frames are still waiting for their products, so that a pool slot is never
+    // reused while a graph node is writing it. The next frame is then due.
+    // The standard deviation is only started for frames with the means, as
+    // those are the frames announced for display.
+    std::chrono::steady_clock::time_point arrivaltp = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point demandtp = lastDemand.load(std::memory_order_relaxed);
+    bool meansDue = runFilters && productSchedules[PRODUCT_MEANS].due(count, arrivaltp, demandtp);
+    bool products = meansDue && (productsInFlight.load(std::memory_order_acquire) < productLimit);
+    if(meansDue && !products)
+        productSkips.fetch_add(1, std::memory_order_relaxed);
+    if(products)
+        productSchedules[PRODUCT_MEANS].produced(count, arrivaltp);
+    bool stdDevDue = products && productSchedules[PRODUCT_STD_DEV].due(count, arrivaltp, demandtp);
+
+    // While a dark mask is being collected, dsf->update must see the
+    // conditioned frame, so the fused kernel is only used once a mask exists.
+    if(products)
+    {
+        // The derived products for this frame go into the next pool slots.
+        curFrame->attach_dark(darkPool.next());
+        curFrame->attach_mean_products(meanPool.next());
+    }
+    bool fusedDark = products && dsf->mask_ready();
+    std::chrono::steady_clock::time_point stagetp = std::chrono::steady_clock::now();
+    if(fusedDark)
+    {
+        fused_conditioner_t condition = select_fused_conditioner(pixRemap, inverted);
+        condition(curFrame->raw_data_ptr, curFrame->dark_subtracted_data, source,
+                  dsf->get_mask(), frWidth*dataHeight, (uint16_t)invFactor);
+    } else {
+        frame_conditioner_t condition = select_frame_conditioner(pixRemap, inverted);
+        condition(curFrame->raw_data_ptr, source, frWidth*dataHeight, (uint16_t)invFactor);
+    }
+    curFrame->image_data_ptr = curFrame->raw_data_ptr;
+    stageLatency[LATENCY_CONDITION].record(stagetp, std::chrono::steady_clock::now());
+
+    if(liveSource && setDarkStatusInFrame)
+    {
+        curFrame->image_data_ptr[obcStatusPixel] = darkStatusPixelVal;
+        if(fusedDark)
+            curFrame->dark_subtracted_data[obcStatusPixel] = darkStatusPixelVal - dsf->get_mask()[obcStatusPixel];
+    }
+    endFrameClaim();
+
+    submitFrameGraph(mf, liveSource && shmValid, products, fusedDark, runFilters, stdDevDue);
+
+    // Without the filters there is no mean_filter to announce the frame,
+    // so it is ready for display as soon as it is conditioned.
+    if(!runFilters)
+        frameNotifier.publish(count + 1);
+
+    if(firstFramePending.load(std::memory_order_relaxed))
+        reportFirstFrame();
+}
+
+void take_object::startFrameGraph()
+{
+    // Workers for the frame graph. They are named GRAPH0, GRAPH1, ... for
+    // --thread-cpus and --thread-rtprio.
+    unsigned int workers = options.graphThreads;
+    if(workers == 0)
+    {
+        unsigned int cpus = std::thread::hardware_concurrency();
+        workers = (cpus > 4) ? cpus - 2 : 2;
+        if(workers > FRAME_GRAPH_AUTO_THREADS)
+            workers = FRAME_GRAPH_AUTO_THREADS;
+    }
+    setProductLimit();
+
+    freeFrameJobs.clear();
+    for(unsigned int j = 0; j < FRAME_GRAPH_MAX_JOBS; j++)
+        freeFrameJobs.push_back(&frameJobs[j]);
+    frameGraphStarted = true;
+
+    if(sharedGraph != NULL)
+    {
+        // The owner of the shared executor starts it and places its threads.
+        statusMessage(std::string("Frame graph sharing ") + std::to_string(sharedGraph->size()) +
+                      " threads with the other pipelines, with up to " +
+                      std::to_string(productLimit) + " frames of products in flight.");
+        return;
+    }
+    frameGraph.start(workers, "GRAPH");
+    for(unsigned int w = 0; w < frameGraph.size(); w++)
+        applyThreadPolicy(frameGraph.nativeHandle(w), frameGraph.threadName(w).c_str());
+    statusMessage(std::string("Frame graph running on ") + std::to_string(frameGraph.size()) + " threads, with up to " +
+                  std::to_string(productLimit) + " frames of products in flight.");
+}
+
+void take_object::setProductLimit()
+{
+    // A quarter of the product pools may be in the graph at once, see processFrame.
+    productLimit = darkPool.depth() / 4;
+    if(productLimit > FRAME_GRAPH_MAX_PRODUCTS)
+        productLimit = FRAME_GRAPH_MAX_PRODUCTS;
+    if(productLimit == 0)
+        productLimit = 1;
+}
+
+void take_object::setupMeanFilter(mean_filter *mf)
+{
+    // The camera loop's filter, before its first frame. From here on it is
+    // shared with getMeanSeries() and getPlaneMeanSpectrum(), and deleted by
+    // stopAcquisition() or by the last of them still using it.
+    mf->setNotifier(&frameNotifier);
+    mf->setHistoryLength(options.meanHistory);
+    mf->myFFT.setWindow((fft_window_t)options.fftWindow);
+    if(options.meanHistory > FFT_INPUT_LENGTH)
+        statusMessage(std::string("Keeping ") + std::to_string(mf->getHistoryLength()) + " frame means for the plane mean spectrum, " +
+                      fft_window_name(mf->myFFT.getWindow()) + " window.");
+    std::lock_guard<std::mutex> lock(loopMeanFilterLock);
+    loopMeanFilter.reset(mf);
+}
+
+void take_object::applyProductPolicies()
+{
+    // The schedules from options, see product_schedule.hpp. The first frame
+    // after start() or reconfigure() gets every product.
+    setProductPolicy(PRODUCT_MEANS, (product_policy_t)options.meansPolicy, options.productEvery);
+    setProductPolicy(PRODUCT_STD_DEV, (product_policy_t)options.stdDevPolicy, options.productEvery);
+    for(unsigned int p = 0; p < PRODUCT_KIND_COUNT; p++)
+        productSchedules[p].reset();
+}
+
+void take_object::setProductPolicy(derived_product_t product, product_policy_t policy, unsigned int every)
+{
+    /*! \brief Which frames get product from the next frame on, see product_schedule.hpp.
+     * \param every The n of PRODUCT_EVERY_NTH, 0 for the filter_refresh_rate given to the constructor
+     * May be called while frames arrive. reconfigure() goes back to the policies of its options.
+     */
+    if((product >= PRODUCT_KIND_COUNT) || (policy > PRODUCT_DISPLAY_RATE))
+    {
+        warningMessage("Unknown derived product or policy, not changed.");
+        return;
+    }
+    if(every == 0)
+        every = (filter_refresh_rate > 0) ? filter_refresh_rate : 1;
+    productSchedules[product].setPolicy(policy, every);
+
+    std::string how = "for every frame";
+    if(policy == PRODUCT_EVERY_NTH)
+        how = std::string("every ") + std::to_string(every) + " frames";
+    else if(policy == PRODUCT_DISPLAY_RATE)
+        how = std::string("at most every ") + std::to_string(PRODUCT_DISPLAY_PERIOD_MS) + " ms, while frames are displayed";
+    statusMessage(std::string((product == PRODUCT_MEANS) ? "Mean profiles and FFT" : "Standard deviation") +
+                  " computed " + how + ".");
+}
+
+product_policy_t take_object::getProductPolicy(derived_product_t product)
+{
+    return (product < PRODUCT_KIND_COUNT) ? productSchedules[product].policy() : PRODUCT_EVERY_FRAME;
+}
+
+uint64_t take_object::getProducedFrames(derived_product_t product)
+{
+    /*! \brief Frames product has been computed for since the take_object was made. */
+    return (product < PRODUCT_KIND_COUNT) ? productSchedules[product].producedFrames() : 0;
+}
+
+void take_object::shareFrameGraph(frame_executor *executor)
+{
+    /*! \brief Run this pipeline's frame graph on executor rather than on threads of its own.
+     * For several take_objects in one process, so that they share one budget of threads and cores.
+     * Call before start(). The caller starts executor, and keeps it running until every take_object
+     * using it has been destroyed. NULL goes back to a private executor.
+     */
+    sharedGraph = executor;
+    frame_executor &graph = (executor != NULL) ? *executor : frameGraph;
+    darkStrand.bind(graph);
+    meanStrand.bind(graph);
+    stdDevStrand.bind(graph);
+    shmStrand.bind(graph);
+    saveStrand.bind(graph);
+}
+
+void take_object::drainFrameGraph()
+{
+    // Wait for the graphs of the frames already acquired. A private executor
+    // is stopped as well; a shared one keeps running for the other pipelines.
+    if(sharedGraph == NULL)
+    {
+        frameGraph.stop();
+        return;
+    }
+    waitFrameGraphIdle();
+}
+
+void take_object::waitFrameGraphIdle()
+{
+    // Wait until every job submitted so far has finished, leaving the executor running.
+    if(!frameGraphStarted)
+        return;
+    std::unique_lock<std::mutex> lock(frameJobLock);
+    frameJobFreed.wait(lock, [this] { return freeFrameJobs.size() == FRAME_GRAPH_MAX_JOBS; });
+}
+
+take_object::frame_job_t *take_object::takeFrameJob()
+{
+    // A free job, waiting for the graph to finish one if need be. This only
+    // blocks the camera loop if every job is in flight.
+    std::unique_lock<std::mutex> lock(frameJobLock);
+    if(freeFrameJobs.empty())
+    {
+        graphStalls.fetch_add(1, std::memory_order_relaxed);
+        frameJobFreed.wait(lock, [this] { return !freeFrameJobs.empty(); });
+    }
+    frame_job_t *job = freeFrameJobs.back();
+    freeFrameJobs.pop_back();
+    return job;
+}
+
+void take_object::submitFrameGraph(mean_filter *mf, bool shmNode, bool products, bool fusedDark, bool filters, bool stdDevDue)
+{
+    /* The graph for one frame. Each node runs on a strand, so that every
+     * product sees the frames in order:
+     *
+     *   dark subtraction (unless fused) -> histograms, mean profiles and FFT -> frame ready
+     *   standard deviation update
+     *   shared memory copy
+     *   save queue push
+     *
+     * A frame without products, but with the filters running, instead goes
+     * through the same strands to the dark mask being collected and the
+     * frame mean history, and adds itself to the standard deviation ring.
+     *
+     * The frame is leased until the last node finishes. The parameters the
+     * nodes need are copied now, as they may be changed from the GUI at any time.
+     */
+    frame_job_t *job = takeFrameJob();
+    job->frame = curFrame;
+    job->frameCount = count;
+    job->mf = mf;
+    job->fusedDark = fusedDark;
+    job->stdDevN = std_dev_filter_N;
+    job->meanStartCol = meanStartCol;
+    job->meanWidth = meanWidth;
+    job->meanStartRow = meanStartRow;
+    job->meanHeight = meanHeight;
+    job->useDSF = useDSF;
+    job->fftType = whichFFT;
+    job->lh_start = lh_start;
+    job->lh_end = lh_end;
+    job->cent_start = cent_start;
+    job->cent_end = cent_end;
+    job->rh_start = rh_start;
+    job->rh_end = rh_end;
+    job->submitted = std::chrono::steady_clock::now();
+    job->ingest = filters && !products;
+    job->stdDevCalculate = stdDevDue;
+
+    bool stdDevNode = filters && runStdDev;
+    job->pending.store(1 + ((products || job->ingest) ? 1 : 0) + (stdDevNode ? 1 : 0) + (shmNode ? 1 : 0));
+    curFrame->lease();
+
+    if(products)
+    {
+        productsInFlight.fetch_add(1, std::memory_order_acq_rel);
+        darkStrand.post([this, job] { runDarkNode(job); });
+    } else if(job->ingest) {
+        darkStrand.post([this, job] { runIngestNode(job); });
+    }
+    if(stdDevNode)
+        stdDevStrand.post([this, job] { runStdDevNode(job); });
+    if(shmNode)
+        shmStrand.post([this, job] { runShmNode(job); });
+    saveStrand.post([this, job] {
+        queueFrameForSaving(job->frame->raw_data_ptr);
+        finishFrameNode(job);
+    });
+}
+
+void take_object::runDarkNode(frame_job_t *job)
+{
+    if(!job->fusedDark)
+    {
+        std::chrono::steady_clock::time_point stagetp = std::chrono::steady_clock::now();
+        dsf->update(job->frame->raw_data_ptr, job->frame->dark_subtracted_data);
+        stageLatency[LATENCY_DARK_SUBTRACT].record(stagetp, std::chrono::steady_clock::now());
+    }
+    meanStrand.post([this, job] { runMeanNode(job); });
+}
+
+void take_object::runMeanNode(frame_job_t *job)
+{
+    // Publishes the frame on frameNotifier when done, see mean_filter::setNotifier,
+    // so the intensity histograms are counted first.
+    std::chrono::steady_clock::time_point stagetp = std::chrono::steady_clock::now();
+    size_t pixels = (size_t)frWidth*dataHeight;
+    intensityBins.count(job->frame->raw_data_ptr, pixels, job->frame->raw_histogram);
+    intensityBins.count(job->frame->dark_subtracted_data, pixels, job->frame->dark_histogram);
+    job->mf->update(job->frame, job->frameCount, job->meanStartCol, job->meanWidth,
+                    job->meanStartRow, job->meanHeight, frWidth, job->useDSF,
+                    job->fftType, job->lh_start, job->lh_end,
+                    job->cent_start, job->cent_end,
+                    job->rh_start, job->rh_end);
+    job->mf->calculate_means();
+    stageLatency[LATENCY_MEAN_FILTER].record(stagetp, std::chrono::steady_clock::now());
+    productsInFlight.fetch_sub(1, std::memory_order_acq_rel);
+    finishFrameNode(job);
+}
+
+void take_object::runIngestNode(frame_job_t *job)
+{
+    // Collects the frame into the dark mask, if one is being collected, as
+    // dsf->update would.
+    if(!dsf->mask_ready())
+    {
+        std::lock_guard<std::mutex> lock(dsf->mask_mutex);
+        dsf->update_mask_collection(job->frame->raw_data_ptr);
+    }
+    meanStrand.post([this, job] { runMeanIngestNode(job); });
+}
+
+void take_object::runMeanIngestNode(frame_job_t *job)
+{
+    // Only the frame mean, for the PLANE_MEAN FFT of the frames with products.
+    job->mf->ingest_mean(job->frame->raw_data_ptr, job->useDSF ? dsf->get_mask() : NULL, job->frameCount,
+                         job->meanStartCol, job->meanWidth, job->meanStartRow, job->meanHeight, frWidth,
+                         job->frame->height, job->cent_start, job->cent_end);
+    finishFrameNode(job);
+}
+
+void take_object::runStdDevNode(frame_job_t *job)
+{
+    std::chrono::steady_clock::time_point stagetp = std::chrono::steady_clock::now();
+    if(sdvf->update_GPU_buffer(job->frame, job->stdDevN, job->stdDevCalculate))
+        productSchedules[PRODUCT_STD_DEV].produced(job->frameCount, stagetp);
+    stageLatency[LATENCY_STD_DEV].record(stagetp, std::chrono::steady_clock::now());
+    finishFrameNode(job);
+}
+
+void take_object::runShmNode(frame_job_t *job)
+{
+    // Readers of the segment always read one behind writingFrameNum,
+    // the slot being copied into.
+    std::chrono::steady_clock::time_point stagetp = std::chrono::steady_clock::now();
+    shmBufferPosition = (shmBufferPositionPrior + 1)%shmFrameBufferSize;
+    shm->writingFrameNum = shmBufferPosition;
+    memcpy(shm->frameBuffer[shmBufferPosition], job->frame->raw_data_ptr, frHeight*frWidth*2);
+    std::chrono::steady_clock::time_point endtp = std::chrono::steady_clock::now();
+    shm->frameTime[shmBufferPosition] = endtp.time_since_epoch() / std::chrono::milliseconds(1);
+    // The loop counted the frame after handing it over, so the segment
+    // sees the count including it, as it did when written in the loop.
+    shm->counter = job->frameCount + 1;
+    shmBufferPositionPrior = shmBufferPosition;
+    stageLatency[LATENCY_SHM_PUBLISH].record(stagetp, endtp);
+    publishContinuityToShm();
+    if(job->frameCount % LATENCY_SHM_UPDATE_FRAMES == 0)
+        publishLatencyToShm();
+    finishFrameNode(job);
+}
+
+void take_object::finishFrameNode(frame_job_t *job)
+{
+    // The last node of a frame releases the frame and the job.
+    if(job->pending.fetch_sub(1, std::memory_order_acq_rel) != 1)
+        return;
+    stageLatency[LATENCY_FRAME_GRAPH].record(job->submitted, std::chrono::steady_clock::now());
+    job->frame->unlease();
+    job->frame = NULL;
+    {
+        std::lock_guard<std::mutex> lock(frameJobLock);
+        freeFrameJobs.push_back(job);
+    }
+    frameJobFreed.notify_one();
+}
+
+uint64_t take_object::getProductSkips()
+{
+    return productSkips.load(std::memory_order_relaxed);
+}
+
+mean_series_summary take_object::getMeanSeries()
+{
+    // Holes are frames missing from the PLANE_MEAN history, which the frame
+    // graph should never leave; product skips only cost a frame its profiles.
+    std::lock_guard<std::mutex> lock(loopMeanFilterLock);
+    if(loopMeanFilter)
+        return loopMeanFilter->seriesSummary();
+    return lastMeanSeries;
+}
+
+unsigned int take_object::getPlaneMeanSpectrum(unsigned int segment, std::vector<float> &magnitude)
+{
+    // Welch's spectrum of the frame means, see mean_filter::planeMeanSpectrum().
+    // Made on the calling thread, with the filter held so that stopping the
+    // acquisition meanwhile cannot delete it; frequency k is k/segment of the
+    // frame rate. Until the history reaches segment it is done in one piece.
+    std::shared_ptr<mean_filter> mf;
+    {
+        std::lock_guard<std::mutex> lock(loopMeanFilterLock);
+        mf = loopMeanFilter;
+    }
+    if(!mf)
+    {
+        magnitude.clear();
+        return 0;
+    }
+    unsigned int segments = mf->planeMeanSpectrum(segment, magnitude);
+    if(segments == 0)
+        segments = mf->planeMeanSpectrum(0, magnitude);
+    return segments;
+}
+
+uint64_t take_object::getFrameGraphStalls()
+{
+    return graphStalls.load(std::memory_order_relaxed);
+}
+
+frame_continuity_summary take_object::getContinuity()
+{
+    /*! \brief Dropped, repeated and out of order frames since start(), from the line header frame counter. */
+    return continuity.summary();
+}
+
+unsigned int take_object::getRecentFrameGaps(frame_gap_t *gaps, unsigned int maxGaps)
+{
+    /*! \brief The most recent gaps in the frame counter, oldest first. Returns the number copied into gaps. */
+    return continuity.recentGaps(gaps, maxGaps);
+}
+
+void take_object::setupContinuity()
+{
+    // After openSource(), which settles cam_type. Camera link frames only
+    // have a line header on some cameras, and without one nothing is checked.
+    metadataDecoder = frame_metadata_decoder(frameSource(), cam_type);
+    continuity.reset();
+    shmGapsPublished = 0;
+    statusMessage(std::string("Frame counter continuity for the ") + frame_source_name(frameSource()) + " source: " +
+                  metadataDecoder.layoutName() + (metadataDecoder.headerPresent() ? "." : ", frames are not checked."));
+}
+
+frame_source_t take_object::frameSource()
+{
+    // Which line header decoder to use, see frame_metadata.hpp.
+    if(options.syntheticCam)
+        return FRAME_SOURCE_SYNTHETIC;
+    if(options.xioCam)
+        return FRAME_SOURCE_XIO;
+    if(options.rtpCam && options.rtpNextGen)
+        return FRAME_SOURCE_RTPNG;
+    if(options.rtpCam)
+        return FRAME_SOURCE_RTP;
+    return FRAME_SOURCE_PDV;
+}
+
+void take_object::reportFrameGap()
+{
+    // At most one warning a second, the counters keep the rest.
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if(now - lastGapWarning < std::chrono::seconds(1))
+        return;
+    lastGapWarning = now;
+    frame_continuity_summary summary = continuity.summary();
+    std::ostringstream message;
+    message << "Frame counter gap from " << frame_source_name(metadataDecoder.source()) << ": expected "
+            << summary.lastGap.expected << ", received " << summary.lastGap.received << ". "
+            << summary.dropped << " frames dropped in " << summary.gaps << " gaps so far.";
+    warningMessage(message.str());
+}
+
 void take_object::savingLoop(std::string fname, unsigned int num_avgs, unsigned int num_frames) 
 {
     // Frame Save Thread (saving_thread)
 
-    // The main loop (pdvLoop, etc) of take_object will place frames into save_list,
-    // and this thread will remove frames in save_list. While the data are being taken,
-    // this thread will not empty the list.
+    // The main loop (pdvLoop, etc) of take_object will place frames into saving_queue,
+    // and this thread will remove frames from saving_queue. The queue slots are
+    // preallocated, so frames are written straight out of the slot and then released.
 
     // This thread ends when the file finished being written to and the buffer is empty.
 
@@ -1512,123 +2671,103 @@ void take_object::savingLoop(std::string fname, unsigned int num_avgs, unsigned
     FILE * file_target = fopen(fname.c_str(), "wb");
     int sv_count = 0;
 
-    while(  (save_framenum != 0) || continuousRecording)
+    // When averaging, frames are summed into avg_data as they come off
+    // the queue, so the queue never needs to hold num_avgs frames at once.
+    float * avg_data = NULL;
+    unsigned int avg_count = 0;
+    if(num_avgs > 1)
+        avg_data = new float[frWidth*dataHeight];
+
+    uint16_t * data = NULL;
+    bool draining = false;
+    while(true)
     {
-        if(saving_list.size() > 2)
+        if(!draining && (save_framenum == 0) && !continuousRecording)
         {
-            if(num_avgs == 1)
-            {
-                // This is our not-averaging save, where most saves go:
-                if(saving_list.size() > 2) {
-                    // We refuse to take the last item off the list.
-                    // it can wait until we are completely done recording.
-                    // This way the list remains valid in memory.
-                    uint16_t * data = saving_list.back();
-                    saving_list.pop_back();
-                    fwrite(data,sizeof(uint16_t),frWidth*dataHeight,file_target); //It is ok if this blocks
-                    delete[] data;
-                    sv_count++;
-                    if(sv_count == 1) {
-                        save_count.store(1, std::memory_order_seq_cst);
-                    }
-                    else {
-                        save_count++;
-                    }
-                }
+            // Almost done, let's take care of anything left in the buffer.
+            draining = true;
+            statusMessage("Finished primary saving loop.");
+            char message[128];
+            sprintf(message, "Size of buffer: %u", saving_queue.depth());
+            statusMessage(message);
+        }
+
+        // Blocks until the acquisition loop pushes a frame, or times out
+        // so that the recording state above can be re-checked.
+        data = saving_queue.front(draining?0:100);
+        if(data == NULL)
+        {
+            if(draining)
+                break;
+            continue;
+        }
+
+        if(avg_data == NULL)
+        {
+            // This is our not-averaging save, where most saves go:
+            std::chrono::steady_clock::time_point writetp = std::chrono::steady_clock::now();
+            fwrite(data,sizeof(uint16_t),frWidth*dataHeight,file_target); //It is ok if this blocks
+            stageLatency[LATENCY_SAVE_WRITE].record(writetp, std::chrono::steady_clock::now());
+            saving_queue.pop();
+            sv_count++;
+            if(sv_count == 1) {
+                save_count.store(1, std::memory_order_seq_cst);
             }
-            else if(saving_list.size() >= num_avgs && num_avgs != 1)
-            {
-                float * data = new float[frWidth*dataHeight];
-                for(unsigned int i2 = 0; i2 < num_avgs; i2++)
-                {
-                    uint16_t * data2 = saving_list.back();
-                    saving_list.pop_back();
-                    if(i2 == 0)
-                    {
-                        for(unsigned int i = 0; i < frWidth*dataHeight; i++)
-                        {
-                            data[i] = (float)data2[i];
-                        }
-                    }
-                    else if(i2 == num_avgs-1)
-                    {
-                        for(unsigned int i = 0; i < frWidth*dataHeight; i++)
-                        {
-                            data[i] = (data[i] + (float)data2[i])/num_avgs;
-                        }
-                    }
-                    else
-                    {
-                        for(unsigned int i = 0; i < frWidth*dataHeight; i++)
-                        {
-                            data[i] += (float)data2[i];
-                        }
-                    }
-                    delete[] data2;
-                }
-                fwrite(data,sizeof(float),frWidth*dataHeight,file_target); //It is ok if this blocks
-                delete[] data;
-                sv_count++;
-                if(sv_count == 1) {
-                    save_count.store(1, std::memory_order_seq_cst);
-                }
-                else {
-                    save_count++;
-                }
-                //std::cout << "save_count: " << std::to_string(save_count) << "\n";
-                //std::cout << "list size: " << std::to_string(saving_list.size() ) << "\n";
-                //std::cout << "save_framenum: " << std::to_string(save_framenum) << "\n";
+            else {
+                save_count++;
             }
-            else if(save_framenum == 0 && saving_list.size() < num_avgs)
+            continue;
+        }
+
+        if(avg_count == 0)
+        {
+            for(unsigned int i = 0; i < frWidth*dataHeight; i++)
             {
-                warningMessage("Erasing saving_list");
-                saving_list.erase(saving_list.begin(),saving_list.end());
+                avg_data[i] = (float)data[i];
             }
-            else
+        } else {
+            for(unsigned int i = 0; i < frWidth*dataHeight; i++)
             {
-                //We're waiting for data to get added to the list...
-                usleep(250);
+                avg_data[i] += (float)data[i];
             }
         }
-        else
-        {
-            //We're waiting for data to get added to the list...
-            usleep(250);
-        }
-    }
+        saving_queue.pop();
 
-    // Almost done, let's take care of anything left in the buffer.
-
-    statusMessage("Finished primary saving loop.");
-    char message[128];
-    sprintf(message, "Size of buffer: %ld", saving_list.size());
-    statusMessage(message);
-    if( (num_avgs==1) || (num_avgs==0)) {
-        statusMessage("Finishing write...");
-        while(saving_list.size() > 0) {
-            statusMessage("Writing additional frame");
-            uint16_t * data = saving_list.back();
-            if(saving_list.size() > 0)
-                saving_list.pop_back();
-            fwrite(data,sizeof(uint16_t),frWidth*dataHeight,file_target);
+        if(++avg_count == num_avgs)
+        {
+            for(unsigned int i = 0; i < frWidth*dataHeight; i++)
+            {
+                avg_data[i] /= num_avgs;
+            }
+            std::chrono::steady_clock::time_point writetp = std::chrono::steady_clock::now();
+            fwrite(avg_data,sizeof(float),frWidth*dataHeight,file_target); //It is ok if this blocks
+            stageLatency[LATENCY_SAVE_WRITE].record(writetp, std::chrono::steady_clock::now());
+            avg_count = 0;
             sv_count++;
-            delete[] data;
-        }
-        statusMessage("Done with write.");
-    } else {
-        while(saving_list.size() > 0) {
-            //statusMessage("Dropping additional frame at end that does not meet average interval.");
-            uint16_t * data = saving_list.back();
-            if(saving_list.size() > 0)
-                saving_list.pop_back();
-            // Since averaging is typically many frames (>100),
-            // we cannot really average the last two or three frames
-            // in a meaningfull way. Writing the data out will just
-            // confuse people about the scale of the last few frames.
-            //fwrite(data,sizeof(float),frWidth*dataHeight,file_target);
-            delete[] data;
+            if(sv_count == 1) {
+                save_count.store(1, std::memory_order_seq_cst);
+            }
+            else {
+                save_count++;
+            }
         }
     }
+    // Since averaging is typically many frames (>100),
+    // we cannot really average the last two or three frames
+    // in a meaningfull way. Writing the data out will just
+    // confuse people about the scale of the last few frames,
+    // so a partial average is dropped.
+    if(avg_data != NULL)
+        delete[] avg_data;
+
+    if(saving_queue.droppedFrames() > 0)
+    {
+        std::ostringstream dropMessage;
+        dropMessage << "Saving queue was full, dropped " << saving_queue.droppedFrames()
+                    << " frames. Queue high-water mark: " << saving_queue.highWaterMark()
+                    << " of " << saving_queue.capacity() << " frames.";
+        warningMessage(dropMessage.str());
+    }
 
     fclose(file_target);
     std::string hdr_text;
@@ -1669,13 +2808,100 @@ void take_object::savingLoop(std::string fname, unsigned int num_avgs, unsigned
     savingData = false;
 }
 
+latency_summary take_object::getStageLatency(latency_stage_t stage)
+{
+    /*! \brief p50/p99/p99.9/max latency of one pipeline stage since start() or the last resetStageLatency(). */
+    if((stage < 0) || (stage >= LATENCY_STAGE_COUNT))
+        return latency_summary();
+    return stageLatency[stage].summary();
+}
+
+void take_object::resetStageLatency()
+{
+    for(int s = 0; s < LATENCY_STAGE_COUNT; s++)
+        stageLatency[s].reset();
+}
+
+void take_object::publishLatencyToShm()
+{
+    // Called from processFrame every LATENCY_SHM_UPDATE_FRAMES frames.
+    static_assert(shmLatencyStageCount == LATENCY_STAGE_COUNT, "shm_image.h and latency_histogram.hpp disagree on the stages");
+    for(int s = 0; s < LATENCY_STAGE_COUNT; s++)
+    {
+        latency_summary summary = stageLatency[s].summary();
+        shm->stageLatency[s].count = summary.count;
+        shm->stageLatency[s].p50 = summary.p50_ns / 1000;
+        shm->stageLatency[s].p99 = summary.p99_ns / 1000;
+        shm->stageLatency[s].p999 = summary.p999_ns / 1000;
+        shm->stageLatency[s].max = summary.max_ns / 1000;
+    }
+}
+
+void take_object::publishContinuityToShm()
+{
+    // Called by the shared memory node for every frame. The gap history
+    // is only copied when there has been a new gap.
+    frame_continuity_summary summary = continuity.summary();
+    shm->continuity.checked = summary.checked;
+    shm->continuity.dropped = summary.dropped;
+    shm->continuity.repeated = summary.repeated;
+    shm->continuity.outOfOrder = summary.outOfOrder;
+    shm->continuity.resyncs = summary.resyncs;
+    shm->continuity.lastCounter = summary.lastCounter;
+    shm->continuity.lastObcStatus = summary.lastObcStatus;
+    if(summary.gaps != shmGapsPublished)
+    {
+        frame_gap_t gaps[shmGapHistoryCount];
+        unsigned int n = continuity.recentGaps(gaps, shmGapHistoryCount);
+        for(unsigned int g = 0; g < n; g++)
+        {
+            shm->continuity.recentGaps[g].time = gaps[g].time_ms;
+            shm->continuity.recentGaps[g].frame = gaps[g].frame;
+            shm->continuity.recentGaps[g].missing = gaps[g].missing;
+            shm->continuity.recentGaps[g].expected = gaps[g].expected;
+            shm->continuity.recentGaps[g].received = gaps[g].received;
+        }
+        shm->continuity.recentGapCount = n;
+        shmGapsPublished = summary.gaps;
+    }
+    shm->continuity.gaps = summary.gaps;
+}
+
+void take_object::queueFrameForSaving(uint16_t *frame)
+{
+    // Called by the acquisition loops once per frame.
+    // If the saving queue is full the frame is counted as dropped and
+    // save_framenum is left alone, so the requested number of frames
+    // is still written.
+    // producerQueueing brackets the check and the push, so that
+    // startSavingRaws() can wait for the queue to be left alone.
+    producerQueueing.store(true, std::memory_order_seq_cst);
+    if((save_framenum > 0) || continuousRecording)
+    {
+        std::chrono::steady_clock::time_point begintp = std::chrono::steady_clock::now();
+        bool queued = saving_queue.push(frame);
+        stageLatency[LATENCY_SAVE_ENQUEUE].record(begintp, std::chrono::steady_clock::now());
+        if(queued && !continuousRecording)
+            save_framenum--;
+    }
+    producerQueueing.store(false, std::memory_order_release);
+}
+
+std::string take_object::messageTag()
+{
+    // "take_object: ", or "take_object[SWIR]: " when several pipelines share the process.
+    if(options.instanceName == NULL)
+        return "take_object: ";
+    return std::string("take_object[") + options.instanceName + "]: ";
+}
+
 void take_object::errorMessage(const char *message)
 {
     if((!options.rtpCam) || (options.rtpNextGen))
     {
-        std::cerr << "take_object: ERROR: " << message << std::endl;
+        std::cerr << messageTag() << "ERROR: " << message << std::endl;
     } else {
-        g_critical("take_object: ERROR: %s", message);
+        g_critical("%sERROR: %s", messageTag().c_str(), message);
     }
 }
 
@@ -1683,53 +2909,53 @@ void take_object::warningMessage(const char *message)
 {
     if((!options.rtpCam) || (options.rtpNextGen))
     {
-        std::cout << "take_object: WARNING: " << message << std::endl;
+        std::cout << messageTag() << "WARNING: " << message << std::endl;
     } else {
-        g_message("take_object: WARNING: %s", message);
+        g_message("%sWARNING: %s", messageTag().c_str(), message);
     }
 }
 
 void take_object::statusMessage(const char *message)
 {
     if((!options.rtpCam) || (options.rtpNextGen)) {
-        std::cout << "take_object: STATUS: " << message << std::endl;
+        std::cout << messageTag() << "STATUS: " << message << std::endl;
     } else {
-        g_message("take_object: STATUS: %s", message);
+        g_message("%sSTATUS: %s", messageTag().c_str(), message);
     }
 }
 
 void take_object::errorMessage(const string message)
 {
     if((!options.rtpCam) || (options.rtpNextGen)) {
-        std::cerr << "take_object: ERROR: " << message << std::endl;
+        std::cerr << messageTag() << "ERROR: " << message << std::endl;
     } else {
-        g_error("take_object: ERROR: %s", message.c_str());
+        g_error("%sERROR: %s", messageTag().c_str(), message.c_str());
     }
 }
 
 void take_object::warningMessage(const string message)
 {
     if((!options.rtpCam) || (options.rtpNextGen)) {
-        std::cout << "take_object: WARNING: " << message << std::endl;
+        std::cout << messageTag() << "WARNING: " << message << std::endl;
     } else {
-        g_message("take_object: WARNING: %s", message.c_str());
+        g_message("%sWARNING: %s", messageTag().c_str(), message.c_str());
     }
 }
 
 void take_object::statusMessage(const string message)
 {
     if((!options.rtpCam) || (options.rtpNextGen)) {
-        std::cout << "take_object: STATUS: " << message << std::endl;
+        std::cout << messageTag() << "STATUS: " << message << std::endl;
     } else {
-        g_message("take_object: STATUS: %s", message.c_str());
+        g_message("%sSTATUS: %s", messageTag().c_str(), message.c_str());
     }
 }
 
 void take_object::statusMessage(std::ostringstream &message)
 {
     if((!options.rtpCam) || (options.rtpNextGen)) {
-        std::cout << "take_object: STATUS: " << message.str() << std::endl;
+        std::cout << messageTag() << "STATUS: " << message.str() << std::endl;
     } else {
-        g_message("take_object: STATUS: %s", message.str().c_str());
+        g_message("%sSTATUS: %s", messageTag().c_str(), message.str().c_str());
     }
 }
@@ -393,6 +393,13 @@ void XIOCamera::readLoop()
     LOG << ": finished readLoop(). is_reading must be false now: " << is_reading;
 }
 
+void XIOCamera::stop()
+{
+    // readLoop() returns once the file it is reading is done.
+    LOG << ": Stopping readLoop()";
+    is_reading = false;
+}
+
 uint16_t* XIOCamera::getFrame(CameraModel::camStatusEnum *stat)
 {
     // This seems to run constantly.
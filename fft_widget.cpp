@@ -87,10 +87,11 @@ void fft_widget::handleNewFrame()
      * \author Noah Levy
      * \author Jackie Ryan
      */
-    if(fw->curFrame == NULL)
+    frame_lease frame = fw->leaseCurFrame();
+    if(!frame)
         return;
 
-    if (!this->isHidden() && fw->curFrame->fftMagnitude != NULL) {
+    if (!this->isHidden() && frame->fftMagnitude != NULL) {
         double nyquist_freq = 50.0;
         switch (fw->to.getFFTtype()) {
         case PLANE_MEAN:
@@ -108,7 +109,7 @@ void fft_widget::handleNewFrame()
         for(unsigned int i = 0; i < FFT_INPUT_LENGTH / 2; i++)
             freq_bins[i] = increment * i;
 
-        float *fft_data_ptr = fw->curFrame->fftMagnitude;
+        float *fft_data_ptr = frame->fftMagnitude;
         for(unsigned int b = 0; b < FFT_INPUT_LENGTH / 2; b++)
             rfft_data_vec[b] = fft_data_ptr[b];
         if(zero_const_box.isChecked())
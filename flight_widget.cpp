@@ -49,7 +49,10 @@ flight_widget::flight_widget(frameWorker *fw, startupOptionsType options, QWidge
         // Simply comment out the widgets not desired.
     }
 
-    if(options.rtpCam)
+    if(options.syntheticCam)
+    {
+        updateLabel(flightDisplayElements.imageLabel, "Synthetic:");
+    } else if(options.rtpCam)
     {
         updateLabel(flightDisplayElements.imageLabel, "RTP Link:");
     } else if (options.xioCam) {
@@ -77,6 +77,18 @@ startupOptionsType frameWorker::getStartupOptions() {
 
 void frameWorker::useNewOptions(startupOptionsType newOpts)
 {
+    bool sourceChanged = (newOpts.xioCam != options.xioCam) || (newOpts.rtpCam != options.rtpCam) ||
+            (newOpts.rtpNextGen != options.rtpNextGen) || (newOpts.pdvUnit != options.pdvUnit) ||
+            (newOpts.pdvChannel != options.pdvChannel) || (newOpts.syntheticCam != options.syntheticCam);
+    if(sourceChanged)
+    {
+        // The capture thread holds frames, so it makes the switch, see captureFrames.
+        QMutexLocker locker(&reconfigureMutex);
+        pendingOptions = newOpts;
+        reconfigurePending = true;
+        return;
+    }
+
     this->options = newOpts;
     convertOptions();
     to.changeOptions(takeOptions);
@@ -89,6 +101,49 @@ void frameWorker::useNewOptions(startupOptionsType newOpts)
     }
 }
 
+void frameWorker::applyPendingReconfigure()
+{
+    /*! \brief Switch cuda_take to the source requested with useNewOptions.
+     * \paragraph
+     * Runs on the capture thread, which hands back the frames it holds first, see take_object::reconfigure().
+     * The widgets are laid out for the frame geometry found at startup, so a source with other dimensions is
+     * switched away from again, and needs a restart of Live View.
+     */
+    startupOptionsType newOpts;
+    {
+        QMutexLocker locker(&reconfigureMutex);
+        if(!reconfigurePending)
+            return;
+        reconfigurePending = false;
+        newOpts = pendingOptions;
+    }
+    replaceLeasedFrame(curFrame, NULL);
+    replaceLeasedFrame(std_dev_frame, NULL);
+    to.release(std_dev_processing_frame);
+    std_dev_processing_frame = NULL;
+
+    priorOptions = options;
+    options = newOpts;
+    convertOptions();
+    if(!to.reconfigure(takeOptions))
+    {
+        sMessage("Could not switch the camera source, see the log for the reason.");
+        options = priorOptions;
+        convertOptions();
+        return;
+    }
+    if((to.getFrameWidth() != frWidth) || (to.getDataHeight() != dataHeight))
+    {
+        sMessage(QString("The new source has %1x%2 frames, but the display is laid out for %3x%4. Restart Live View to use it. Switching back.")
+                 .arg(to.getFrameWidth()).arg(to.getDataHeight()).arg(frWidth).arg(dataHeight));
+        options = priorOptions;
+        convertOptions();
+        to.reconfigure(takeOptions);
+        return;
+    }
+    sMessage(QString("Switched the camera source in %1 ms.").arg(to.getLastSwitchMicros()/1000.0, 0, 'f', 1));
+}
+
 void frameWorker::convertOptions()
 {
     if(options.xioDirectoryArray != NULL)
@@ -116,6 +171,24 @@ void frameWorker::convertOptions()
     takeOptions.headless = options.headless;
     takeOptions.noGPU = options.noGPU;
     takeOptions.useSHM = options.useSHM;
+    takeOptions.shmName = options.shmName;
+    takeOptions.instanceName = options.instanceName;
+    takeOptions.pdvUnit = options.pdvUnit;
+    takeOptions.pdvChannel = options.pdvChannel;
+    takeOptions.pdvMultibufs = options.pdvMultibufs;
+    takeOptions.frameRingDepth = options.frameRingDepth;
+    takeOptions.productPoolDepth = options.productPoolDepth;
+    takeOptions.threadCpus = options.threadCpus;
+    takeOptions.threadPriorities = options.threadPriorities;
+    takeOptions.lockMemory = options.lockMemory;
+    takeOptions.graphThreads = options.graphThreads;
+    takeOptions.meansPolicy = options.meansPolicy;
+    takeOptions.stdDevPolicy = options.stdDevPolicy;
+    takeOptions.productEvery = options.productEvery;
+    takeOptions.meanHistory = options.meanHistory;
+    takeOptions.fftWindow = options.fftWindow;
+    takeOptions.hugePageSize = options.hugePageSize;
+    takeOptions.numaNode = options.numaNode;
     takeOptions.flightMode = options.flightMode;
     takeOptions.disableGPS = options.disableGPS;
     takeOptions.disableCamera = options.disableCamera;
@@ -127,6 +200,13 @@ void frameWorker::convertOptions()
     takeOptions.xioCam = options.xioCam;
     takeOptions.rtpCam = options.rtpCam;
     takeOptions.rtpNextGen = options.rtpNextGen;
+    takeOptions.syntheticCam = options.syntheticCam;
+    takeOptions.syntheticWidth = options.syntheticWidth;
+    takeOptions.syntheticHeight = options.syntheticHeight;
+    takeOptions.syntheticFPS = options.syntheticFPS;
+    takeOptions.syntheticPattern = options.syntheticPattern;
+    takeOptions.syntheticSigma = options.syntheticSigma;
+    takeOptions.syntheticDropEvery = options.syntheticDropEvery;
     if(options.rtpCam)
     {
         takeOptions.rtpHeight = options.rtpHeight;
@@ -209,9 +289,9 @@ void frameWorker::captureFrames()
      * \brief The backend communication with take object is handled for each frame in this loop.
      * \paragraph
      * This event loop determines which processing elements have been completed for a frame in cuda_take.
-     * First, all other events in the thread are completed, then the process sleeps for 50 microseconds to add wait time to the loop.
-     * The backend frame, workingFrame is incremented based on the framecount. The framecount indexes the cuda_take ring buffer data
-     * structure which contains 1500 arriving images from the camera link at a time.
+     * First, all other events in the thread are completed, then the process sleeps in take_object::waitForFrame until cuda_take
+     * announces that a new frame is ready. The backend frame, workingFrame, is then leased from the cuda_take ring buffer with
+     * take_object::acquireLatest(), so that the camera loops will not overwrite it while it is displayed.
      * \paragraph
      * Standard Deviation processing and Asynchronous processing are sent as signals from cuda_take. As cuda_take is a non-Qt project,
      * the signals are handled as status ints. If the asynchronous processing takes longer than a single loop through the backend, it
@@ -230,25 +310,34 @@ void frameWorker::captureFrames()
     unsigned int save_ct;
     frame_c *workingFrame;
     int microSecondsPerFrame = 0;
+    uint64_t frameSeq = 0;
     // int flags=1;
 
     while(doRun) {
         QCoreApplication::processEvents(QEventLoop::AllEvents, 1); // 1ms maximum delay permitted
-        usleep(50); //So that CPU utilization is not 100%
-        count = (to.count - 1) % CPU_FRAME_BUFFER_SIZE;
-        workingFrame = &to.frame_ring_buffer[count];
-        //workingFrame = &to.frame_ring_buffer[count % CPU_FRAME_BUFFER_SIZE];
+        applyPendingReconfigure();
+        // Sleep until a new frame is ready. The timeout keeps the
+        // events above flowing when frames stop arriving.
+        frameSeq = to.waitForFrame(frameSeq, 20);
+        if(frameSeq == 0)
+            continue;
+        count = frameSeq - 1;
+        workingFrame = to.acquireLatest();
+        if(workingFrame == NULL)
+            continue;
 
         if(std_dev_processing_frame != NULL) {
             if(std_dev_processing_frame->has_valid_std_dev == 2) {
-                std_dev_frame = std_dev_processing_frame;
+                replaceLeasedFrame(std_dev_frame, std_dev_processing_frame); // its lease moves along
+                std_dev_processing_frame = NULL;
             }
         }
         if(workingFrame->async_filtering_done != 0) {
-            curFrame = workingFrame;
-            if (curFrame->has_valid_std_dev == 1) {
-                std_dev_processing_frame = curFrame;
+            if ((workingFrame->has_valid_std_dev == 1) && workingFrame->lease()) {
+                to.release(std_dev_processing_frame);
+                std_dev_processing_frame = workingFrame;
             }
+            replaceLeasedFrame(curFrame, workingFrame);
             save_num = to.save_framenum.load(std::memory_order_relaxed);
             save_ct = to.save_count.load(std::memory_order_relaxed);
             if(save_ct != last_savect) {
@@ -280,15 +369,51 @@ void frameWorker::captureFrames()
             // This happens when the program is drawing the screen faster than the
             // frames arrive. It is generally not a problem.
             // sMessage("NOTE: Frame not updated.");
+            to.release(workingFrame);
         }
 
     }
+    replaceLeasedFrame(curFrame, NULL);
+    replaceLeasedFrame(std_dev_frame, NULL);
+    to.release(std_dev_processing_frame);
+    std_dev_processing_frame = NULL;
 #ifdef VERBOSE
     qDebug() << "emitting finished";
 #endif
     emit finished();
 }
 
+void frameWorker::replaceLeasedFrame(frame_c *&held, frame_c *frame)
+{
+    /*! \brief Swap a leased frame for another, already leased, frame and release the old one.
+     * The widgets may be leasing held at the same time, hence the lock. */
+    frame_c *old;
+    {
+        QMutexLocker locker(&leaseMutex);
+        old = held;
+        held = frame;
+    }
+    to.release(old);
+}
+
+frame_lease frameWorker::leaseCurFrame()
+{
+    /*! \brief An extra lease on the frame to render, or an empty lease if there is none yet. */
+    QMutexLocker locker(&leaseMutex);
+    if((curFrame != NULL) && curFrame->lease())
+        return frame_lease(curFrame);
+    return frame_lease();
+}
+
+frame_lease frameWorker::leaseStdDevFrame()
+{
+    /*! \brief An extra lease on the latest finished standard deviation frame, or an empty lease. */
+    QMutexLocker locker(&leaseMutex);
+    if((std_dev_frame != NULL) && std_dev_frame->lease())
+        return frame_lease(std_dev_frame);
+    return frame_lease();
+}
+
 void frameWorker::loadDarkFile(QString filename, fileFormat_t format)
 {
     if(format == fmt_float32)
@@ -15,6 +15,7 @@
 
 /* cuda_take includes */
 #include "take_object.hpp"
+#include "frame_lease.hpp"
 #include "frame_c_meta.h"
 #include "image_type.h"
 #include "startupOptions.h"
@@ -52,7 +53,14 @@ class frameWorker : public QObject
 {
     Q_OBJECT
 
+    // Each of these holds a lease from take_object, see frame_lease.hpp.
+    // curFrame and std_dev_frame are swapped under leaseMutex, since the
+    // widgets lease them from the GUI thread.
     frame_c *std_dev_processing_frame = NULL;
+    frame_c *curFrame  = NULL;
+    frame_c *std_dev_frame = NULL;
+    QMutex leaseMutex;
+    void replaceLeasedFrame(frame_c *&held, frame_c *frame);
 
     unsigned int dataHeight;
     unsigned int frHeight;
@@ -69,6 +77,13 @@ class frameWorker : public QObject
     void convertOptions(); // startup options to take options
     char xioDirectoryBuffer[4096] = {'\x0'};
 
+    // A source switch from useNewOptions, made by captureFrames:
+    QMutex reconfigureMutex;
+    bool reconfigurePending = false;
+    startupOptionsType pendingOptions;
+    startupOptionsType priorOptions;
+    void applyPendingReconfigure();
+
 public:
     explicit frameWorker(startupOptionsType options, QObject *parent = 0);
     virtual ~frameWorker();
@@ -77,8 +92,9 @@ public:
     camControlType *camcontrol= NULL;
     void setCameraPaused(bool isPaused);
 
-    frame_c *curFrame  = NULL;
-    frame_c *std_dev_frame = NULL;
+    // The frames to render. Hold the lease only while drawing.
+    frame_lease leaseCurFrame();
+    frame_lease leaseStdDevFrame();
 
     float delta;
     quint16 navgs = 1;
@@ -355,10 +355,11 @@ void frameview_widget::handleNewFrame()
      * \author Noah Levy
      */
 
-    if(fw->curFrame == NULL)
+    frame_lease frame = fw->leaseCurFrame(); // held until the frame is drawn
+    if(!frame)
         return;
 
-    if(fw->curFrame->image_data_ptr == NULL)
+    if(frame->image_data_ptr == NULL)
         return;
 
     if(image_type == WATERFALL)
@@ -370,8 +371,8 @@ void frameview_widget::handleNewFrame()
 
         wfSelectedRow.setText(QString("Row: %1").arg(fw->crosshair_y));
 
-        float *local_image_ptr = fw->curFrame->dark_subtracted_data;
-        uint16_t* local_image_ptr_uint = fw->curFrame->image_data_ptr;
+        float *local_image_ptr = frame->dark_subtracted_data;
+        uint16_t* local_image_ptr_uint = frame->image_data_ptr;
 
         std::vector <float> line;
         if(useDSF) {
@@ -408,12 +409,12 @@ void frameview_widget::handleNewFrame()
 
     }
 
-    if(!this->isHidden() && (fw->curFrame->image_data_ptr != NULL)) {
+    if(!this->isHidden() && (frame->image_data_ptr != NULL)) {
 
 
         if((image_type == DSF) || (image_type==BASE)) {
-            uint16_t* local_image_ptr_uint = fw->curFrame->image_data_ptr;
-            float* local_image_ptr_float = fw->curFrame->dark_subtracted_data;
+            uint16_t* local_image_ptr_uint = frame->image_data_ptr;
+            float* local_image_ptr_float = frame->dark_subtracted_data;
 
             if(useDSF)
             {
@@ -490,8 +491,9 @@ void frameview_widget::handleNewFrame()
             goto done_here;
         }
 
-        if(image_type == STD_DEV && fw->std_dev_frame != NULL) {
-            float * local_image_ptr = fw->std_dev_frame->std_dev_data;
+        frame_lease std_dev_frame = fw->leaseStdDevFrame();
+        if(image_type == STD_DEV && std_dev_frame) {
+            float * local_image_ptr = std_dev_frame->std_dev_data;
             for (int col = 0; col < frWidth; col++)
                 for (int row = 0; row < frHeight; row++)
                     // colorMap->data()->setCell(col, row, (double_t)local_image_ptr[(frHeight - row - 1) * frWidth + col]); // y-axis reversed
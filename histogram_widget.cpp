@@ -20,9 +20,6 @@ histogram_widget::histogram_widget(frameWorker *fw, QWidget *parent) :
 
     double penWidth = .064; //This value was derived to make the bars look the best in the 2-4 range
     histogram->setWidth(penWidth);
-    histogram->setName("Histogram of Standard Deviation per pixel");
-    const uint16_t sigma = 0x03C3;
-    qcp->xAxis->setLabel(QString::fromUtf16(&sigma, 1));
     qcp->yAxis->setLabel("Spatial Frequency");
 
     std::array<float,NUMBER_OF_BINS> histbinvals = getHistogramBinValues();
@@ -42,7 +39,21 @@ histogram_widget::histogram_widget(frameWorker *fw, QWidget *parent) :
     connect(histogram->keyAxis(), SIGNAL(rangeChanged(QCPRange)), this, SLOT(histogramScrolledX(QCPRange)));
     connect(histogram->valueAxis(), SIGNAL(rangeChanged(QCPRange)), this, SLOT(histogramScrolledY(QCPRange)));
 
+    stdDevButton = new QRadioButton("Standard Deviation", this);
+    stdDevButton->setChecked(true);
+    rawButton = new QRadioButton("Raw", this);
+    dsfButton = new QRadioButton("Dark Subtracted", this);
+    connect(stdDevButton, SIGNAL(clicked()), this, SLOT(updateSource()));
+    connect(rawButton, SIGNAL(clicked()), this, SLOT(updateSource()));
+    connect(dsfButton, SIGNAL(clicked()), this, SLOT(updateSource()));
+    sourceButtons.addWidget(stdDevButton);
+    sourceButtons.addWidget(rawButton);
+    sourceButtons.addWidget(dsfButton);
+    sourceButtons.addStretch();
+    updateSource();
+
     qvbl.addWidget(qcp);
+    qvbl.addLayout(&sourceButtons);
     this->setLayout(&qvbl);
 
     connect(&rendertimer, SIGNAL(timeout()), this, SLOT(handleNewFrame()));
@@ -69,10 +80,21 @@ void histogram_widget::handleNewFrame()
     /*! \brief Render the bars of histogram data
      * \paragraph
      *
-     * As the histogram relies on standard deviation data, it must use the std_dev_frame rather than the curFrame. */
-    if(!this->isHidden() && fw->std_dev_frame != NULL)
+     * The standard deviation histogram comes with the std_dev_frame rather than the curFrame. The raw and dark
+     * subtracted histograms are those of the curFrame, and are missing while the filters are off. */
+    frame_lease frame = (source == STD_DEV) ? fw->leaseStdDevFrame() : fw->leaseCurFrame();
+    uint32_t *histogram_data_ptr = NULL;
+    if(frame)
+    {
+        switch(source)
+        {
+        case BASE: histogram_data_ptr = frame->raw_histogram; break;
+        case DSF: histogram_data_ptr = frame->dark_histogram; break;
+        default: histogram_data_ptr = frame->std_dev_histogram; break;
+        }
+    }
+    if(!this->isHidden() && (histogram_data_ptr != NULL))
     {
-        uint32_t *histogram_data_ptr = fw->std_dev_frame->std_dev_histogram;
         for(unsigned int b = 0; b < NUMBER_OF_BINS;b++)
         {
             histo_data_vec[b] = histogram_data_ptr[b];
@@ -85,6 +107,26 @@ void histogram_widget::handleNewFrame()
     }
     count++;
 }
+void histogram_widget::updateSource()
+{
+    /*! \brief Switch to the histogram chosen with the buttons underneath the plot. */
+    if(rawButton->isChecked())
+    {
+        source = BASE;
+        histogram->setName("Histogram of raw value per pixel");
+        qcp->xAxis->setLabel("DN");
+    } else if(dsfButton->isChecked()) {
+        source = DSF;
+        histogram->setName("Histogram of dark subtracted value per pixel");
+        qcp->xAxis->setLabel("DN");
+    } else {
+        source = STD_DEV;
+        histogram->setName("Histogram of Standard Deviation per pixel");
+        const uint16_t sigma = 0x03C3;
+        qcp->xAxis->setLabel(QString::fromUtf16(&sigma, 1));
+    }
+    qcp->replot();
+}
 void histogram_widget::histogramScrolledY(const QCPRange &newRange)
 {
     /*! \brief Defines behavior for zooming the Y Axis of the histogram in and out.
@@ -4,6 +4,8 @@
 /* Qt includes */
 #include <QWidget>
 #include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QRadioButton>
 #include <QTimer>
 
 /* Live View includes */
@@ -11,18 +13,23 @@
 #include "frame_worker.h"
 #include "image_type.h"
 #include "std_dev_filter.hpp"
+#include "log_histogram.hpp"
 #include "settings.h"
 #include "startupOptions.h"
 #include "constants.h"
 
 /*! \file
- * \brief Plots a histogram of the spatial frequency of pixel standard deviations.
+ * \brief Plots a histogram of the spatial frequency of pixel standard deviations, raw values or dark subtracted values.
  * \paragraph
  *
  * The histogram displays the spacial frequency of the standard deviations calculated for the standard deviation frame.
  * Each bar represents a range of sigma (in DN) that the individual pixel sigmas are binned within. These data are plotted
  * with a logarithmic x-axis. Scrolling on the mouse wheel will zoom in and out. The standard viewing scale omits dead
  * pixel bars, but these can be viewed by zooming out.
+ * \paragraph
+ *
+ * The buttons underneath the plot switch to the histogram of the raw or the dark subtracted image of the current frame,
+ * over the same bins. cuda_take counts those for every frame it computes the mean profiles for, see log_histogram.hpp.
  * \author Noah Levy */
 
 class histogram_widget : public QWidget
@@ -35,6 +42,11 @@ class histogram_widget : public QWidget
 
     /*! GUI elements */
     QVBoxLayout qvbl;
+    QHBoxLayout sourceButtons;
+    QRadioButton *stdDevButton;
+    QRadioButton *rawButton;
+    QRadioButton *dsfButton;
+    image_t source = STD_DEV; // STD_DEV, BASE or DSF
 
     /*! Plot elements */
     QCustomPlot *qcp;
@@ -68,6 +80,8 @@ public slots:
     void handleNewFrame();
     /*! @} */
 
+    void updateSource();
+
     /*! \addtogroup plotfunc
      * @{ */
     void histogramScrolledY(const QCPRange &newRange);
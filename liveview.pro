@@ -45,6 +45,18 @@ SOURCES += main.cpp\
     profile_widget.cpp \
     pref_window.cpp \
     cuda_take/src/safestringset.cpp \
+    cuda_take/src/save_queue.cpp \
+    cuda_take/src/frame_conditioning.cpp \
+    cuda_take/src/pdv_sim.cpp \
+    cuda_take/src/frame_notifier.cpp \
+    cuda_take/src/latency_histogram.cpp \
+    cuda_take/src/frame_pool.cpp \
+    cuda_take/src/frame_memory.cpp \
+    cuda_take/src/frame_executor.cpp \
+    cuda_take/src/frame_metadata.cpp \
+    cuda_take/src/product_schedule.cpp \
+    cuda_take/src/log_histogram.cpp \
+    cuda_take/src/syntheticcamera.cpp \
     rgbadjustments.cpp \
     saveserver.cpp \
     playback_widget.cpp \
@@ -78,6 +90,21 @@ HEADERS  += mainwindow.h \
     rgbadjustments.h \
     rgbline.h \
     cuda_take/include/safestringset.h \
+    cuda_take/include/save_queue.hpp \
+    cuda_take/include/frame_conditioning.hpp \
+    cuda_take/include/pdv_device.h \
+    cuda_take/include/pdv_sim.h \
+    cuda_take/include/frame_notifier.hpp \
+    cuda_take/include/latency_histogram.hpp \
+    cuda_take/include/frame_pool.hpp \
+    cuda_take/include/frame_memory.hpp \
+    cuda_take/include/frame_lease.hpp \
+    cuda_take/include/frame_executor.hpp \
+    cuda_take/include/frame_metadata.hpp \
+    cuda_take/include/product_schedule.hpp \
+    cuda_take/include/log_histogram.hpp \
+    cuda_take/include/syntheticcamera.hpp \
+    cuda_take/include/remote_commands.h \
     settings.h \
     profile_widget.h \
     pref_window.h \
@@ -115,6 +142,7 @@ DISTFILES +=    cuda_take/include/take_object.hpp \
 DISTFILES +=    cuda_take/src/take_object.cpp \
                 cuda_take/src/std_dev_filter_device_code.cu \
                 cuda_take/src/std_dev_filter.cpp \
+                cuda_take/src/std_dev_filter_cpu.cpp \
                 cuda_take/src/mean_filter.cpp \
                 cuda_take/src/main.cpp \
                 cuda_take/src/fft.cpp \
@@ -166,9 +194,18 @@ QMAKE_POST_LINK += cp \"$$PWD/LiveView.desktop\" $$DESTDIR;
 #}
 #LIBS += -L$$PWD/lib/ -l$$QCPLIB
 
-unix:!macx:!symbian: LIBS += -L$$PWD/cuda_take/ -lcuda_take -lboost_thread -lboost_filesystem -L/usr/local/cuda/lib64 -lcudart -lgomp -lboost_system -ldl -lrt # -lGL -lQtOpenGL
+# Uncomment when cuda_take was built with HARDWARE=SIMULATED (no EDT frame grabber):
+#DEFINES += PDV_SIMULATOR
+# Uncomment when cuda_take was built with GPU=NONE (no CUDA toolkit):
+#DEFINES += CPU_ONLY
+
+unix:!macx:!symbian: LIBS += -L$$PWD/cuda_take/ -lcuda_take -lboost_thread -lboost_filesystem -lgomp -lboost_system -ldl -lrt # -lGL -lQtOpenGL
 INCLUDEPATH += $$PWD/cuda_take/include\
-/opt/EDTpdv /usr/local/cuda/include
+/opt/EDTpdv
+!contains(DEFINES, CPU_ONLY) {
+    unix:!macx:!symbian: LIBS += -L/usr/local/cuda/lib64 -lcudart
+    INCLUDEPATH += /usr/local/cuda/include
+}
 DEPENDPATH += $$PWD/cuda_take
 
 unix:!macx:!symbian: PRE_TARGETDEPS += $$PWD/cuda_take/libcuda_take.a
@@ -82,7 +82,32 @@ int main(int argc, char *argv[])
                                "--rtpwidth 1280 "
                                "--rtpaddress 1.2.3.4 "
                                "--rtpinterface eth2 "
+                               "--synthetic "
+                               "--synthetic-fps 1000 "
+                               "--synthetic-pattern ramp|noise "
+                               "--synthetic-sigma 20 "
+                               "--synthetic-width 1280 "
+                               "--synthetic-height 481 "
+                               "--synthetic-drop-every 0 "
                                "--er2 --headless "
+                               "--multibufs 64 "
+                               "--ring-depth 1500 "
+                               "--product-pool 64 "
+                               "--thread-cpus \"PDVCAM=2;SAVING=3\" "
+                               "--thread-rtprio \"PDVCAM=80\" "
+                               "--mlock "
+                               "--graph-threads 4 "
+                               "--means-rate every|nth|display "
+                               "--std-dev-rate every|nth|display "
+                               "--product-every 10 "
+                               "--mean-history 500 "
+                               "--fft-window rect|hann|hamming|blackman "
+                               "--hugepages 2M "
+                               "--numa-node 0 "
+                               "--shm-name /liveview_image "
+                               "--instance SWIR "
+                               "--pdv-unit 0 "
+                               "--pdv-channel 0 "
                                "--wfpreview "
                                "--wfpreviewcontinuous "
                                "--wfpreviewlocation /path/to/waterfallpreview/files/ "
@@ -159,6 +184,81 @@ int main(int argc, char *argv[])
             startupOptions.rtpNextGen = true;
         }
 
+        if(currentArg == "--synthetic") {
+            startupOptions.syntheticCam = true;
+        }
+        if(currentArg == "--synthetic-pattern")
+        {
+            if(argc > c+1)
+            {
+                QString patterntemp = QString(argv[c+1]).toLower();
+                if(patterntemp == "ramp") {
+                    startupOptions.syntheticPattern = 0;
+                } else if(patterntemp == "noise") {
+                    startupOptions.syntheticPattern = 1;
+                } else {
+                    std::cout << helptext.toStdString() << std::endl;
+                    exit(-1);
+                }
+                startupOptions.syntheticCam = true;
+                c++;
+            } else {
+                std::cout << helptext.toStdString() << std::endl;
+                exit(-1);
+            }
+        }
+        if( (currentArg == "--synthetic-fps") || (currentArg == "--synthetic-sigma") )
+        {
+            if(argc > c+1)
+            {
+                float synthtemp = 0;
+                bool ok = false;
+                synthtemp = QString(argv[c+1]).toFloat(&ok);
+                if(ok && (synthtemp > 0))
+                {
+                    if(currentArg == "--synthetic-fps")
+                        startupOptions.syntheticFPS = synthtemp;
+                    else
+                        startupOptions.syntheticSigma = synthtemp;
+                    startupOptions.syntheticCam = true;
+                    c++;
+                } else {
+                    std::cout << helptext.toStdString() << std::endl;
+                    exit(-1);
+                }
+            } else {
+                std::cout << helptext.toStdString() << std::endl;
+                exit(-1);
+            }
+        }
+        if( (currentArg == "--synthetic-width") || (currentArg == "--synthetic-height")
+                || (currentArg == "--synthetic-drop-every") )
+        {
+            if(argc > c+1)
+            {
+                unsigned int synthtemp = 0;
+                bool ok = false;
+                synthtemp = QString(argv[c+1]).toUInt(&ok);
+                if(ok && (synthtemp <= 0xffff) && ((synthtemp > 0) || (currentArg == "--synthetic-drop-every")))
+                {
+                    if(currentArg == "--synthetic-width")
+                        startupOptions.syntheticWidth = synthtemp;
+                    else if(currentArg == "--synthetic-height")
+                        startupOptions.syntheticHeight = synthtemp;
+                    else
+                        startupOptions.syntheticDropEvery = synthtemp;
+                    startupOptions.syntheticCam = true;
+                    c++;
+                } else {
+                    std::cout << helptext.toStdString() << std::endl;
+                    exit(-1);
+                }
+            } else {
+                std::cout << helptext.toStdString() << std::endl;
+                exit(-1);
+            }
+        }
+
         if(currentArg == "--rtprgb") {
             startupOptions.rtprgb = true;
         }
@@ -330,6 +430,241 @@ int main(int argc, char *argv[])
                 exit(-1);
             }
         }
+        if(currentArg == "--multibufs")
+        {
+            if(argc > c+1)
+            {
+                unsigned int multibufstemp = 0;
+                bool ok = false;
+                multibufstemp = QString(argv[c+1]).toUInt(&ok);
+                if(ok && (multibufstemp > 0))
+                {
+                    startupOptions.pdvMultibufs = multibufstemp;
+                    c++;
+                } else {
+                    std::cout << helptext.toStdString() << std::endl;
+                    exit(-1);
+                }
+            } else {
+                std::cout << helptext.toStdString() << std::endl;
+                exit(-1);
+            }
+        }
+        if(currentArg == "--ring-depth")
+        {
+            if(argc > c+1)
+            {
+                unsigned int ringdepthtemp = 0;
+                bool ok = false;
+                ringdepthtemp = QString(argv[c+1]).toUInt(&ok);
+                if(ok && (ringdepthtemp > 0))
+                {
+                    startupOptions.frameRingDepth = ringdepthtemp;
+                    c++;
+                } else {
+                    std::cout << helptext.toStdString() << std::endl;
+                    exit(-1);
+                }
+            } else {
+                std::cout << helptext.toStdString() << std::endl;
+                exit(-1);
+            }
+        }
+        if(currentArg == "--product-pool")
+        {
+            if(argc > c+1)
+            {
+                unsigned int pooldepthtemp = 0;
+                bool ok = false;
+                pooldepthtemp = QString(argv[c+1]).toUInt(&ok);
+                if(ok && (pooldepthtemp > 0))
+                {
+                    startupOptions.productPoolDepth = pooldepthtemp;
+                    c++;
+                } else {
+                    std::cout << helptext.toStdString() << std::endl;
+                    exit(-1);
+                }
+            } else {
+                std::cout << helptext.toStdString() << std::endl;
+                exit(-1);
+            }
+        }
+        if(currentArg == "--thread-cpus")
+        {
+            if(argc > c+1)
+            {
+                startupOptions.threadCpus = argv[c+1];
+                c++;
+            } else {
+                std::cout << helptext.toStdString() << std::endl;
+                exit(-1);
+            }
+        }
+        if(currentArg == "--thread-rtprio")
+        {
+            if(argc > c+1)
+            {
+                startupOptions.threadPriorities = argv[c+1];
+                c++;
+            } else {
+                std::cout << helptext.toStdString() << std::endl;
+                exit(-1);
+            }
+        }
+        if(currentArg == "--mlock") {
+            startupOptions.lockMemory = true;
+        }
+        if(currentArg == "--graph-threads")
+        {
+            if(argc > c+1)
+            {
+                unsigned int graphtemp = 0;
+                bool ok = false;
+                graphtemp = QString(argv[c+1]).toUInt(&ok);
+                if(ok)
+                {
+                    startupOptions.graphThreads = graphtemp;
+                    c++;
+                } else {
+                    std::cout << helptext.toStdString() << std::endl;
+                    exit(-1);
+                }
+            } else {
+                std::cout << helptext.toStdString() << std::endl;
+                exit(-1);
+            }
+        }
+        if((currentArg == "--means-rate") || (currentArg == "--std-dev-rate"))
+        {
+            if(argc > c+1)
+            {
+                QString ratetemp = QString(argv[c+1]).toLower();
+                unsigned int policy = 0;
+                if(ratetemp == "every") {
+                    policy = 0;
+                } else if(ratetemp == "nth") {
+                    policy = 1;
+                } else if(ratetemp == "display") {
+                    policy = 2;
+                } else {
+                    std::cout << helptext.toStdString() << std::endl;
+                    exit(-1);
+                }
+                if(currentArg == "--means-rate")
+                    startupOptions.meansPolicy = policy;
+                else
+                    startupOptions.stdDevPolicy = policy;
+                c++;
+            } else {
+                std::cout << helptext.toStdString() << std::endl;
+                exit(-1);
+            }
+        }
+        if(currentArg == "--product-every")
+        {
+            if(argc > c+1)
+            {
+                unsigned int everytemp = 0;
+                bool ok = false;
+                everytemp = QString(argv[c+1]).toUInt(&ok);
+                if(ok && (everytemp > 0))
+                {
+                    startupOptions.productEvery = everytemp;
+                    c++;
+                } else {
+                    std::cout << helptext.toStdString() << std::endl;
+                    exit(-1);
+                }
+            } else {
+                std::cout << helptext.toStdString() << std::endl;
+                exit(-1);
+            }
+        }
+        if(currentArg == "--mean-history")
+        {
+            if(argc > c+1)
+            {
+                unsigned int historytemp = 0;
+                bool ok = false;
+                historytemp = QString(argv[c+1]).toUInt(&ok);
+                if(ok && (historytemp > 0))
+                {
+                    startupOptions.meanHistory = historytemp;
+                    c++;
+                } else {
+                    std::cout << helptext.toStdString() << std::endl;
+                    exit(-1);
+                }
+            } else {
+                std::cout << helptext.toStdString() << std::endl;
+                exit(-1);
+            }
+        }
+        if(currentArg == "--fft-window")
+        {
+            if(argc > c+1)
+            {
+                QString windowtemp = QString(argv[c+1]).toLower();
+                if(windowtemp == "rect") {
+                    startupOptions.fftWindow = 0;
+                } else if(windowtemp == "hann") {
+                    startupOptions.fftWindow = 1;
+                } else if(windowtemp == "hamming") {
+                    startupOptions.fftWindow = 2;
+                } else if(windowtemp == "blackman") {
+                    startupOptions.fftWindow = 3;
+                } else {
+                    std::cout << helptext.toStdString() << std::endl;
+                    exit(-1);
+                }
+                c++;
+            } else {
+                std::cout << helptext.toStdString() << std::endl;
+                exit(-1);
+            }
+        }
+        if(currentArg == "--hugepages")
+        {
+            if(argc > c+1)
+            {
+                QString pagetemp = QString(argv[c+1]).toUpper();
+                if(pagetemp == "2M") {
+                    startupOptions.hugePageSize = 2;
+                } else if(pagetemp == "1G") {
+                    startupOptions.hugePageSize = 1024;
+                } else if(pagetemp == "OFF") {
+                    startupOptions.hugePageSize = 0;
+                } else {
+                    std::cout << helptext.toStdString() << std::endl;
+                    exit(-1);
+                }
+                c++;
+            } else {
+                std::cout << helptext.toStdString() << std::endl;
+                exit(-1);
+            }
+        }
+        if(currentArg == "--numa-node")
+        {
+            if(argc > c+1)
+            {
+                unsigned int nodetemp = 0;
+                bool ok = false;
+                nodetemp = QString(argv[c+1]).toUInt(&ok);
+                if(ok)
+                {
+                    startupOptions.numaNode = (int)nodetemp;
+                    c++;
+                } else {
+                    std::cout << helptext.toStdString() << std::endl;
+                    exit(-1);
+                }
+            } else {
+                std::cout << helptext.toStdString() << std::endl;
+                exit(-1);
+            }
+        }
         if(currentArg == "--laggy") {
             startupOptions.laggy = true;
             std::cout << "WARNING, laggy mode enabled." << std::endl;
@@ -376,6 +711,69 @@ int main(int argc, char *argv[])
         if( (currentArg == "--shm")) {
             startupOptions.useSHM = true;
         }
+        if(currentArg == "--shm-name")
+        {
+            if(argc > c+1)
+            {
+                startupOptions.shmName = argv[c+1];
+                startupOptions.useSHM = true;
+                c++;
+            } else {
+                std::cout << helptext.toStdString() << std::endl;
+                exit(-1);
+            }
+        }
+        if(currentArg == "--instance")
+        {
+            if(argc > c+1)
+            {
+                startupOptions.instanceName = argv[c+1];
+                c++;
+            } else {
+                std::cout << helptext.toStdString() << std::endl;
+                exit(-1);
+            }
+        }
+        if(currentArg == "--pdv-unit")
+        {
+            if(argc > c+1)
+            {
+                unsigned int unittemp = 0;
+                bool ok = false;
+                unittemp = QString(argv[c+1]).toUInt(&ok);
+                if(ok)
+                {
+                    startupOptions.pdvUnit = unittemp;
+                    c++;
+                } else {
+                    std::cout << helptext.toStdString() << std::endl;
+                    exit(-1);
+                }
+            } else {
+                std::cout << helptext.toStdString() << std::endl;
+                exit(-1);
+            }
+        }
+        if(currentArg == "--pdv-channel")
+        {
+            if(argc > c+1)
+            {
+                unsigned int channeltemp = 0;
+                bool ok = false;
+                channeltemp = QString(argv[c+1]).toUInt(&ok);
+                if(ok)
+                {
+                    startupOptions.pdvChannel = (int)channeltemp;
+                    c++;
+                } else {
+                    std::cout << helptext.toStdString() << std::endl;
+                    exit(-1);
+                }
+            } else {
+                std::cout << helptext.toStdString() << std::endl;
+                exit(-1);
+            }
+        }
 
         if( (currentArg == "--no-gpu") || (currentArg == "--nogpu") ) {
             startupOptions.noGPU = true;
@@ -436,6 +834,15 @@ int main(int argc, char *argv[])
         }
     }
 
+    if(startupOptions.syntheticCam)
+    {
+        startupOptions.xioCam = false;
+        startupOptions.rtpCam = false;
+        std::cout << "Synthetic camera: " << startupOptions.syntheticWidth << "x" << startupOptions.syntheticHeight
+                  << " " << (startupOptions.syntheticPattern ? "noise" : "ramp") << " frames at "
+                  << startupOptions.syntheticFPS << " FPS" << std::endl;
+    }
+
     if(startupOptions.flightMode && !startupOptions.dataLocationSet)
     {
         system("xmessage \"Error, flight mode requires --datastoragelocation\"");
@@ -165,7 +165,10 @@ MainWindow::MainWindow(startupOptionsType *optionsIn, QThread *qth, frameWorker
         handleMainWindowStatusMessage(QString("SaveServer Port: %1").arg(save_server->port));
     }
 
-    if(options->rtpCam) {
+    if(options->syntheticCam) {
+        controlbox->server_ip_label.setText("Synthetic frames");
+        handleMainWindowStatusMessage(QString("Camera: synthetic, %1 FPS").arg(options->syntheticFPS));
+    } else if(options->rtpCam) {
         if(options->rtpNextGen) {
             handleMainWindowStatusMessage("Camera: RTP NextGen");
         } else {
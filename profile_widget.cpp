@@ -193,7 +193,8 @@ void profile_widget::handleNewFrame()
      */
     float *local_image_ptr;
     bool isMeanProfile = itype == VERTICAL_MEAN || itype == HORIZONTAL_MEAN;
-    if (!this->isHidden() &&  fw->curFrame != NULL && ((fw->crosshair_x != -1 && fw->crosshair_y != -1) || isMeanProfile)) {
+    frame_lease frame = fw->leaseCurFrame();
+    if (!this->isHidden() &&  frame && ((fw->crosshair_x != -1 && fw->crosshair_y != -1) || isMeanProfile)) {
         allow_callouts = true;
 
         switch (itype)
@@ -201,19 +202,19 @@ void profile_widget::handleNewFrame()
         case VERTICAL_CROSS:
             // same as mean:
         case VERTICAL_MEAN:
-            local_image_ptr = fw->curFrame->vertical_mean_profile; // vertical profiles
+            local_image_ptr = frame->vertical_mean_profile; // vertical profiles
             for (int r = 0; r < frHeight; r++)
             {
                 y[r] = double(local_image_ptr[r]);
             }
             break;
         case VERT_OVERLAY:
-            local_image_ptr = fw->curFrame->vertical_mean_profile; // vertical profiles
+            local_image_ptr = frame->vertical_mean_profile; // vertical profiles
             for (int r = 0; r < frHeight; r++)
             {
                 y[r] = double(local_image_ptr[r]);
-                y_lh[r] = double(fw->curFrame->vertical_mean_profile_lh[r]);
-                y_rh[r] = double(fw->curFrame->vertical_mean_profile_rh[r]);
+                y_lh[r] = double(frame->vertical_mean_profile_lh[r]);
+                y_rh[r] = double(frame->vertical_mean_profile_rh[r]);
 
             }
             // display overlay
@@ -225,7 +226,7 @@ void profile_widget::handleNewFrame()
             // same as mean:
         case HORIZONTAL_MEAN:
 
-            local_image_ptr = fw->curFrame->horizontal_mean_profile; // horizontal profiles
+            local_image_ptr = frame->horizontal_mean_profile; // horizontal profiles
             for (int c = 0; c < frWidth; c++)
                 y[c] = double(local_image_ptr[c]);
             break;
@@ -170,12 +170,107 @@ void saveServer::readCommand()
                 out << QString("");
             else
                 out << fname;
+            // Frame counter continuity, appended so older clients may stop reading here:
+            frame_continuity_summary continuity = reference->to.getContinuity();
+            out << (quint64)continuity.checked;
+            out << (quint64)continuity.dropped;
+            out << (quint64)continuity.repeated;
+            out << (quint64)continuity.outOfOrder;
+            out << (quint64)continuity.gaps;
             out.device()->seek(0);
             out << (uint16_t)(block.size() - sizeof(quint16));
             //printHex(&block);
             clientConnection->write(block);
             break;
         }
+        case CMD_LATENCY_STATS:
+        {
+            // Reply: stage count, then for each stage its name, the number of
+            // frames recorded, and the p50, p99, p99.9 and max latency in microseconds.
+            genStatusMessage("Sending LATENCY_STATS information back.");
+            QByteArray block;
+            QDataStream out( &block, QIODevice::WriteOnly );
+            out.setVersion(QDataStream::Qt_4_0);
+            out << (uint16_t)0; // will be changed to the size of the message later.
+            out << (uint16_t)CMD_LATENCY_STATS;
+            out << (uint16_t)LATENCY_STAGE_COUNT;
+            for(int s = 0; s < LATENCY_STAGE_COUNT; s++)
+            {
+                latency_summary summary = reference->to.getStageLatency((latency_stage_t)s);
+                out << QString(latency_stage_name((latency_stage_t)s));
+                out << (quint64)summary.count;
+                out << (quint32)(summary.p50_ns / 1000);
+                out << (quint32)(summary.p99_ns / 1000);
+                out << (quint32)(summary.p999_ns / 1000);
+                out << (quint32)(summary.max_ns / 1000);
+            }
+            out.device()->seek(0);
+            out << (uint16_t)(block.size() - sizeof(quint16));
+            clientConnection->write(block);
+            break;
+        }
+        case CMD_CONTINUITY_STATS:
+        {
+            // Reply: frames checked, dropped, repeated, out of order, resyncs and gaps,
+            // then the number of recent gaps, and for each one its time (ms since epoch),
+            // liveview's frame count, the counter expected and received, and the frames missing.
+            genStatusMessage("Sending CONTINUITY_STATS information back.");
+            frame_continuity_summary continuity = reference->to.getContinuity();
+            frame_gap_t gaps[FRAME_GAP_HISTORY];
+            unsigned int gapCount = reference->to.getRecentFrameGaps(gaps, FRAME_GAP_HISTORY);
+            QByteArray block;
+            QDataStream out( &block, QIODevice::WriteOnly );
+            out.setVersion(QDataStream::Qt_4_0);
+            out << (uint16_t)0; // will be changed to the size of the message later.
+            out << (uint16_t)CMD_CONTINUITY_STATS;
+            out << (quint64)continuity.checked;
+            out << (quint64)continuity.dropped;
+            out << (quint64)continuity.repeated;
+            out << (quint64)continuity.outOfOrder;
+            out << (quint64)continuity.resyncs;
+            out << (quint64)continuity.gaps;
+            out << (uint16_t)gapCount;
+            for(unsigned int g = 0; g < gapCount; g++)
+            {
+                out << (quint64)gaps[g].time_ms;
+                out << (quint64)gaps[g].frame;
+                out << (uint16_t)gaps[g].expected;
+                out << (uint16_t)gaps[g].received;
+                out << (quint32)gaps[g].missing;
+            }
+            out.device()->seek(0);
+            out << (uint16_t)(block.size() - sizeof(quint16));
+            clientConnection->write(block);
+            break;
+        }
+        case CMD_MEAN_SPECTRUM:
+        {
+            // Argument: the points in each segment, 0 for MEAN_SPECTRUM_MAX_SEGMENT.
+            // Reply: the points in each segment, the segments averaged, the number
+            // of magnitudes, then each magnitude as a float. Magnitude k is at
+            // k/points of the frame rate, see take_object::getPlaneMeanSpectrum().
+            genStatusMessage("Sending MEAN_SPECTRUM information back.");
+            quint16 segment = 0;
+            in >> segment;
+            if((segment == 0) || (segment > MEAN_SPECTRUM_MAX_SEGMENT))
+                segment = MEAN_SPECTRUM_MAX_SEGMENT;
+            std::vector<float> magnitude;
+            quint32 segments = reference->to.getPlaneMeanSpectrum(segment & ~1u, magnitude);
+            QByteArray block;
+            QDataStream out( &block, QIODevice::WriteOnly );
+            out.setVersion(QDataStream::Qt_4_0);
+            out << (uint16_t)0; // will be changed to the size of the message later.
+            out << (uint16_t)CMD_MEAN_SPECTRUM;
+            out << (quint32)(2*magnitude.size());
+            out << segments;
+            out << (uint16_t)magnitude.size();
+            for(size_t k = 0; k < magnitude.size(); k++)
+                out << magnitude[k];
+            out.device()->seek(0);
+            out << (uint16_t)(block.size() - sizeof(quint16));
+            clientConnection->write(block);
+            break;
+        }
         case CMD_START_DARKSUB:
         {
             genStatusMessage("Client requested CMD_START_DARKSUB, starting dark collection.");
@@ -9,21 +9,14 @@
 #include <QMutex>
 
 #include "frame_worker.h"
-
-const quint16 CMD_START_SAVING = 2;
-const quint16 CMD_STATUS = 3;
-const quint16 CMD_STATUS_EXTENDED = 4;
-const quint16 CMD_START_DARKSUB = 5;
-const quint16 CMD_STOP_DARKSUB = 6;
-const quint16 CMD_START_FLIGHT_SAVING = 7;
-const quint16 CMD_STOP_SAVING = 8;
+#include "remote_commands.h"
 
 /*! \file
  *  \brief Establishes a server which can accept remote frame saving commands.
  *  \paragraph
  *
  *  The saveServer class processes incoming QTcpSockets and accepts messages in Tcp format as a QByteStream.
- *  There are message codes defined as macros in this header, where the command to start saving a finite number
+ *  The message codes are defined in remote_commands.h, shared with take_daemon's command_server, where the command to start saving a finite number
  *  of frames is specified by the message type 2. I didn't use an enum because I wanted the software to be sufficiently
  *  modular that if the client was not aware of these macros they could still send messages using the code. The quint16
  *  type was chosen because Qt offers cross-platform support for their internal types, allowing greater portability of any
@@ -43,11 +43,49 @@ struct startupOptionsType
     bool rtpNextGen = false;
     bool rtprgb = true;
 
+    // Frames made by SyntheticCamera, see cuda_take/include/syntheticcamera.hpp:
+    bool syntheticCam = false;
+    uint16_t syntheticWidth = 1280;
+    uint16_t syntheticHeight = 481;
+    float syntheticFPS = 1000;
+    int syntheticPattern = 0; // 0 for a ramp, 1 for gaussian noise
+    float syntheticSigma = 20; // of the noise
+    unsigned int syntheticDropEvery = 0; // drop one frame in every N on purpose, 0 for none
+
     bool er2mode = false;
     bool headless = false;
     bool noGPU = false;
 
     bool useSHM = false;
+    const char* shmName = NULL; // shared memory segment, NULL for "/liveview_image"
+
+    const char* instanceName = NULL; // tags the messages of this instance, e.g. "SWIR"
+    unsigned int pdvUnit = 0; // EDT board
+    int pdvChannel = -1; // -1 uses channel 0
+
+    unsigned int pdvMultibufs = 64;
+    unsigned int frameRingDepth = 1500; // frames kept in take_object's ring
+    unsigned int productPoolDepth = 64; // slots for each derived product (dark, profiles)
+
+    // Thread placement, as "NAME=value;NAME=value" using the pthread names
+    // (TAKE, PDVCAM, XIOCAM, READING, RTPNG Stream, RTPNG Consume, SAVING, STDDEV, ...)
+    const char* threadCpus = NULL; // e.g. "PDVCAM=2;SAVING=3-5"
+    const char* threadPriorities = NULL; // SCHED_FIFO priority, e.g. "PDVCAM=80"
+    bool lockMemory = false; // mlock the frame ring and save queue
+    unsigned int graphThreads = 0; // frame graph workers (GRAPH0, ...), 0 picks from the CPU count
+
+    // Which frames get the derived products, see cuda_take's product_schedule.hpp:
+    unsigned int meansPolicy = 0; // profiles and FFT: 0 every frame, 1 every n-th, 2 display rate
+    unsigned int stdDevPolicy = 0; // standard deviation, the same values
+    unsigned int productEvery = 0; // n of every n-th, 0 for the default
+
+    // Spectra of the profiles and plane means, see cuda_take's fft.hpp:
+    unsigned int meanHistory = 500; // frame means kept for the PLANE_MEAN spectra
+    unsigned int fftWindow = 0; // 0 rectangular, 1 Hann, 2 Hamming, 3 Blackman
+
+    // Frame memory placement, see frame_memory.hpp:
+    unsigned int hugePageSize = 0; // MiB per huge page: 0 for normal pages, 2 or 1024
+    int numaNode = -1; // -1 follows the CPUs of the acquisition thread, if pinned
 
     bool wfPreviewEnabled = false;
     bool wfPreviewContinuousMode = false;
@@ -22,6 +22,15 @@ class saveClient(QtCore.QObject):
         self.STATUS_CMD_EXTENDED = 4
         self.remoteFilename = str("")
 
+        #LATENCY_STATS COMMAND VARIABLES
+        self.LATENCY_STATS_CMD = 9
+
+        #CONTINUITY_STATS COMMAND VARIABLES
+        self.CONTINUITY_STATS_CMD = 10
+
+        #MEAN_SPECTRUM COMMAND VARIABLES
+        self.MEAN_SPECTRUM_CMD = 11
+
         #FRAME SAVE COMMAND VARIABLES
         self.FRSAVE_CMD = 2
         self.framesToSave = 0
@@ -116,6 +125,128 @@ class saveClient(QtCore.QObject):
         self.remoteFilename = inStream.readQString();
         return (self.framesLeft, self.fps, self.numAvgs_stat, self.remoteFilename);
 
+    def requestLatencyStats(self):
+        # Returns a list of (stage name, frames, p50, p99, p99.9, max),
+        # with the latencies in microseconds.
+        self.blockSize = 0
+        self.socket.abort()
+
+        block = QtCore.QByteArray()
+        commStream = QtCore.QDataStream(block, QtCore.QIODevice.WriteOnly)
+        commStream.setVersion(QtCore.QDataStream.Qt_4_0)
+        commStream.writeUInt16(0)
+        commStream.writeUInt16(self.LATENCY_STATS_CMD)
+        commStream.device().seek(0)
+        commStream.writeUInt16(block.count() - 2)
+        self.socket.connectToHost(self.ipAddress, self.portNumber)
+        self.socket.waitForConnected(10)
+        self.socket.write(block)
+        self.socket.waitForReadyRead()
+        inStream = QtCore.QDataStream(self.socket)
+        inStream.setVersion(QtCore.QDataStream.Qt_4_0)
+
+        if self.socket.bytesAvailable() < 2:
+            print("LVC: No Data Received...")
+            return
+        self.blockSize = inStream.readUInt16()
+        while self.socket.bytesAvailable() < self.blockSize:
+            if not self.socket.waitForReadyRead(1000):
+                print("LVC: Incomplete latency reply...")
+                return
+        inStream.readUInt16() # command echo
+        stageCount = inStream.readUInt16()
+        stages = []
+        for s in range(stageCount):
+            name = inStream.readQString()
+            frames = inStream.readUInt64()
+            p50 = inStream.readUInt32()
+            p99 = inStream.readUInt32()
+            p999 = inStream.readUInt32()
+            pmax = inStream.readUInt32()
+            stages.append((name, frames, p50, p99, p999, pmax))
+        return stages
+
+    def requestContinuityStats(self):
+        # Returns a dict of the frame counter totals (checked, dropped, repeated,
+        # outOfOrder, resyncs, gaps) and a list of the recent gaps as
+        # (time in ms since epoch, frame, expected, received, missing).
+        self.blockSize = 0
+        self.socket.abort()
+
+        block = QtCore.QByteArray()
+        commStream = QtCore.QDataStream(block, QtCore.QIODevice.WriteOnly)
+        commStream.setVersion(QtCore.QDataStream.Qt_4_0)
+        commStream.writeUInt16(0)
+        commStream.writeUInt16(self.CONTINUITY_STATS_CMD)
+        commStream.device().seek(0)
+        commStream.writeUInt16(block.count() - 2)
+        self.socket.connectToHost(self.ipAddress, self.portNumber)
+        self.socket.waitForConnected(10)
+        self.socket.write(block)
+        self.socket.waitForReadyRead()
+        inStream = QtCore.QDataStream(self.socket)
+        inStream.setVersion(QtCore.QDataStream.Qt_4_0)
+
+        if self.socket.bytesAvailable() < 2:
+            print("LVC: No Data Received...")
+            return
+        self.blockSize = inStream.readUInt16()
+        while self.socket.bytesAvailable() < self.blockSize:
+            if not self.socket.waitForReadyRead(1000):
+                print("LVC: Incomplete continuity reply...")
+                return
+        inStream.readUInt16() # command echo
+        totals = {}
+        for key in ("checked", "dropped", "repeated", "outOfOrder", "resyncs", "gaps"):
+            totals[key] = inStream.readUInt64()
+        gapCount = inStream.readUInt16()
+        gaps = []
+        for g in range(gapCount):
+            time_ms = inStream.readUInt64()
+            frame = inStream.readUInt64()
+            expected = inStream.readUInt16()
+            received = inStream.readUInt16()
+            missing = inStream.readUInt32()
+            gaps.append((time_ms, frame, expected, received, missing))
+        return (totals, gaps)
+
+    def requestMeanSpectrum(self, segment = 0):
+        # Returns (points, segments, magnitudes): Welch's spectrum of the frame
+        # means, averaged over segments of points each. magnitudes[k] is at
+        # k/points of the frame rate. segment 0 asks for the longest allowed.
+        self.blockSize = 0
+        self.socket.abort()
+
+        block = QtCore.QByteArray()
+        commStream = QtCore.QDataStream(block, QtCore.QIODevice.WriteOnly)
+        commStream.setVersion(QtCore.QDataStream.Qt_4_0)
+        commStream.writeUInt16(0)
+        commStream.writeUInt16(self.MEAN_SPECTRUM_CMD)
+        commStream.writeUInt16(segment)
+        commStream.device().seek(0)
+        commStream.writeUInt16(block.count() - 2)
+        self.socket.connectToHost(self.ipAddress, self.portNumber)
+        self.socket.waitForConnected(10)
+        self.socket.write(block)
+        self.socket.waitForReadyRead()
+        inStream = QtCore.QDataStream(self.socket)
+        inStream.setVersion(QtCore.QDataStream.Qt_4_0)
+
+        if self.socket.bytesAvailable() < 2:
+            print("LVC: No Data Received...")
+            return
+        self.blockSize = inStream.readUInt16()
+        while self.socket.bytesAvailable() < self.blockSize:
+            if not self.socket.waitForReadyRead(1000):
+                print("LVC: Incomplete spectrum reply...")
+                return
+        inStream.readUInt16() # command echo
+        points = inStream.readUInt32()
+        segments = inStream.readUInt32()
+        count = inStream.readUInt16()
+        magnitudes = [inStream.readFloat() for k in range(count)]
+        return (points, segments, magnitudes)
+
     def printError(self,socket_error):
         errors = {
             QtNetwork.QTcpSocket.HostNotFoundError:
@@ -294,14 +294,15 @@ void waterfall::addNewFrame()
     addingFrame.lock();
     float *local_image_ptr;
     uint16_t* local_image_ptr_uint16;
-    if(fw->curFrame == NULL)
+    frame_lease frame = fw->leaseCurFrame();
+    if(!frame)
     {
         addingFrame.unlock();
         return;
     }
 
-    local_image_ptr = fw->curFrame->dark_subtracted_data;
-    local_image_ptr_uint16 = fw->curFrame->image_data_ptr;
+    local_image_ptr = frame->dark_subtracted_data;
+    local_image_ptr_uint16 = frame->image_data_ptr;
 
     rgbLine *line = wflines[currentWFLine];
 